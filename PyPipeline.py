@@ -0,0 +1,159 @@
+'''Build PluMA pipelines in Python and run them on the native scheduler.
+
+Rather than writing a config file and running pluma on it:
+
+    from PyPipeline import Pipeline
+
+    pipeline = Pipeline(workers=4, memory='16G')
+    trim = pipeline.step('Trim', 'reads.fq', 'trimmed.fq')
+    pipeline.step('Align', 'align.params', 'aligned.bam', memory='8G', time='2h')
+    with pipeline.parallel():
+        pipeline.step('Stats', 'aligned.bam', 'stats.txt')
+        pipeline.step('Plot', 'plot.params', 'plot.png')
+    result = pipeline.run()
+    for failure in result.failed:
+        print(failure.name, failure.exit_code)
+
+Steps run in the order they were added, as the lines of a config do: each
+step waits for the one before it, and the steps of a parallel() block wait
+for the step before the block but not for each other. Pipeline(dag=True)
+instead orders steps only by the files they share, as pluma --dag does.
+In either mode, after= makes a step also wait for other steps or blocks.
+
+run() executes the pipeline in this process on the native ParallelScheduler,
+each plugin in a worker forked from it, all sharing one budget, and returns
+its SchedulerResult: completed, failed and skipped lists of PluginResults
+(name, task_index, exit_code, elapsed_seconds, peak_rss), where task_index
+is the index of the step. The plugins and language runtimes are loaded by
+the first run and kept, so a sweep over thousands of pipelines pays for
+them once.
+'''
+import PyPluMAEngine as native
+
+_engine = None
+
+def engine(pluginpath=''):
+    '''The process's Engine, loading the plugins in pluginpath (by default
+    ./plugins and $PLUMA_PLUGIN_PATH) the first time it is called'''
+    global _engine
+    if _engine is None:
+        _engine = native.Engine(pluginpath)
+    return _engine
+
+def _value(value):
+    '''An option or hint as a config file spells it'''
+    if value is True:
+        return 'yes'
+    if value is False:
+        return 'no'
+    return str(value)
+
+class Step(object):
+    '''One Plugin line of a Pipeline; pass it to after= to wait for it'''
+    def __init__(self, pipeline, index, task):
+        self.pipeline = pipeline
+        self.index = index
+        self.task = task
+
+    def __repr__(self):
+        return 'Step(%d, %s)' % (self.index, self.task.name)
+
+class Block(object):
+    '''The steps of a parallel() block; pass it to after= to wait for all of them'''
+    def __init__(self, pipeline):
+        self.pipeline = pipeline
+        self.steps = []
+
+    def __enter__(self):
+        if self.pipeline._block is not None:
+            raise ValueError('parallel() blocks do not nest')
+        self.pipeline._block = self
+        self.pipeline._stages.append(self.steps)
+        return self
+
+    def __exit__(self, *exc):
+        self.pipeline._block = None
+        return False
+
+class Pipeline(object):
+    '''Steps and the order they run in.
+
+    options: the budget and failure handling of the run, as for pluma --dag
+    (workers, memory, gpu, fail, order, backfill), e.g. workers=8,
+    memory='32G', fail='continue'. prefix: a directory the steps' relative
+    paths are in, as a config's Prefix line.
+    '''
+    def __init__(self, dag=False, prefix='', **options):
+        self.dag = dag
+        self.prefix = prefix + '/' if prefix else ''
+        self.options = options
+        self.steps = []
+        self._stages = []   # step lists: one per step outside a block, one per block
+        self._after = []    # extra dependencies of each step, by index
+        self._block = None
+
+    def step(self, name, inputfile, outputfile, after=(), **hints):
+        '''Adds a plugin run. hints are those of a Plugin line: memory='4G',
+        gpu=1, time='30m', cache=False, intermediate=True. after: steps or
+        blocks that must complete first, besides those the mode implies.'''
+        line = 'Plugin %s inputfile %s outputfile %s' % (name, inputfile, outputfile)
+        for key in sorted(hints):
+            line += ' %s=%s' % (key, _value(hints[key]))
+        if len(line.split()) != 6 + len(hints):
+            raise ValueError('plugin names, paths and hints cannot contain spaces: ' + line)
+        step = Step(self, len(self.steps), native.parse_plugin_task(line, self.prefix))
+        self.steps.append(step)
+        self._after.append(self._indices(after))
+        if self._block is not None:
+            self._block.steps.append(step)
+        else:
+            self._stages.append([step])
+        return step
+
+    def parallel(self):
+        '''A block of steps that do not wait for each other:
+
+            with pipeline.parallel() as block:
+                pipeline.step(...)
+        '''
+        return Block(self)
+
+    def _indices(self, after):
+        if isinstance(after, (Step, Block)):
+            after = [after]
+        indices = []
+        for item in after:
+            steps = item.steps if isinstance(item, Block) else [item]
+            for step in steps:
+                if step.pipeline is not self:
+                    raise ValueError('%r is a step of another pipeline' % step)
+                indices.append(step.index)
+        return indices
+
+    def graph(self):
+        '''The native TaskGraph run() executes'''
+        tasks = [step.task for step in self.steps]
+        if self.dag:
+            inferred = native.build_task_graph(native.TaskVector(tasks)).dependencies
+            dependencies = [set(inferred[i]) for i in range(len(tasks))]
+        else:
+            dependencies = [set() for step in self.steps]
+            previous = []
+            for stage in self._stages:
+                for step in stage:
+                    dependencies[step.index].update(s.index for s in previous)
+                if stage:
+                    previous = stage
+        for i in range(len(tasks)):
+            dependencies[i].update(self._after[i])
+        graph = native.TaskGraph()
+        graph.tasks = native.TaskVector(tasks)
+        graph.dependencies = native.DependencyVector([native.IndexVector(sorted(d)) for d in dependencies])
+        return graph
+
+    def run(self, **options):
+        '''Runs the pipeline in this process and returns its SchedulerResult
+        once every step has ended. options override the pipeline's.'''
+        merged = dict(self.options)
+        merged.update(options)
+        return engine().run(self.graph(), dict((k, _value(v)) for k, v in merged.items()))
@@ -0,0 +1,237 @@
+#include "CacheStore.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace parallel {
+
+namespace fs = std::filesystem;
+
+static const char* ENTRY_MAGIC = "pluma-entry-v1\n";
+
+// ---------------------------------------------------------------------------
+// DirectoryStore
+// ---------------------------------------------------------------------------
+
+DirectoryStore::DirectoryStore(const std::string& root)
+    : root_(root)
+{
+    std::error_code ec;
+    fs::create_directories(root_, ec);
+}
+
+std::string DirectoryStore::entry_path(const std::string& key) const {
+    return (fs::path(root_) / key.substr(0, 2) / key).string();
+}
+
+bool DirectoryStore::contains(const std::string& key) const {
+    std::error_code ec;
+    return fs::is_directory(entry_path(key), ec);
+}
+
+std::string DirectoryStore::make_staging() const {
+    static std::atomic<unsigned> counter(0);
+    char host[256] = "localhost";
+    gethostname(host, sizeof(host) - 1);
+    fs::path staging = fs::path(root_) /
+        (".tmp." + std::string(host) + "." + std::to_string(getpid()) + "." + std::to_string(counter++));
+    std::error_code ec;
+    fs::remove_all(staging, ec);
+    fs::create_directories(staging, ec);
+    return staging.string();
+}
+
+bool DirectoryStore::commit(const std::string& key, const std::string& staging) const {
+    std::error_code ec;
+    fs::path entry = entry_path(key);
+    fs::create_directories(entry.parent_path(), ec);
+    fs::rename(staging, entry, ec);
+    if (ec) {
+        // Another writer published the same entry first; theirs is as good as ours.
+        fs::remove_all(staging, ec);
+        return fs::is_directory(entry, ec);
+    }
+    return true;
+}
+
+bool DirectoryStore::fetch(const std::string& key, const std::string& dest) {
+    std::error_code ec;
+    fs::path entry = entry_path(key);
+    if (!fs::is_directory(entry, ec)) return false;
+    fs::create_directories(dest, ec);
+    fs::copy(entry, dest, fs::copy_options::recursive | fs::copy_options::overwrite_existing, ec);
+    return !ec;
+}
+
+bool DirectoryStore::publish(const std::string& key, const std::string& source_dir) {
+    if (contains(key)) return true;
+    std::string staging = make_staging();
+    std::error_code ec;
+    fs::copy(source_dir, staging, fs::copy_options::recursive, ec);
+    if (ec) {
+        fs::remove_all(staging, ec);
+        return false;
+    }
+    return commit(key, staging);
+}
+
+// ---------------------------------------------------------------------------
+// Entry serialization: magic, then per file "<size> <relative path>\n<bytes>"
+// ---------------------------------------------------------------------------
+
+std::string pack_entry(const std::string& dir) {
+    std::vector<fs::path> files;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec)) files.push_back(it->path());
+    }
+    std::sort(files.begin(), files.end());
+
+    std::string out = ENTRY_MAGIC;
+    for (const auto& f : files) {
+        std::ifstream in(f, std::ios::binary);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        std::string bytes = contents.str();
+        out += std::to_string(bytes.size()) + " " + f.lexically_relative(dir).generic_string() + "\n";
+        out += bytes;
+    }
+    return out;
+}
+
+bool unpack_entry(const std::string& data, const std::string& dest) {
+    std::string magic = ENTRY_MAGIC;
+    if (data.compare(0, magic.size(), magic) != 0) return false;
+
+    std::error_code ec;
+    fs::create_directories(dest, ec);
+    size_t pos = magic.size();
+    while (pos < data.size()) {
+        size_t eol = data.find('\n', pos);
+        if (eol == std::string::npos) return false;
+        std::string header = data.substr(pos, eol - pos);
+        size_t space = header.find(' ');
+        if (space == std::string::npos) return false;
+
+        size_t size;
+        try { size = std::stoull(header.substr(0, space)); }
+        catch (...) { return false; }
+        fs::path rel = fs::path(header.substr(space + 1)).lexically_normal();
+        if (rel.empty() || rel.is_absolute() || *rel.begin() == "..") return false;
+
+        pos = eol + 1;
+        if (size > data.size() - pos) return false;
+
+        fs::path target = fs::path(dest) / rel;
+        fs::create_directories(target.parent_path(), ec);
+        std::ofstream out(target, std::ios::binary | std::ios::trunc);
+        out.write(data.data() + pos, static_cast<std::streamsize>(size));
+        if (!out) return false;
+        pos += size;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// HttpStore
+// ---------------------------------------------------------------------------
+
+HttpStore::HttpStore(const std::string& url, int timeout_seconds)
+    : url_(url), port_("80"), path_("/"), timeout_seconds_(timeout_seconds)
+{
+    std::string rest = url;
+    const std::string scheme = "http://";
+    if (rest.compare(0, scheme.size(), scheme) == 0) rest = rest.substr(scheme.size());
+
+    size_t slash = rest.find('/');
+    std::string authority = rest.substr(0, slash);
+    if (slash != std::string::npos) path_ = rest.substr(slash);
+    if (path_.empty() || path_.back() != '/') path_ += "/";
+
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos) {
+        host_ = authority.substr(0, colon);
+        port_ = authority.substr(colon + 1);
+    } else {
+        host_ = authority;
+    }
+}
+
+// One HTTP/1.0 exchange; the server closes the connection after responding.
+bool HttpStore::request(const std::string& method, const std::string& key,
+                        const std::string& body, int& status, std::string& response) const {
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addrs = nullptr;
+    if (getaddrinfo(host_.c_str(), port_.c_str(), &hints, &addrs) != 0) return false;
+
+    int fd = -1;
+    for (struct addrinfo* a = addrs; a; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        struct timeval tv = {timeout_seconds_, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (connect(fd, a->ai_addr, a->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addrs);
+    if (fd < 0) return false;
+
+    std::string req = method + " " + path_ + key + " HTTP/1.0\r\n" +
+                      "Host: " + host_ + "\r\n" +
+                      "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+                      "Connection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < req.size()) {
+        ssize_t n = send(fd, req.data() + sent, req.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            close(fd);
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+
+    std::string raw;
+    char buf[65536];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) raw.append(buf, static_cast<size_t>(n));
+    close(fd);
+    if (n < 0) return false;
+
+    size_t header_end = raw.find("\r\n\r\n");
+    if (header_end == std::string::npos || raw.compare(0, 5, "HTTP/") != 0) return false;
+    size_t sp = raw.find(' ');
+    try { status = std::stoi(raw.substr(sp + 1, 3)); }
+    catch (...) { return false; }
+    response = raw.substr(header_end + 4);
+    return true;
+}
+
+bool HttpStore::fetch(const std::string& key, const std::string& dest) {
+    int status = 0;
+    std::string body;
+    if (!request("GET", key, "", status, body) || status != 200) return false;
+    return unpack_entry(body, dest);
+}
+
+bool HttpStore::publish(const std::string& key, const std::string& source_dir) {
+    int status = 0;
+    std::string body;
+    if (!request("PUT", key, pack_entry(source_dir), status, body)) return false;
+    return status >= 200 && status < 300;
+}
+
+} // namespace parallel
@@ -0,0 +1,77 @@
+#ifndef CACHE_STORE_H
+#define CACHE_STORE_H
+
+#include <string>
+
+namespace parallel {
+
+// Backend holding plugin cache entries. An entry is a directory of output
+// files addressed by a PluginCache key; stores only move whole entries.
+class CacheStore {
+public:
+    virtual ~CacheStore() {}
+
+    // Fills the (empty or missing) directory dest with the entry; false on a miss.
+    virtual bool fetch(const std::string& key, const std::string& dest) = 0;
+
+    // Makes the entry in source_dir available under key. Readers must never
+    // see a partially published entry.
+    virtual bool publish(const std::string& key, const std::string& source_dir) = 0;
+
+    virtual std::string describe() const = 0;
+};
+
+// Entries under <root>/<key[0:2]>/<key>. Works for a local cache directory
+// and for a directory shared between hosts (e.g. over NFS): entries are
+// staged under a host- and process-unique name and published by rename.
+class DirectoryStore : public CacheStore {
+public:
+    explicit DirectoryStore(const std::string& root);
+
+    bool fetch(const std::string& key, const std::string& dest) override;
+    bool publish(const std::string& key, const std::string& source_dir) override;
+    std::string describe() const override { return root_; }
+
+    bool contains(const std::string& key) const;
+    std::string entry_path(const std::string& key) const;
+
+    // A fresh directory on the same filesystem as the entries, and the
+    // rename that turns it into entry `key`. commit() consumes the staging
+    // directory whether or not it wins the race to publish.
+    std::string make_staging() const;
+    bool commit(const std::string& key, const std::string& staging) const;
+
+private:
+    std::string root_;
+};
+
+// Entries on an HTTP server: GET <base>/<key> fetches one (404 is a miss) and
+// PUT <base>/<key> uploads one, serialized with pack_entry(). Any server that
+// stores PUT bodies and serves them back works, e.g. nginx with WebDAV.
+class HttpStore : public CacheStore {
+public:
+    explicit HttpStore(const std::string& url, int timeout_seconds = 30);
+
+    bool fetch(const std::string& key, const std::string& dest) override;
+    bool publish(const std::string& key, const std::string& source_dir) override;
+    std::string describe() const override { return url_; }
+
+private:
+    bool request(const std::string& method, const std::string& key,
+                 const std::string& body, int& status, std::string& response) const;
+
+    std::string url_;
+    std::string host_;
+    std::string port_;
+    std::string path_;
+    int timeout_seconds_;
+};
+
+// Serializes the regular files under dir (relative names and contents) into
+// one buffer, and back. unpack_entry rejects names that escape dest.
+std::string pack_entry(const std::string& dir);
+bool unpack_entry(const std::string& data, const std::string& dest);
+
+} // namespace parallel
+
+#endif
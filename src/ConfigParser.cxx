@@ -22,6 +22,10 @@ static std::vector<std::string> tokenize(const std::string& line) {
     return tokens;
 }
 
+static bool is_absolute(const std::string& path) {
+    return !path.empty() && (path[0] == '/' || path[0] == '\\');
+}
+
 size_t parse_size(const std::string& s) {
     if (s.empty()) throw std::invalid_argument("empty size string");
 
@@ -57,6 +61,32 @@ size_t parse_size(const std::string& s) {
     return static_cast<size_t>(val) * multiplier;
 }
 
+double parse_duration(const std::string& s) {
+    if (s.empty()) throw std::invalid_argument("empty duration string");
+
+    double multiplier = 1;
+    std::string num_part = s;
+    switch (std::tolower(static_cast<unsigned char>(s.back()))) {
+        case 's': multiplier = 1; break;
+        case 'm': multiplier = 60; break;
+        case 'h': multiplier = 3600; break;
+        case 'd': multiplier = 86400; break;
+        default:
+            if (!std::isdigit(static_cast<unsigned char>(s.back()))) throw std::invalid_argument("unknown duration suffix: " + s);
+            num_part += "s";
+    }
+    num_part.pop_back();
+    if (num_part.empty()) throw std::invalid_argument("no numeric part: " + s);
+
+    size_t pos;
+    double val;
+    try { val = std::stod(num_part, &pos); }
+    catch (...) { throw std::invalid_argument("invalid duration: " + s); }
+    if (pos != num_part.size()) throw std::invalid_argument("invalid duration: " + s);
+    if (val < 0) throw std::invalid_argument("negative duration: " + s);
+    return val * multiplier;
+}
+
 ParallelBlockOptions parse_parallel_options(const std::string& line) {
     ParallelBlockOptions opts;
     auto tokens = tokenize(line);
@@ -73,6 +103,8 @@ ParallelBlockOptions parse_parallel_options(const std::string& line) {
             else if (key == "memory") opts.memory = parse_size(val);
             else if (key == "gpu")    opts.gpu = std::stoi(val);
             else if (key == "fail")   opts.fail_mode = (val == "continue") ? FailMode::Continue : FailMode::Fast;
+            else if (key == "order")  opts.order = (val == "config") ? DispatchOrder::Config : DispatchOrder::Longest;
+            else if (key == "backfill") opts.backfill = !(val == "no" || val == "off" || val == "false");
         } catch (const std::exception&) {
             // malformed value — skip this option, keep defaults
         }
@@ -80,12 +112,32 @@ ParallelBlockOptions parse_parallel_options(const std::string& line) {
     return opts;
 }
 
+// key=value resource hints that may trail a Plugin or Pipeline line.
+static void parse_task_hints(const std::vector<std::string>& tokens, size_t first, PluginTask& task) {
+    for (size_t i = first; i < tokens.size(); i++) {
+        auto eq = tokens[i].find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = tokens[i].substr(0, eq);
+        std::string val = tokens[i].substr(eq + 1);
+
+        try {
+            if (key == "memory")    task.memory_hint = parse_size(val);
+            else if (key == "gpu")  task.gpu_hint = std::stoi(val);
+            else if (key == "cache") task.cacheable = !(val == "no" || val == "off" || val == "false");
+            else if (key == "time") task.expected_seconds = parse_duration(val);
+            else if (key == "intermediate") task.intermediate = (val == "yes" || val == "on" || val == "true");
+        } catch (const std::exception&) {
+        }
+    }
+}
+
 PluginTask parse_plugin_task(const std::string& line, const std::string& prefix) {
     PluginTask task;
     auto tokens = tokenize(line);
     if (tokens.size() < 6) return task;
 
     task.name = tokens[1];
+    task.prefix = prefix;
 
     std::string input_raw, output_raw;
     for (size_t i = 2; i < tokens.size(); i++) {
@@ -96,32 +148,38 @@ PluginTask parse_plugin_task(const std::string& line, const std::string& prefix)
         }
     }
 
-    task.inputfile  = (!input_raw.empty() && input_raw[0] == '/') ? input_raw : prefix + input_raw;
-    task.outputfile = (!output_raw.empty() && output_raw[0] == '/') ? output_raw : prefix + output_raw;
+    task.inputfile  = is_absolute(input_raw)  ? input_raw  : prefix + input_raw;
+    task.outputfile = is_absolute(output_raw) ? output_raw : prefix + output_raw;
 
-    for (size_t i = 2; i < tokens.size(); i++) {
-        auto eq = tokens[i].find('=');
-        if (eq == std::string::npos) continue;
-        std::string key = tokens[i].substr(0, eq);
-        std::string val = tokens[i].substr(eq + 1);
+    parse_task_hints(tokens, 2, task);
+    return task;
+}
 
-        try {
-            if (key == "memory")    task.memory_hint = parse_size(val);
-            else if (key == "gpu")  task.gpu_hint = std::stoi(val);
-        } catch (const std::exception&) {
-        }
-    }
+PluginTask parse_kitty_task(const std::string& line, const std::string& kitty, const std::string& prefix) {
+    PluginTask task;
+    auto tokens = tokenize(line);
+    if (tokens.size() < 2) return task;
+
+    task.name = kitty;
+    task.inputfile = tokens[1];   // Pipeline paths are not prefixed
+    task.prefix = prefix;
+    parse_task_hints(tokens, 2, task);
     return task;
 }
 
-ParseResult parse_config(std::istream& input) {
+ParseResult parse_config(std::istream& input, const std::string& initial_prefix) {
     ParseResult result;
     std::string line;
     int line_num = 0;
-    std::string prefix;
+    std::string prefix = initial_prefix;
+    std::string base_prefix = initial_prefix;  // prefix that Kitty directives extend
     bool in_parallel = false;
     ParallelBlock current_block;
     int parallel_start_line = 0;
+    bool in_sweep = false;
+    SweepBlock current_sweep;
+    bool in_scatter = false;
+    ScatterBlock current_scatter;
 
     while (std::getline(input, line)) {
         line_num++;
@@ -133,6 +191,146 @@ ParseResult parse_config(std::istream& input) {
         if (tokens.empty()) continue;
         auto keyword = tokens[0];
 
+        if (keyword == "Sweep") {
+            if (in_sweep) {
+                result.errors.push_back({line_num, "nested Sweep blocks are not allowed"});
+                continue;
+            }
+            if (in_scatter) {
+                result.errors.push_back({line_num, "Sweep directive not allowed inside Scatter block"});
+                continue;
+            }
+            if (in_parallel) {
+                result.errors.push_back({line_num, "Sweep directive not allowed inside Parallel block"});
+                continue;
+            }
+            in_sweep = true;
+            current_sweep = {};
+            current_sweep.source_line = line_num;
+            current_sweep.prefix = prefix;
+            current_sweep.options = parse_parallel_options(trimmed);
+            for (size_t i = 1; i < tokens.size(); i++) {
+                auto eq = tokens[i].find('=');
+                if (eq == std::string::npos) continue;
+                std::string key = tokens[i].substr(0, eq);
+                std::string val = tokens[i].substr(eq + 1);
+                if (val.empty()) continue;
+                if (key == "samples")   current_sweep.samples = is_absolute(val) ? val : prefix + val;
+                else if (key == "glob") current_sweep.pattern = is_absolute(val) ? val : prefix + val;
+            }
+            if (current_sweep.samples.empty() == current_sweep.pattern.empty()) {
+                result.errors.push_back({line_num, "Sweep needs exactly one of samples=FILE or glob=PATTERN"});
+            }
+            continue;
+        }
+
+        if (keyword == "EndSweep") {
+            if (!in_sweep) {
+                result.errors.push_back({line_num, "EndSweep without matching Sweep"});
+                continue;
+            }
+            in_sweep = false;
+            if (current_sweep.plugin_line.empty()) {
+                result.errors.push_back({current_sweep.source_line, "Sweep block has no Plugin line"});
+                continue;
+            }
+            ConfigStep step;
+            step.kind = ConfigStepKind::Sweep;
+            step.sweep = std::move(current_sweep);
+            result.steps.push_back(std::move(step));
+            continue;
+        }
+
+        if (in_sweep) {
+            if (keyword != "Plugin") {
+                result.errors.push_back({line_num, keyword + " directive not allowed inside Sweep block"});
+            } else if (!current_sweep.plugin_line.empty()) {
+                result.errors.push_back({line_num, "Sweep block may hold only one Plugin line"});
+            } else if (trimmed.find("{sample}") == std::string::npos &&
+                       trimmed.find("{path}") == std::string::npos) {
+                result.errors.push_back({line_num, "Plugin line in Sweep block uses neither {sample} nor {path}"});
+            } else {
+                current_sweep.plugin_line = trimmed;
+                current_sweep.plugin_source_line = line_num;
+            }
+            continue;
+        }
+
+        if (keyword == "Scatter") {
+            if (in_scatter) {
+                result.errors.push_back({line_num, "nested Scatter blocks are not allowed"});
+                continue;
+            }
+            if (in_parallel) {
+                result.errors.push_back({line_num, "Scatter directive not allowed inside Parallel block"});
+                continue;
+            }
+            in_scatter = true;
+            current_scatter = {};
+            current_scatter.source_line = line_num;
+            current_scatter.prefix = prefix;
+            current_scatter.options = parse_parallel_options(trimmed);
+            for (size_t i = 1; i < tokens.size(); i++) {
+                auto eq = tokens[i].find('=');
+                if (eq == std::string::npos) continue;
+                std::string key = tokens[i].substr(0, eq);
+                std::string val = tokens[i].substr(eq + 1);
+                try {
+                    if (key == "shards")      current_scatter.shards = std::stoi(val);
+                    else if (key == "record") current_scatter.record_lines = std::stoi(val);
+                    else if (key == "header") current_scatter.header_lines = std::stoi(val);
+                    else if (key == "gather" && !val.empty()) current_scatter.gather = val;
+                    else if (key == "by") {
+                        if (val == "lines")        current_scatter.unit = ShardUnit::Lines;
+                        else if (val == "records") current_scatter.unit = ShardUnit::Records;
+                        else if (val == "bytes")   current_scatter.unit = ShardUnit::Bytes;
+                        else result.errors.push_back({line_num, "Scatter by= must be lines, records or bytes"});
+                    }
+                } catch (const std::exception&) {
+                    result.errors.push_back({line_num, "invalid Scatter option " + tokens[i]});
+                }
+            }
+            if (current_scatter.shards < 1) {
+                result.errors.push_back({line_num, "Scatter needs shards=N with N at least 1"});
+            }
+            if (current_scatter.record_lines < 1 || current_scatter.header_lines < 0) {
+                result.errors.push_back({line_num, "Scatter record= must be at least 1 and header= not negative"});
+            }
+            if (current_scatter.unit == ShardUnit::Bytes && current_scatter.header_lines > 0) {
+                result.errors.push_back({line_num, "Scatter header= needs by=lines or by=records"});
+            }
+            continue;
+        }
+
+        if (keyword == "EndScatter") {
+            if (!in_scatter) {
+                result.errors.push_back({line_num, "EndScatter without matching Scatter"});
+                continue;
+            }
+            in_scatter = false;
+            if (current_scatter.plugin_line.empty()) {
+                result.errors.push_back({current_scatter.source_line, "Scatter block has no Plugin line"});
+                continue;
+            }
+            ConfigStep step;
+            step.kind = ConfigStepKind::Scatter;
+            step.scatter = std::move(current_scatter);
+            result.steps.push_back(std::move(step));
+            continue;
+        }
+
+        if (in_scatter) {
+            if (keyword != "Plugin") {
+                result.errors.push_back({line_num, keyword + " directive not allowed inside Scatter block"});
+            } else if (!current_scatter.plugin_line.empty()) {
+                result.errors.push_back({line_num, "Scatter block may hold only one Plugin line"});
+            } else {
+                current_scatter.plugin_line = trimmed;
+                current_scatter.plugin_source_line = line_num;
+            }
+            continue;
+        }
+
         if (keyword == "Parallel") {
             if (in_parallel) {
                 result.errors.push_back({line_num, "nested Parallel blocks are not allowed"});
@@ -174,24 +372,36 @@ ParseResult parse_config(std::istream& input) {
             }
             if (keyword == "Plugin") {
                 current_block.tasks.push_back(parse_plugin_task(trimmed, prefix));
+                current_block.tasks.back().source_line = line_num;
             }
             continue;
         }
 
         if (keyword == "Prefix" && tokens.size() > 1) {
             prefix = tokens[1] + "/";
+            base_prefix = prefix;
+        } else if (keyword == "Kitty" && tokens.size() > 1) {
+            prefix = base_prefix + "/" + tokens[1] + "/";
         }
 
         ConfigStep step;
         step.kind = ConfigStepKind::Sequential;
         step.sequential.keyword = keyword;
         step.sequential.raw_line = trimmed;
+        step.sequential.prefix = prefix;
+        step.sequential.source_line = line_num;
         result.steps.push_back(std::move(step));
     }
 
     if (in_parallel) {
         result.errors.push_back({parallel_start_line, "missing EndParallel for Parallel block"});
     }
+    if (in_sweep) {
+        result.errors.push_back({current_sweep.source_line, "missing EndSweep for Sweep block"});
+    }
+    if (in_scatter) {
+        result.errors.push_back({current_scatter.source_line, "missing EndScatter for Scatter block"});
+    }
 
     return result;
 }
@@ -10,11 +10,19 @@ namespace parallel {
 
 size_t parse_size(const std::string& s);
 
+// Seconds in "90", "90s", "45m", "3h" or "1.5d".
+double parse_duration(const std::string& s);
+
 ParallelBlockOptions parse_parallel_options(const std::string& line);
 
 PluginTask parse_plugin_task(const std::string& line, const std::string& prefix);
 
-ParseResult parse_config(std::istream& input);
+// A Kitty's "Pipeline file [memory=SIZE gpu=N time=DURATION]" line between LitterLaunch and
+// LitterGather, as one schedulable task: name is the Kitty, inputfile the
+// pipeline config, prefix the Kitty's prefix.
+PluginTask parse_kitty_task(const std::string& line, const std::string& kitty, const std::string& prefix);
+
+ParseResult parse_config(std::istream& input, const std::string& prefix = "");
 
 std::vector<std::string> validate_parallel_block(const ParallelBlock& block);
 
@@ -0,0 +1,535 @@
+#include "Daemon.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pwd.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+static const char* EXIT_LINE = "[PluMA] Exit: ";
+
+// Tabs and newlines separate fields and lines on the wire.
+static std::string escape(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '\\') out += "\\\\";
+        else if (s[i] == '\t') out += "\\t";
+        else if (s[i] == '\n') out += "\\n";
+        else out += s[i];
+    }
+    return out;
+}
+
+static std::string unescape(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] != '\\' || i + 1 == s.size()) { out += s[i]; continue; }
+        char c = s[++i];
+        out += (c == 't') ? '\t' : (c == 'n') ? '\n' : c;
+    }
+    return out;
+}
+
+std::string encodeSubmission(const Submission& submission) {
+    std::string out = "cwd\t" + escape(submission.cwd) + "\n";
+    for (size_t i = 0; i < submission.args.size(); i++)
+        out += "arg\t" + escape(submission.args[i]) + "\n";
+    for (std::map<std::string, std::string>::const_iterator it = submission.flags.begin(); it != submission.flags.end(); it++)
+        out += "flag\t" + escape(it->first) + "\t" + escape(it->second) + "\n";
+    return out + "end\n";
+}
+
+bool decodeSubmission(const std::string& text, Submission& submission) {
+    submission = Submission();
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line == "end") return !submission.cwd.empty();
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos) return false;
+        std::string kind = line.substr(0, tab), rest = line.substr(tab + 1);
+        if (kind == "cwd") submission.cwd = unescape(rest);
+        else if (kind == "arg") submission.args.push_back(unescape(rest));
+        else if (kind == "flag") {
+            size_t sep = rest.find('\t');
+            if (sep == std::string::npos) return false;
+            submission.flags[unescape(rest.substr(0, sep))] = unescape(rest.substr(sep + 1));
+        }
+        else return false;
+    }
+    return false;
+}
+
+static bool socketAddress(const std::string& path, struct sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    strcpy(addr.sun_path, path.c_str());
+    return true;
+}
+
+static int connectTo(const std::string& path) {
+    struct sockaddr_un addr;
+    if (!socketAddress(path, addr)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool writeAll(int fd, const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+std::string Daemon::defaultSocket() {
+    const char* env = getenv("PLUMA_SOCKET");
+    if (env && *env) return env;
+    std::stringstream ss;
+    ss << "/tmp/pluma-" << getuid() << ".sock";
+    return ss.str();
+}
+
+Daemon::~Daemon() {
+    if (myListenFd >= 0) {
+        close(myListenFd);
+        unlink(mySocketPath.c_str());
+    }
+}
+
+void Daemon::setBudget(const parallel::ParallelBlockOptions& budget, const std::map<std::string, double>& weights) {
+    myShare.reset(new parallel::FairShare(parallel::resolve_defaults(budget), weights));
+}
+
+bool Daemon::listen(bool shared) {
+    struct sockaddr_un addr;
+    if (!socketAddress(mySocketPath, addr)) {
+        myError = "socket path too long: " + mySocketPath;
+        return false;
+    }
+    int existing = connectTo(mySocketPath);
+    if (existing >= 0) {
+        close(existing);
+        myError = "a daemon is already listening on " + mySocketPath;
+        return false;
+    }
+    unlink(mySocketPath.c_str());
+
+    myListenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (myListenFd < 0) {
+        myError = std::string("cannot create socket: ") + strerror(errno);
+        return false;
+    }
+    fcntl(myListenFd, F_SETFD, FD_CLOEXEC);
+    mode_t old = umask(shared ? 007 : 077);
+    int rc = bind(myListenFd, (struct sockaddr*) &addr, sizeof(addr));
+    umask(old);
+    if (rc != 0 || ::listen(myListenFd, 64) != 0) {
+        myError = "cannot listen on " + mySocketPath + ": " + strerror(errno);
+        close(myListenFd);
+        myListenFd = -1;
+        return false;
+    }
+    return true;
+}
+
+// SIGCHLD and SIGTERM/SIGINT wake the serve loop through a self-pipe.
+static int wakeFds[2] = {-1, -1};
+static volatile sig_atomic_t stopping = 0;
+
+static void onChild(int) {
+    int saved = errno;
+    if (write(wakeFds[1], "c", 1) < 0) {}
+    errno = saved;
+}
+
+static void onStop(int) {
+    stopping = 1;
+    onChild(0);
+}
+
+// How long a connection may take to send its request.
+static const double REQUEST_SECONDS = 5.0;
+
+// Reads what a non-blocking connection has sent of its request so far: a
+// submission up to its "end" line, or a one-line "lease" or "tenants"
+// request. Returns true while more is to come, false once the request is
+// complete or never will be (closed, failed or too long).
+static bool requestIncomplete(int fd, std::string& text) {
+    char buf[4096];
+    while (text.size() < (1 << 20)) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (n <= 0) return false;
+        text.append(buf, n);
+        if (text.find('\n') != std::string::npos && (text.compare(0, 6, "lease\t") == 0 || text == "tenants\n"))
+            return false;
+        if (text.compare(0, 4, "end\n") == 0 || text.find("\nend\n") != std::string::npos)
+            return false;
+    }
+    return false;
+}
+
+// The user on the other end of a connection; empty if unknown.
+static std::string peerUser(int fd) {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) return "";
+    struct passwd* pw = getpwuid(cred.uid);
+    if (pw) return pw->pw_name;
+    std::stringstream ss;
+    ss << cred.uid;
+    return ss.str();
+}
+
+// A submission's tenant: the submitting user, or "user/label" for
+// --tenant=label, so that no client can spend another user's share.
+static std::string confineTenant(const std::string& user, const std::string& label) {
+    if (label.empty() || label == user) return user;
+    return user + "/" + label;
+}
+
+// An unguessable name for a run, which the leases its plugins take quote
+// to be charged to its tenant; empty if no random bytes could be read.
+static std::string newSession() {
+    unsigned char bytes[16];
+    int fd = open("/dev/urandom", O_RDONLY);
+    ssize_t n = fd >= 0 ? read(fd, bytes, sizeof(bytes)) : -1;
+    if (fd >= 0) close(fd);
+    if (n != static_cast<ssize_t>(sizeof(bytes))) return "";
+    char hex[2 * sizeof(bytes) + 1];
+    for (size_t i = 0; i < sizeof(bytes); i++) snprintf(hex + 2 * i, 3, "%02x", bytes[i]);
+    return hex;
+}
+
+// "lease\tSESSION\tNAME\tMEMORY\tGPU\tSECONDS"
+static bool decodeLease(const std::string& text, std::string& session, parallel::PluginTask& task) {
+    std::vector<std::string> fields;
+    std::istringstream in(text.substr(0, text.find('\n')));
+    std::string field;
+    while (std::getline(in, field, '\t')) fields.push_back(unescape(field));
+    if (fields.size() != 6 || fields[1].empty()) return false;
+    session = fields[1];
+    task.name = fields[2];
+    task.memory_hint = strtoull(fields[3].c_str(), NULL, 10);
+    task.gpu_hint = atoi(fields[4].c_str());
+    task.expected_seconds = atof(fields[5].c_str());
+    return true;
+}
+
+void Daemon::serve(Runner run) {
+    if (myListenFd < 0) return;
+    if (pipe(wakeFds) != 0) return;
+    fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+
+    struct sigaction sa = {}, oldChild, oldTerm, oldInt;
+    sa.sa_handler = onChild;
+    sigaction(SIGCHLD, &sa, &oldChild);
+    sa.sa_handler = onStop;
+    sigaction(SIGTERM, &sa, &oldTerm);
+    sigaction(SIGINT, &sa, &oldInt);
+    signal(SIGPIPE, SIG_IGN);
+    stopping = 0;
+
+    if (!myShare) setBudget(parallel::ParallelBlockOptions(), std::map<std::string, double>());
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    auto clock = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count(); };
+
+    std::map<pid_t, int> sessions;   // running submission -> its connection
+    // A lease is charged to the tenant of the run whose session it quotes,
+    // never to one the connection names: the runs are the daemon's own
+    // children, so its peer credentials would be the daemon's.
+    std::map<pid_t, std::string> sessionIds;
+    std::map<std::string, std::string> sessionTenants;
+    auto finish = [&](pid_t pid, int status) {
+        int code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        std::stringstream ss;
+        ss << EXIT_LINE << code << "\n";
+        writeAll(sessions[pid], ss.str());
+        close(sessions[pid]);
+        sessions.erase(pid);
+        sessionTenants.erase(sessionIds[pid]);
+        sessionIds.erase(pid);
+    };
+
+    std::map<uint64_t, int> leases;  // FairShare request -> the connection holding it
+    uint64_t nextLease = 0;
+    auto grantLeases = [&]() {
+        std::vector<uint64_t> granted = myShare->grant(clock());
+        for (size_t i = 0; i < granted.size(); i++) writeAll(leases[granted[i]], "grant\n");
+    };
+
+    // Connections still sending their request wait in the poll set, so a
+    // slow client holds up no other.
+    struct Request {
+        std::string text;
+        double since;
+    };
+    std::map<int, Request> requests;
+
+    // Answers a complete request on conn: "tenants" and a denied lease at
+    // once; a granted lease keeps the connection, and a submission runs in
+    // a child with the connection as its stdout and stderr, under the
+    // tenant of the user who sent it.
+    auto answer = [&](int conn, const std::string& text) {
+        if (text == "tenants\n") {
+            writeAll(conn, parallel::format_usage(myShare->usage(clock()), myShare->budget()));
+            close(conn);
+            return;
+        }
+        if (text.compare(0, 6, "lease\t") == 0) {
+            std::string session;
+            parallel::PluginTask task;
+            if (!decodeLease(text, session, task) || !sessionTenants.count(session)) {
+                writeAll(conn, "unknown\n");
+                close(conn);
+                return;
+            }
+            if (!myShare->request(nextLease, sessionTenants[session], task, clock())) {
+                writeAll(conn, "deny\n");
+                close(conn);
+                return;
+            }
+            leases[nextLease++] = conn;
+            grantLeases();
+            return;
+        }
+        Submission submission;
+        if (!decodeSubmission(text, submission)) {
+            writeAll(conn, "[PluMA] Error: malformed submission\n" + std::string(EXIT_LINE) + "1\n");
+            close(conn);
+            return;
+        }
+        std::string user = peerUser(conn);
+        std::string session = newSession();
+        if (user.empty() || session.empty()) {
+            writeAll(conn, "[PluMA] Error: cannot identify the submitting user\n" + std::string(EXIT_LINE) + "1\n");
+            close(conn);
+            return;
+        }
+        submission.flags["tenant"] = confineTenant(user, submission.flags["tenant"]);
+        submission.flags["session"] = session;
+        myShare->add_run(submission.flags["tenant"]);
+
+        std::cout.flush();
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            sigaction(SIGCHLD, &oldChild, NULL);
+            sigaction(SIGTERM, &oldTerm, NULL);
+            sigaction(SIGINT, &oldInt, NULL);
+            signal(SIGPIPE, SIG_DFL);
+            close(wakeFds[0]);
+            close(wakeFds[1]);
+            close(myListenFd);
+            for (std::map<pid_t, int>::iterator it = sessions.begin(); it != sessions.end(); it++) close(it->second);
+            for (std::map<uint64_t, int>::iterator it = leases.begin(); it != leases.end(); it++) close(it->second);
+            for (std::map<int, Request>::iterator it = requests.begin(); it != requests.end(); it++) close(it->first);
+            dup2(conn, STDOUT_FILENO);
+            dup2(conn, STDERR_FILENO);
+            close(conn);
+            if (chdir(submission.cwd.c_str()) != 0) {
+                std::cout << "[PluMA] Error: cannot change to directory " << submission.cwd << std::endl;
+                _exit(1);
+            }
+            int code = run(submission);
+            std::cout.flush();
+            fflush(stdout);
+            _exit(code);
+        }
+        if (pid < 0) {
+            writeAll(conn, "[PluMA] Error: cannot start run\n" + std::string(EXIT_LINE) + "1\n");
+            close(conn);
+            return;
+        }
+        sessions[pid] = conn;
+        sessionIds[pid] = session;
+        sessionTenants[session] = submission.flags["tenant"];
+    };
+
+    while (!stopping) {
+        std::vector<struct pollfd> fds = {{myListenFd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+        std::vector<uint64_t> polled;
+        for (std::map<uint64_t, int>::iterator it = leases.begin(); it != leases.end(); it++) {
+            fds.push_back({it->second, POLLIN, 0});
+            polled.push_back(it->first);
+        }
+        int timeout = -1;
+        for (std::map<int, Request>::iterator it = requests.begin(); it != requests.end(); it++) {
+            fds.push_back({it->first, POLLIN, 0});
+            int left = static_cast<int>((it->second.since + REQUEST_SECONDS - clock()) * 1000) + 1;
+            if (timeout < 0 || left < timeout) timeout = std::max(left, 0);
+        }
+        if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) break;
+
+        char drain[64];
+        while (read(wakeFds[0], drain, sizeof(drain)) > 0) {}
+        int status;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+            if (sessions.count(pid)) finish(pid, status);
+
+        // A lease ends when its holder closes the connection, which it
+        // does on exit however it exits.
+        bool released = false;
+        for (size_t i = 2; i < 2 + polled.size(); i++) {
+            if (!fds[i].revents) continue;
+            ssize_t n = read(fds[i].fd, drain, sizeof(drain));
+            if (n > 0 || (n < 0 && errno == EINTR)) continue;
+            myShare->release(polled[i - 2], clock());
+            close(fds[i].fd);
+            leases.erase(polled[i - 2]);
+            released = true;
+        }
+        if (released) grantLeases();
+        if (stopping) continue;
+
+        if (fds[0].revents & POLLIN) {
+            int conn = accept(myListenFd, NULL, NULL);
+            if (conn >= 0) {
+                fcntl(conn, F_SETFL, fcntl(conn, F_GETFL) | O_NONBLOCK);
+                requests[conn] = Request{"", clock()};
+            }
+        }
+
+        // Requests complete, or that never will be, are answered; one that
+        // took too long is answered with what it sent, as malformed.
+        std::vector<std::pair<int, std::string>> complete;
+        for (std::map<int, Request>::iterator it = requests.begin(); it != requests.end();) {
+            if (!requestIncomplete(it->first, it->second.text) || clock() - it->second.since > REQUEST_SECONDS) {
+                complete.push_back(std::make_pair(it->first, it->second.text));
+                it = requests.erase(it);
+            }
+            else it++;
+        }
+        for (size_t i = 0; i < complete.size(); i++) {
+            int conn = complete[i].first;
+            fcntl(conn, F_SETFL, fcntl(conn, F_GETFL) & ~O_NONBLOCK);
+            answer(conn, complete[i].second);
+        }
+    }
+
+    for (std::map<pid_t, int>::iterator it = sessions.begin(); it != sessions.end(); it++)
+        kill(it->first, SIGTERM);
+    while (!sessions.empty()) {
+        int status = 0;
+        pid_t pid = waitpid(sessions.begin()->first, &status, 0);
+        if (pid < 0 && errno == EINTR) continue;
+        finish(sessions.begin()->first, status);
+    }
+    for (std::map<uint64_t, int>::iterator it = leases.begin(); it != leases.end(); it++) close(it->second);
+    for (std::map<int, Request>::iterator it = requests.begin(); it != requests.end(); it++) close(it->first);
+
+    sigaction(SIGCHLD, &oldChild, NULL);
+    sigaction(SIGTERM, &oldTerm, NULL);
+    sigaction(SIGINT, &oldInt, NULL);
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+    close(myListenFd);
+    myListenFd = -1;
+    unlink(mySocketPath.c_str());
+}
+
+int submitToDaemon(const std::string& socketPath, const Submission& submission, std::ostream& out) {
+    int fd = connectTo(socketPath);
+    if (fd < 0) return -1;
+    if (!writeAll(fd, encodeSubmission(submission))) {
+        close(fd);
+        return -1;
+    }
+
+    // Output is passed on line by line; the last line is the exit status.
+    int code = -1;
+    std::string pending;
+    char buf[4096];
+    const size_t exitLen = strlen(EXIT_LINE);
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(buf, n);
+        size_t nl;
+        while ((nl = pending.find('\n')) != std::string::npos) {
+            std::string line = pending.substr(0, nl);
+            pending.erase(0, nl + 1);
+            if (line.compare(0, exitLen, EXIT_LINE) == 0) code = atoi(line.c_str() + exitLen);
+            else out << line << std::endl;
+        }
+    }
+    if (!pending.empty()) out << pending << std::endl;
+    close(fd);
+    if (code < 0) {
+        out << "[PluMA] Error: lost the connection to the daemon" << std::endl;
+        code = 1;
+    }
+    return code;
+}
+
+bool requestTenantUsage(const std::string& socketPath, std::ostream& out) {
+    int fd = connectTo(socketPath);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, "tenants\n");
+    char buf[4096];
+    for (ssize_t n; ok && ((n = read(fd, buf, sizeof(buf))) > 0 || (n < 0 && errno == EINTR));)
+        if (n > 0) out.write(buf, n);
+    close(fd);
+    return ok;
+}
+
+DaemonLease::DaemonLease(const std::string& socketPath, const std::string& session, const parallel::PluginTask& task)
+    : myFd(connectTo(socketPath))
+{
+    if (myFd < 0) {
+        myError = "cannot reach the daemon at " + socketPath;
+        return;
+    }
+    // Plugins that start programs must not hand the lease on to them.
+    fcntl(myFd, F_SETFD, FD_CLOEXEC);
+    std::stringstream request;
+    request << "lease\t" << escape(session) << "\t" << escape(task.name) << "\t" << task.memory_hint
+            << "\t" << task.gpu_hint << "\t" << task.expected_seconds << "\n";
+    if (!writeAll(myFd, request.str())) {
+        myError = "lost the connection to the daemon";
+        return;
+    }
+
+    struct pollfd pfd = {myFd, POLLIN, 0};
+    if (poll(&pfd, 1, 100) == 0)
+        std::cout << "[PluMA] Waiting for Resources: " << task.name << std::endl;
+    std::string reply;
+    char c;
+    for (ssize_t n; reply.find('\n') == std::string::npos && ((n = read(myFd, &c, 1)) > 0 || (n < 0 && errno == EINTR));)
+        if (n > 0) reply += c;
+    if (reply == "deny\n") myError = "plugin " + task.name + " needs more than the daemon's whole budget";
+    else if (reply == "unknown\n") myError = "the daemon is running no run with this session";
+    else if (reply != "grant\n") myError = "lost the connection to the daemon";
+}
+
+DaemonLease::~DaemonLease() {
+    if (myFd >= 0) close(myFd);
+}
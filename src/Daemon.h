@@ -0,0 +1,108 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "FairShare.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// A run requested through `pluma --submit`: the command line it was given
+// and the directory it was given in.
+struct Submission {
+    std::string cwd;
+    std::vector<std::string> args;               // config file, optional restart point
+    std::map<std::string, std::string> flags;    // --name[=value], without --submit/--socket
+};
+
+// Wire form of a Submission: "cwd\t...", "arg\t..." and "flag\tname\tvalue"
+// lines, ended by "end".
+std::string encodeSubmission(const Submission& submission);
+bool decodeSubmission(const std::string& text, Submission& submission);
+
+// `pluma daemon`: keeps the plugin catalog and the language runtimes that
+// main() loaded resident and runs configs submitted over a UNIX domain
+// socket. Each submission runs in a child forked from the warm process, in
+// the submitter's directory, with its stdout and stderr on the connection:
+// the submitter sees every [PluMA] status line as it is printed, then
+// "[PluMA] Exit: N". Submissions never see each other's globals and may run
+// concurrently. Plugins installed after the daemon started are not seen
+// until it restarts.
+//
+// All runs share one budget: every plugin a run executes first takes a
+// DaemonLease, which FairShare grants among the tenants with runs going.
+// A submission's tenant is the user who sent it, from the socket's peer
+// credentials; its --tenant option only labels it within that user's
+// share, as "user/label". The run is given its tenant and a session
+// (flags "tenant" and "session"), whatever the submission said of them.
+class Daemon {
+public:
+    using Runner = std::function<int(const Submission&)>;
+
+    explicit Daemon(std::string socketPath) : mySocketPath(socketPath), myListenFd(-1) {}
+    ~Daemon();
+
+    Daemon(const Daemon&) = delete;
+    Daemon& operator=(const Daemon&) = delete;
+
+    // Binds the socket (user-only permissions, or also the user's group when
+    // shared). Fails if another daemon is already listening on it; a stale
+    // socket file is replaced.
+    bool listen(bool shared = false);
+
+    // The budget shared by every run, and the tenants' weights; by default
+    // the system defaults of a Parallel block, every tenant weighing 1.
+    void setBudget(const parallel::ParallelBlockOptions& budget, const std::map<std::string, double>& weights);
+
+    // Runs submissions until SIGTERM or SIGINT, then stops the runs still
+    // going and removes the socket.
+    void serve(Runner run);
+
+    const std::string& socketPath() const {return mySocketPath;}
+    const std::string& error() const {return myError;}
+
+    // $PLUMA_SOCKET, or a per-user socket in /tmp.
+    static std::string defaultSocket();
+
+private:
+    std::string mySocketPath;
+    std::string myError;
+    int myListenFd;
+    std::unique_ptr<parallel::FairShare> myShare;
+};
+
+// Sends a submission to the daemon at socketPath and copies its output to
+// out. Returns the run's exit status (1 if the daemon went away before
+// reporting it), or -1 if no daemon answered.
+int submitToDaemon(const std::string& socketPath, const Submission& submission, std::ostream& out);
+
+// Copies the daemon's per-tenant usage table to out; false if no daemon answered.
+bool requestTenantUsage(const std::string& socketPath, std::ostream& out);
+
+// One plugin execution's hold on its share of a daemon's budget. The
+// constructor blocks until the daemon grants the task's resources to the
+// tenant of the run with this session; they are given back when the lease
+// is destroyed, or when its process dies, since the hold is an open
+// connection.
+class DaemonLease {
+public:
+    DaemonLease(const std::string& socketPath, const std::string& session, const parallel::PluginTask& task);
+    ~DaemonLease();
+
+    DaemonLease(const DaemonLease&) = delete;
+    DaemonLease& operator=(const DaemonLease&) = delete;
+
+    // Why the lease was not granted: the task can never fit the daemon's
+    // budget, the session is not a run's, or the daemon went away. Empty
+    // once granted.
+    const std::string& error() const {return myError;}
+
+private:
+    int myFd;
+    std::string myError;
+};
+
+#endif
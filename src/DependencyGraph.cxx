@@ -0,0 +1,153 @@
+#include "DependencyGraph.h"
+#include "Planner.h"
+#include "SampleSweep.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+
+namespace parallel {
+
+namespace fs = std::filesystem;
+
+static std::string normalize(const std::string& p) {
+    if (p.empty()) return p;
+    std::string n = fs::path(p).lexically_normal().generic_string();
+    while (n.size() > 1 && n.back() == '/') n.pop_back();
+    return n;
+}
+
+static bool contains_path(const std::string& dir, const std::string& path) {
+    return path.size() > dir.size() && path.compare(0, dir.size(), dir) == 0 && path[dir.size()] == '/';
+}
+
+bool paths_overlap(const std::string& input, const std::string& output) {
+    std::string a = normalize(input);
+    std::string b = normalize(output);
+    if (a.empty() || b.empty()) return false;
+    return a == b || contains_path(a, b) || contains_path(b, a);
+}
+
+FlattenResult flatten_config(const std::string& path, const std::string& prefix) {
+    Plan plan = build_plan(path, prefix);
+    FlattenResult out;
+    out.errors = plan.errors;
+    // A Scatter's input may not exist until its producer has run, so it
+    // cannot be split here.
+    for (const auto& step : plan.steps) {
+        if (!step.sweep) {
+            out.tasks.push_back(step.task);
+            continue;
+        }
+        // The graph needs every task up front, so sweeps are expanded here.
+        SweepSource source(step.sweep_block);
+        PluginTask task;
+        while (source.next(task)) out.tasks.push_back(task);
+        if (!source.error().empty()) out.errors.push_back(step.origin + ": " + source.error());
+    }
+    return out;
+}
+
+// Tasks by the normalized paths they read or write, so the tasks whose path
+// overlaps another are found by lookup rather than by comparing it with
+// every earlier task. Indices are added in increasing order.
+class PathIndex {
+public:
+    void add(const std::string& path, size_t task) {
+        if (path.empty()) return;
+        if (path_of_.size() <= task) path_of_.resize(task + 1);
+        path_of_[task] = path;
+        at_[path].push_back(task);
+        for (size_t k = 1; k < path.size(); k++) {
+            if (path[k] == '/') under_[path.substr(0, k)].push_back(task);
+        }
+    }
+
+    // Calls fn with the tasks at `path`, at a directory containing it, and
+    // inside it, as paths_overlap() defines them; each list ascending.
+    template <class Fn>
+    void overlapping(const std::string& path, Fn fn) const {
+        if (path.empty()) return;
+        auto at = at_.find(path);
+        if (at != at_.end()) fn(at->second);
+        for (size_t k = 1; k < path.size(); k++) {
+            if (path[k] != '/') continue;
+            auto dir = at_.find(path.substr(0, k));
+            if (dir != at_.end()) fn(dir->second);
+        }
+        auto under = under_.find(path);
+        if (under != under_.end()) fn(under->second);
+    }
+
+    // Calls fn with each task overlapping `path` that no later task has
+    // superseded, by the same path or a directory containing it.
+    template <class Fn>
+    void overlapping_latest(const std::string& path, Fn fn) const {
+        if (path.empty()) return;
+        auto at = at_.find(path);
+        if (at != at_.end() && latest_covering(path) == at->second.back()) fn(at->second.back());
+        for (size_t k = 1; k < path.size(); k++) {
+            if (path[k] != '/') continue;
+            std::string dir = path.substr(0, k);
+            auto found = at_.find(dir);
+            if (found != at_.end() && latest_covering(dir) == found->second.back()) fn(found->second.back());
+        }
+        auto under = under_.find(path);
+        if (under == under_.end()) return;
+        for (size_t task : under->second) {
+            if (latest_covering(path_of_[task]) == task) fn(task);
+        }
+    }
+
+private:
+    // The last task added at `path` or at a directory containing it.
+    size_t latest_covering(const std::string& path) const {
+        size_t latest = 0;
+        auto consider = [&](const std::string& p) {
+            auto found = at_.find(p);
+            if (found != at_.end()) latest = std::max(latest, found->second.back());
+        };
+        consider(path);
+        for (size_t k = 1; k < path.size(); k++) {
+            if (path[k] == '/') consider(path.substr(0, k));
+        }
+        return latest;
+    }
+
+    std::unordered_map<std::string, std::vector<size_t>> at_;
+    std::unordered_map<std::string, std::vector<size_t>> under_;   // by every directory above the path
+    std::vector<std::string> path_of_;
+};
+
+TaskGraph build_task_graph(const std::vector<PluginTask>& tasks) {
+    TaskGraph graph;
+    graph.tasks = tasks;
+    graph.dependencies.resize(tasks.size());
+
+    PathIndex readers, writers;
+    for (size_t j = 0; j < tasks.size(); j++) {
+        auto& deps = graph.dependencies[j];
+        std::string input = normalize(tasks[j].inputfile);
+        std::string output = normalize(tasks[j].outputfile);
+
+        // Read-after-write: every writer of part of the input whose output
+        // has not since been overwritten whole. Sibling files written under
+        // a directory the task reads all count, not just the last one.
+        writers.overlapping_latest(input, [&](size_t i) { deps.push_back(i); });
+
+        // Write-after-read / write-after-write: earlier users of our output
+        // must finish before we overwrite it.
+        auto add_all = [&](const std::vector<size_t>& found) { deps.insert(deps.end(), found.begin(), found.end()); };
+        readers.overlapping(output, add_all);
+        writers.overlapping(output, add_all);
+
+        std::sort(deps.begin(), deps.end());
+        deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+
+        readers.add(input, j);
+        writers.add(output, j);
+    }
+    return graph;
+}
+
+} // namespace parallel
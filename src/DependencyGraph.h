@@ -0,0 +1,36 @@
+#ifndef DEPENDENCY_GRAPH_H
+#define DEPENDENCY_GRAPH_H
+
+#include "ParallelTypes.h"
+
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+struct FlattenResult {
+    std::vector<PluginTask> tasks;      // every Plugin line, in execution order
+    std::vector<std::string> errors;    // "file:line: message"
+};
+
+// Expands a config file into the plugin tasks it would run, following
+// Pipeline includes and applying Prefix/Kitty to paths. Parallel blocks and
+// Litter markers only group tasks, so their plugins are emitted inline; a
+// Sweep is expanded into one task per sample, so its sample list or glob
+// must already resolve when the config is flattened. A Scatter's plugin is
+// emitted as one task on the whole input.
+FlattenResult flatten_config(const std::string& path, const std::string& prefix = "");
+
+// Orders tasks by the files they share: a task depends on each earlier
+// writer of its input, or of a file under it, that no later task overwrote
+// (read-after-write), and on every earlier reader or writer of its output
+// (write-after-read, write-after-write).
+TaskGraph build_task_graph(const std::vector<PluginTask>& tasks);
+
+// Returns true if reading `input` may observe what was written to `output`,
+// i.e. the paths are equal or one is a directory containing the other.
+bool paths_overlap(const std::string& input, const std::string& output);
+
+} // namespace parallel
+
+#endif
@@ -0,0 +1,338 @@
+#include "Engine.h"
+#include "DependencyGraph.h"
+#include "PluginManager.h"
+#include "Runner.h"
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+// Everything the monitor thread and the handles share about one run. The
+// monitor reads the run's pipes: its stdout and stderr, and the progress
+// events of Runner.h, preceded by "steps\tN" from the child itself.
+struct RunHandle::State {
+    std::mutex mutex;
+    std::condition_variable ended;
+    pid_t pid = -1;
+    int outputFd = -1;
+    int progressFd = -1;
+    std::string pending;            // progress read up to an incomplete line
+    bool finished = false;
+    bool cancelled = false;
+    int exitCode = 0;
+    RunStatus status = RunStatus::Running;
+    RunProgress progress;
+    std::string output;
+};
+
+void RunHandle::wait() const {
+    std::unique_lock<std::mutex> lock(myState->mutex);
+    myState->ended.wait(lock, [this] { return myState->finished; });
+}
+
+std::future_status RunHandle::wait_for(std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(myState->mutex);
+    return myState->ended.wait_for(lock, timeout, [this] { return myState->finished; })
+        ? std::future_status::ready : std::future_status::timeout;
+}
+
+int RunHandle::get() const {
+    wait();
+    std::lock_guard<std::mutex> lock(myState->mutex);
+    return myState->exitCode;
+}
+
+RunStatus RunHandle::status() const {
+    std::lock_guard<std::mutex> lock(myState->mutex);
+    return myState->status;
+}
+
+RunProgress RunHandle::progress() const {
+    std::lock_guard<std::mutex> lock(myState->mutex);
+    return myState->progress;
+}
+
+std::string RunHandle::output() const {
+    std::lock_guard<std::mutex> lock(myState->mutex);
+    return myState->output;
+}
+
+bool RunHandle::cancel() {
+    std::lock_guard<std::mutex> lock(myState->mutex);
+    if (myState->finished) return false;
+    myState->cancelled = true;
+    // The run's workers and their children are in its process group.
+    killpg(myState->pid, SIGTERM);
+    return true;
+}
+
+static void progressEvent(RunProgress& progress, const std::string& line) {
+    size_t tab = line.find('\t');
+    if (tab == std::string::npos) return;
+    std::string event = line.substr(0, tab);
+    std::string plugin = line.substr(tab + 1);
+    if (event == "steps") {
+        progress.steps = std::strtoul(plugin.c_str(), NULL, 10);
+        return;
+    }
+    if (event == "start") {
+        progress.running.push_back(plugin);
+        return;
+    }
+    if (event == "done") progress.completed++;
+    else if (event == "fail") progress.failed++;
+    else return;
+    std::vector<std::string>::iterator it = std::find(progress.running.begin(), progress.running.end(), plugin);
+    if (it != progress.running.end()) progress.running.erase(it);
+}
+
+// Reads what fd has now; closes it at end of file.
+static void readPipe(int& fd, std::string& into) {
+    char buf[4096];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            into.append(buf, n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0) {
+            close(fd);
+            fd = -1;
+        }
+        return;
+    }
+}
+
+void Engine::readRun(RunHandle::State& run) {
+    std::lock_guard<std::mutex> lock(run.mutex);
+    if (run.outputFd >= 0) readPipe(run.outputFd, run.output);
+    if (run.progressFd >= 0) readPipe(run.progressFd, run.pending);
+    size_t newline;
+    while ((newline = run.pending.find('\n')) != std::string::npos) {
+        progressEvent(run.progress, run.pending.substr(0, newline));
+        run.pending.erase(0, newline + 1);
+    }
+}
+
+Engine::Engine(const std::string& pluginPath) : myStopping(false) {
+    std::string path = pluginPath.empty() ? defaultPluginPath() : pluginPath;
+    if (path.compare(path.length() - 1, 1, PLUMA_PATH_LIST_SEPARATOR) != 0) path += PLUMA_PATH_LIST_SEPARATOR;
+    // The languages and their runtimes stay loaded for the life of the process.
+    if (PluginManager::supported.empty()) {
+        static char name[] = "pluma";
+        static char* argv[] = {name, NULL};
+        PluginManager::supportedLanguages(path, 1, argv);
+    }
+    loadPlugins(path, false);
+    // Started once for every run; the first fork waits for them
+    PluginManager::startLanguages(PluginManager::getInstance().languages());
+
+    if (pipe(myWakeFds) != 0) myWakeFds[0] = myWakeFds[1] = -1;
+    myMonitor = std::thread(&Engine::monitor, this);
+}
+
+Engine::~Engine() {
+    {
+        std::lock_guard<std::mutex> lock(myMutex);
+        myStopping = true;
+        for (size_t i = 0; i < myRuns.size(); i++) {
+            RunHandle handle;
+            handle.myState = myRuns[i];
+            handle.cancel();
+        }
+    }
+    if (write(myWakeFds[1], "x", 1) < 0) {}
+    myMonitor.join();
+    close(myWakeFds[0]);
+    close(myWakeFds[1]);
+}
+
+parallel::SchedulerResult Engine::run(const parallel::TaskGraph& graph, const std::map<std::string, std::string>& options) {
+    parallel::TaskGraph checked = graph;
+    checked.dependencies.resize(checked.tasks.size());
+    // Kahn's algorithm: every task is reached only if there is no cycle.
+    std::vector<size_t> waiting(checked.tasks.size(), 0);
+    std::vector<std::vector<size_t>> dependents(checked.tasks.size());
+    for (size_t i = 0; i < checked.tasks.size(); i++) {
+        for (size_t dep : checked.dependencies[i]) {
+            if (dep >= checked.tasks.size() || dep == i)
+                throw std::invalid_argument("task " + std::to_string(i) + " (" + checked.tasks[i].name +
+                                            ") depends on " + std::to_string(dep) + ", which is not another task");
+            dependents[dep].push_back(i);
+            waiting[i]++;
+        }
+    }
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < waiting.size(); i++)
+        if (waiting[i] == 0) ready.push_back(i);
+    size_t reached = 0;
+    while (!ready.empty()) {
+        size_t i = ready.back();
+        ready.pop_back();
+        reached++;
+        for (size_t d : dependents[i])
+            if (--waiting[d] == 0) ready.push_back(d);
+    }
+    if (reached < checked.tasks.size()) throw std::invalid_argument("the task dependencies form a cycle");
+
+    std::map<std::string, std::string> flags = options;
+    return runGraph(checked, budgetOptions(flags));
+}
+
+std::vector<std::string> Engine::plugins() const {
+    return std::vector<std::string>(PluginManager::getInstance().installed.begin(), PluginManager::getInstance().installed.end());
+}
+
+RunHandle Engine::submit(const std::string& config, const std::map<std::string, std::string>& options,
+                         const std::string& directory) {
+    return start([config, options] { return runConfig(std::vector<std::string>(1, config), options); },
+                 [config] { return parallel::flatten_config(config).tasks.size(); },
+                 directory);
+}
+
+RunHandle Engine::submit(const parallel::ParallelBlock& block, const std::string& directory) {
+    return start([block] { return runBlock(block); },
+                 [block] { return block.tasks.size(); },
+                 directory);
+}
+
+RunHandle Engine::start(std::function<int()> run, std::function<size_t()> steps, const std::string& directory) {
+    RunHandle handle;
+    handle.myState = std::make_shared<RunHandle::State>();
+    RunHandle::State& state = *handle.myState;
+
+    int outputFds[2], progressFds[2];
+    if (pipe(outputFds) != 0) {
+        state.output = "[PluMA] Error: cannot start run\n";
+        state.exitCode = 1;
+        state.finished = true;
+        state.status = RunStatus::Failed;
+        return handle;
+    }
+    if (pipe(progressFds) != 0) {
+        close(outputFds[0]);
+        close(outputFds[1]);
+        state.output = "[PluMA] Error: cannot start run\n";
+        state.exitCode = 1;
+        state.finished = true;
+        state.status = RunStatus::Failed;
+        return handle;
+    }
+
+    std::lock_guard<std::mutex> lock(myMutex);
+    std::cout.flush();
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == 0) {
+        setpgid(0, 0);
+        signal(SIGTERM, SIG_DFL);
+        signal(SIGINT, SIG_DFL);
+        signal(SIGPIPE, SIG_DFL);
+        close(myWakeFds[0]);
+        close(myWakeFds[1]);
+        for (size_t i = 0; i < myRuns.size(); i++) {
+            if (myRuns[i]->outputFd >= 0) close(myRuns[i]->outputFd);
+            if (myRuns[i]->progressFd >= 0) close(myRuns[i]->progressFd);
+        }
+        close(outputFds[0]);
+        close(progressFds[0]);
+        dup2(outputFds[1], STDOUT_FILENO);
+        dup2(outputFds[1], STDERR_FILENO);
+        close(outputFds[1]);
+        progressFd = progressFds[1];
+        if (!directory.empty() && chdir(directory.c_str()) != 0) {
+            std::cout << "[PluMA] Error: cannot change to directory " << directory << std::endl;
+            _exit(1);
+        }
+        std::string line = "steps\t" + std::to_string(steps()) + "\n";
+        if (write(progressFd, line.data(), line.size()) < 0) {}
+        int code = run();
+        std::cout.flush();
+        fflush(stdout);
+        _exit(code);
+    }
+    close(outputFds[1]);
+    close(progressFds[1]);
+    if (pid < 0) {
+        close(outputFds[0]);
+        close(progressFds[0]);
+        state.output = "[PluMA] Error: cannot start run\n";
+        state.exitCode = 1;
+        state.finished = true;
+        state.status = RunStatus::Failed;
+        return handle;
+    }
+    // Also here, so that a cancel() right away finds the group.
+    setpgid(pid, pid);
+    fcntl(outputFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(progressFds[0], F_SETFL, O_NONBLOCK);
+    state.pid = pid;
+    state.outputFd = outputFds[0];
+    state.progressFd = progressFds[0];
+    myRuns.push_back(handle.myState);
+    if (write(myWakeFds[1], "x", 1) < 0) {}
+    return handle;
+}
+
+// Collects the runs' output and progress, and ends each when its process
+// exits. A run is reaped by its pid, so the program's other children are
+// left to it.
+void Engine::monitor() {
+    for (;;) {
+        std::vector<struct pollfd> fds;
+        fds.push_back({myWakeFds[0], POLLIN, 0});
+        {
+            std::lock_guard<std::mutex> lock(myMutex);
+            if (myStopping && myRuns.empty()) return;
+            for (size_t i = 0; i < myRuns.size(); i++) {
+                std::lock_guard<std::mutex> runLock(myRuns[i]->mutex);
+                if (myRuns[i]->outputFd >= 0) fds.push_back({myRuns[i]->outputFd, POLLIN, 0});
+                if (myRuns[i]->progressFd >= 0) fds.push_back({myRuns[i]->progressFd, POLLIN, 0});
+            }
+        }
+        // Also wakes up to reap a run whose pipes a plugin left open.
+        if (poll(fds.data(), fds.size(), 200) > 0 && (fds[0].revents & POLLIN)) {
+            char buf[64];
+            if (read(myWakeFds[0], buf, sizeof(buf)) < 0) {}
+        }
+
+        std::lock_guard<std::mutex> lock(myMutex);
+        for (size_t i = 0; i < myRuns.size();) {
+            std::shared_ptr<RunHandle::State> kept = myRuns[i];
+            RunHandle::State& run = *kept;
+            readRun(run);
+            int status = 0;
+            if (waitpid(run.pid, &status, WNOHANG) != run.pid) {
+                i++;
+                continue;
+            }
+            readRun(run);
+            myRuns.erase(myRuns.begin() + i);
+            std::lock_guard<std::mutex> runLock(run.mutex);
+            if (run.outputFd >= 0) close(run.outputFd);
+            if (run.progressFd >= 0) close(run.progressFd);
+            run.outputFd = run.progressFd = -1;
+            run.progress.running.clear();
+            if (WIFEXITED(status)) run.exitCode = WEXITSTATUS(status);
+            else if (WIFSIGNALED(status)) run.exitCode = 128 + WTERMSIG(status);
+            // A config run exits 0 even when one of its plugins failed.
+            if (run.exitCode == 0 && run.progress.failed > 0) run.exitCode = 1;
+            if (run.cancelled) run.status = RunStatus::Cancelled;
+            else if (run.exitCode != 0) run.status = RunStatus::Failed;
+            else run.status = RunStatus::Succeeded;
+            run.finished = true;
+            run.ended.notify_all();
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "ParallelTypes.h"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// libpluma: PluMA's planner, scheduler and language backends for programs
+// that run pipelines themselves instead of through the pluma command.
+//
+//     Engine engine;                              // ./plugins and $PLUMA_PLUGIN_PATH
+//     RunHandle run = engine.submit("pipeline.txt", {{"dag", ""}, {"workers", "4"}});
+//     while (run.wait_for(std::chrono::seconds(1)) == std::future_status::timeout)
+//         std::cout << run.progress().completed << "/" << run.progress().steps << std::endl;
+//     int code = run.get();
+//
+// Like `pluma daemon`, an Engine loads the plugins and language runtimes
+// once and runs each submission in a child process forked from itself, so
+// runs keep their globals apart, may go on concurrently and can be stopped
+// without harm to the program. A run's [PluMA] status lines are collected
+// rather than printed.
+
+struct RunProgress {
+    size_t steps = 0;                   // plugins the pipeline runs (a scattered step counts once)
+    size_t completed = 0;               // completed, or skipped as completed before
+    size_t failed = 0;
+    std::vector<std::string> running;   // plugins started and not yet completed
+};
+
+enum class RunStatus { Running, Succeeded, Failed, Cancelled };
+
+// A submitted run, used like the std::future of its exit code. Copies
+// refer to the same run.
+class RunHandle {
+public:
+    RunHandle() {}
+
+    // False for a default-constructed handle.
+    bool valid() const {return myState != nullptr;}
+
+    // Blocks until the run has ended.
+    void wait() const;
+
+    // std::future_status::ready once the run has ended, else timeout.
+    std::future_status wait_for(std::chrono::milliseconds timeout) const;
+
+    // Waits, then returns the run's exit code: 0 if it succeeded, 128 plus
+    // the signal if it was killed.
+    int get() const;
+
+    RunStatus status() const;
+    RunProgress progress() const;
+
+    // Everything the run has printed so far.
+    std::string output() const;
+
+    // Stops the run and the plugins it is running; false if it had already
+    // ended. Outputs it already wrote are left in place, so a config
+    // submitted again with the "resume" option continues where it stopped.
+    bool cancel();
+
+private:
+    friend class Engine;
+    struct State;
+    std::shared_ptr<State> myState;
+};
+
+// One per process: the languages and plugin catalog it loads are
+// PluginManager's. Destroying it stops the runs still going.
+class Engine {
+public:
+    // pluginPath: directories separated by PLUMA_PATH_LIST_SEPARATOR; by
+    // default ./plugins, then $PLUMA_PLUGIN_PATH.
+    explicit Engine(const std::string& pluginPath = "");
+    ~Engine();
+
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // Runs a config file as `pluma [options] config` would, options being
+    // the command line's without "--" (e.g. {"dag", ""}, {"fail", "continue"}),
+    // in directory if given, else the current directory.
+    RunHandle submit(const std::string& config, const std::map<std::string, std::string>& options = {},
+                     const std::string& directory = "");
+
+    // Runs a Parallel block built in code; its paths are relative to directory.
+    RunHandle submit(const parallel::ParallelBlock& block, const std::string& directory = "");
+
+    // Runs a task graph built in code in this process, returning once every
+    // task has ended. Each plugin runs in a worker forked from the process,
+    // as in a Parallel block, and all share one budget, from options as for
+    // --dag (workers, memory, gpu, fail, order, backfill). A failed task,
+    // even under fail=fast, is returned in the result's failed list rather
+    // than ending the process. Paths are relative to the current directory.
+    // Nothing is kept between calls but the runtime history, which makes
+    // this the cheap way to run many small graphs. Throws std::invalid_argument if a dependency is not the
+    // index of a task, or the dependencies form a cycle.
+    parallel::SchedulerResult run(const parallel::TaskGraph& graph,
+                                  const std::map<std::string, std::string>& options = {});
+
+    // The plugins found, by name.
+    std::vector<std::string> plugins() const;
+
+private:
+    RunHandle start(std::function<int()> run, std::function<size_t()> steps, const std::string& directory);
+    void monitor();
+    static void readRun(RunHandle::State& run);
+
+    std::mutex myMutex;
+    std::vector<std::shared_ptr<RunHandle::State>> myRuns;   // runs not yet ended
+    std::thread myMonitor;
+    int myWakeFds[2];
+    bool myStopping;
+};
+
+#endif
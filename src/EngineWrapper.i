@@ -0,0 +1,44 @@
+// libpluma for Python: the Engine, and the task, graph and result types it
+// takes and returns, and the parsing of Plugin lines. PyPipeline.py builds
+// pipelines on top of it.
+
+%module PyPluMAEngine
+%{
+#include "ParallelTypes.h"
+#include "ConfigParser.h"
+#include "DependencyGraph.h"
+#include "Engine.h"
+%}
+
+%include "exception.i"
+%include "std_map.i"
+%include "std_string.i"
+%include "std_vector.i"
+
+// Engine::run's std::invalid_argument becomes a ValueError.
+%exception {
+    try {
+        $action
+    }
+    catch (const std::invalid_argument& e) {
+        SWIG_exception(SWIG_ValueError, e.what());
+    }
+}
+
+// These take a C++ stream or duration. PyPipeline.py composes Plugin lines
+// for parse_plugin_task instead, and RunHandle::status() serves to poll.
+%ignore parallel::parse_config;
+%ignore RunHandle::wait_for;
+
+%include "ParallelTypes.h"
+
+%template(StringVector) std::vector<std::string>;
+%template(IndexVector) std::vector<size_t>;
+%template(DependencyVector) std::vector<std::vector<size_t> >;
+%template(TaskVector) std::vector<parallel::PluginTask>;
+%template(ResultVector) std::vector<parallel::PluginResult>;
+%template(OptionMap) std::map<std::string, std::string>;
+
+%include "ConfigParser.h"
+%include "DependencyGraph.h"
+%include "Engine.h"
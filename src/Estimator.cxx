@@ -0,0 +1,342 @@
+#include "Estimator.h"
+#include "ResourceBudget.h"
+#include "SampleSweep.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <set>
+
+namespace parallel {
+
+namespace fs = std::filesystem;
+
+void CostModel::add(const RunSample& sample) {
+    samples_[sample.plugin].push_back(sample);
+}
+
+size_t CostModel::sample_count(const std::string& plugin) const {
+    auto it = samples_.find(plugin);
+    return it == samples_.end() ? 0 : it->second.size();
+}
+
+TaskCost CostModel::predict(const std::string& plugin, size_t input_bytes) const {
+    TaskCost cost;
+    auto it = samples_.find(plugin);
+    if (it == samples_.end() || it->second.empty()) return cost;
+    const std::vector<RunSample>& runs = it->second;
+    cost.known = true;
+
+    double n = static_cast<double>(runs.size());
+    double mean_x = 0, mean_t = 0;
+    std::set<size_t> sizes;
+    size_t max_rss = 0, rss_bytes = 0;
+    for (const auto& r : runs) {
+        mean_x += r.input_bytes / n;
+        mean_t += r.seconds / n;
+        sizes.insert(r.input_bytes);
+        if (r.peak_rss > max_rss) {
+            max_rss = r.peak_rss;
+            rss_bytes = r.input_bytes;
+        }
+    }
+
+    double x = static_cast<double>(input_bytes);
+    if (input_bytes == 0 || (sizes.size() == 1 && *sizes.begin() == 0)) {
+        cost.seconds = mean_t;
+    } else if (sizes.size() == 1) {
+        cost.seconds = mean_t * x / static_cast<double>(*sizes.begin());
+    } else {
+        double sxx = 0, sxt = 0, sx2 = 0, sxt0 = 0;
+        for (const auto& r : runs) {
+            sxx += (r.input_bytes - mean_x) * (r.input_bytes - mean_x);
+            sxt += (r.input_bytes - mean_x) * (r.seconds - mean_t);
+            sx2 += static_cast<double>(r.input_bytes) * r.input_bytes;
+            sxt0 += static_cast<double>(r.input_bytes) * r.seconds;
+        }
+        double slope = sxt / sxx;
+        double intercept = mean_t - slope * mean_x;
+        if (slope < 0) {                 // bigger inputs are not faster
+            slope = 0;
+            intercept = mean_t;
+        } else if (intercept < 0) {      // nor is there negative start-up time
+            intercept = 0;
+            slope = sxt0 / sx2;
+        }
+        cost.seconds = intercept + slope * x;
+    }
+
+    cost.memory = max_rss;
+    if (max_rss > 0 && rss_bytes > 0 && input_bytes > rss_bytes)
+        cost.memory = static_cast<size_t>(static_cast<double>(max_rss) * x / static_cast<double>(rss_bytes));
+    return cost;
+}
+
+size_t input_size(const std::string& path) {
+    std::error_code ec;
+    if (path.empty()) return 0;
+    if (fs::is_regular_file(path, ec)) return fs::file_size(path, ec);
+    if (!fs::is_directory(path, ec)) return 0;
+    size_t total = 0;
+    for (fs::recursive_directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec)) total += it->file_size(ec);
+    }
+    return total;
+}
+
+static std::string task_label(const PluginTask& task) {
+    if (task.inputfile.empty()) return task.name;
+    return task.name + "(" + fs::path(task.inputfile).filename().string() + ")";
+}
+
+// Memory a task is expected to hold while running: its predicted RSS, or the
+// memory= hint when there is no measurement.
+static size_t expected_memory(const PluginTask& task, const TaskCost& cost) {
+    return cost.memory > 0 ? cost.memory : task.memory_hint;
+}
+
+// simulate_block, also returning the critical path as task indices.
+static StageEstimate simulate(const std::vector<PluginTask>& tasks, const std::vector<TaskCost>& costs,
+                              const ParallelBlockOptions& options, std::vector<size_t>& chain) {
+    StageEstimate stage;
+    stage.tasks = tasks.size();
+    for (const auto& c : costs) if (!c.known) stage.unknown++;
+
+    struct Running {
+        size_t index;
+        double end;
+    };
+    // The scheduler's dispatch order: longest expected runtime first.
+    std::vector<size_t> queue(tasks.size());
+    for (size_t i = 0; i < queue.size(); i++) queue[i] = i;
+    if (options.order == DispatchOrder::Longest) {
+        std::stable_sort(queue.begin(), queue.end(),
+                         [&](size_t a, size_t b) { return costs[a].seconds > costs[b].seconds; });
+    }
+    // Reservations are planned from the same predictions.
+    std::vector<PluginTask> planned = tasks;
+    for (size_t i = 0; i < planned.size(); i++) planned[i].expected_seconds = costs[i].known ? costs[i].seconds : 0.0;
+
+    ResourceBudget budget(resolve_defaults(options));
+    std::vector<Running> running;
+    std::vector<long> started_after(tasks.size(), -1);
+    double now = 0;
+    size_t memory = 0;
+    long last_released = -1, last_finished = -1;
+
+    while (!queue.empty() || !running.empty()) {
+        std::unique_ptr<Reservation> reservation;
+        for (size_t pos = 0; pos < queue.size();) {
+            size_t next = queue[pos];
+            if (!budget.can_dispatch(planned[next])) {
+                if (running.empty()) {
+                    stage.never_fit.push_back(task_label(tasks[next]));
+                    queue.erase(queue.begin() + pos);
+                    continue;
+                }
+                if (!options.backfill) break;
+                if (!reservation) {
+                    std::vector<RunningTask> busy;
+                    for (const auto& r : running) {
+                        busy.push_back({&planned[r.index], costs[r.index].known ? r.end
+                                                                             : std::numeric_limits<double>::infinity()});
+                    }
+                    reservation.reset(new Reservation(reserve(budget, busy, planned[next])));
+                }
+                pos++;
+                continue;
+            }
+            if (reservation && !may_backfill(*reservation, planned[next], now)) {
+                pos++;
+                continue;
+            }
+            budget.acquire(planned[next]);
+            started_after[next] = last_released;
+            running.push_back({next, now + costs[next].seconds});
+            memory += expected_memory(tasks[next], costs[next]);
+            stage.peak_memory = std::max(stage.peak_memory, memory);
+            queue.erase(queue.begin() + pos);
+        }
+        if (running.empty()) break;
+
+        auto first = std::min_element(running.begin(), running.end(),
+                                      [](const Running& a, const Running& b) { return a.end < b.end; });
+        size_t idx = first->index;
+        now = first->end;
+        running.erase(first);
+        budget.release(tasks[idx]);
+        memory -= expected_memory(tasks[idx], costs[idx]);
+        last_released = static_cast<long>(idx);
+        if (now >= stage.makespan) {
+            stage.makespan = now;
+            last_finished = static_cast<long>(idx);
+        }
+    }
+
+    chain.clear();
+    for (long i = last_finished; i >= 0; i = started_after[i]) chain.push_back(static_cast<size_t>(i));
+    std::reverse(chain.begin(), chain.end());
+    for (size_t i : chain) stage.critical_path.push_back(task_label(tasks[i]));
+    return stage;
+}
+
+StageEstimate simulate_block(const std::vector<PluginTask>& tasks, const std::vector<TaskCost>& costs,
+                             const ParallelBlockOptions& options) {
+    std::vector<size_t> chain;
+    return simulate(tasks, costs, options, chain);
+}
+
+// Estimates the given plan steps in order. Steps of `inside_litter` are
+// treated as ordinary steps: they are the body of one of its Kitties.
+static RunEstimate estimate_steps(const Plan& plan, const CostModel& model,
+                                  const std::vector<size_t>& steps, int inside_litter) {
+    RunEstimate run;
+    auto predict = [&](const PluginTask& task) {
+        TaskCost cost = model.predict(task.name, input_size(task.inputfile));
+        if (task.expected_seconds > 0) {
+            cost.seconds = task.expected_seconds;
+            cost.known = true;
+        }
+        return cost;
+    };
+
+    for (size_t k = 0; k < steps.size();) {
+        const PlanStep& step = plan.steps[steps[k]];
+        StageEstimate stage;
+
+        if (step.litter >= 0 && step.litter != inside_litter) {
+            // Every Kitty of the litter, each one's steps run one after another.
+            int litter = step.litter;
+            std::vector<std::string> kitties;
+            std::map<std::string, std::vector<size_t>> bodies;
+            for (; k < steps.size() && plan.steps[steps[k]].litter == litter; k++) {
+                const std::string& kitty = plan.steps[steps[k]].kitty;
+                if (!bodies.count(kitty)) kitties.push_back(kitty);
+                bodies[kitty].push_back(steps[k]);
+            }
+            std::vector<PluginTask> tasks;
+            std::vector<TaskCost> costs;
+            std::vector<RunEstimate> kitty_runs;
+            for (const auto& kitty : kitties) {
+                kitty_runs.push_back(estimate_steps(plan, model, bodies[kitty], litter));
+                PluginTask task;
+                task.name = kitty;
+                TaskCost cost;
+                cost.seconds = kitty_runs.back().makespan;
+                cost.memory = kitty_runs.back().peak_memory;
+                cost.known = kitty_runs.back().unknown == 0;
+                tasks.push_back(task);
+                costs.push_back(cost);
+            }
+            std::vector<size_t> chain;
+            stage = simulate(tasks, costs, plan.groups[litter].options, chain);
+            stage.label = "Litter of " + std::to_string(kitties.size()) + " kitties";
+            stage.origin = plan.groups[litter].origin;
+            stage.unknown = 0;
+            stage.critical_path.clear();
+            for (const auto& kr : kitty_runs) stage.unknown += kr.unknown;
+            for (size_t i : chain)
+                for (const auto& c : kitty_runs[i].critical_path) stage.critical_path.push_back(kitties[i] + ":" + c);
+        } else if (step.scatter) {
+            // Every shard gets an equal part of the input; a merge plugin then reads all of it.
+            const ScatterBlock& block = step.scatter_block;
+            size_t shards = static_cast<size_t>(std::max(block.shards, 1));
+            size_t bytes = input_size(step.task.inputfile);
+            std::vector<PluginTask> tasks;
+            std::vector<TaskCost> costs;
+            for (size_t i = 0; i < shards; i++) {
+                PluginTask shard = step.task;
+                shard.inputfile += "#" + std::to_string(i);
+                TaskCost cost = model.predict(shard.name, bytes / shards);
+                if (step.task.expected_seconds > 0) {
+                    cost.seconds = step.task.expected_seconds / shards;
+                    cost.known = true;
+                }
+                tasks.push_back(shard);
+                costs.push_back(cost);
+            }
+            stage = simulate_block(tasks, costs, plan.groups[step.group].options);
+            if (block.gather != "concat") {
+                TaskCost merge = model.predict(block.gather, bytes);
+                stage.tasks++;
+                stage.makespan += merge.seconds;
+                stage.peak_memory = std::max(stage.peak_memory, merge.memory);
+                if (!merge.known) stage.unknown++;
+                stage.critical_path.push_back(block.gather);
+            }
+            stage.label = "Scatter " + step.task.name + " over " + std::to_string(shards) + " shards";
+            stage.origin = plan.groups[step.group].origin;
+            k++;
+        } else if (step.group >= 0) {
+            int group = step.group;
+            std::vector<PluginTask> tasks;
+            for (; k < steps.size() && plan.steps[steps[k]].group == group; k++) {
+                const PlanStep& member = plan.steps[steps[k]];
+                if (!member.sweep) {
+                    tasks.push_back(member.task);
+                    continue;
+                }
+                SweepSource source(member.sweep_block);
+                PluginTask task;
+                while (source.next(task)) tasks.push_back(task);
+            }
+            std::vector<TaskCost> costs;
+            for (const auto& t : tasks) costs.push_back(predict(t));
+            stage = simulate_block(tasks, costs, plan.groups[group].options);
+            stage.label = plan.groups[group].kind == PlanGroup::Sweep
+                ? "Sweep " + step.task.name + " over " + std::to_string(tasks.size()) + " samples"
+                : "Parallel block of " + std::to_string(tasks.size()) + " plugins";
+            stage.origin = plan.groups[group].origin;
+        } else {
+            TaskCost cost = predict(step.task);
+            stage.label = "Plugin " + step.task.name;
+            stage.origin = step.origin;
+            stage.tasks = 1;
+            stage.unknown = cost.known ? 0 : 1;
+            stage.makespan = cost.seconds;
+            stage.peak_memory = expected_memory(step.task, cost);
+            stage.critical_path.push_back(task_label(step.task));
+            k++;
+        }
+
+        run.makespan += stage.makespan;
+        run.peak_memory = std::max(run.peak_memory, stage.peak_memory);
+        run.unknown += stage.unknown;
+        run.critical_path.insert(run.critical_path.end(), stage.critical_path.begin(), stage.critical_path.end());
+        run.stages.push_back(stage);
+    }
+    return run;
+}
+
+RunEstimate estimate_plan(const Plan& plan, const CostModel& model) {
+    std::vector<size_t> all(plan.steps.size());
+    for (size_t i = 0; i < all.size(); i++) all[i] = i;
+    return estimate_steps(plan, model, all, -1);
+}
+
+std::string format_seconds(double seconds) {
+    char buf[64];
+    long s = static_cast<long>(seconds + 0.5);
+    if (seconds < 60) snprintf(buf, sizeof(buf), "%.1fs", seconds);
+    else if (s < 3600) snprintf(buf, sizeof(buf), "%ldm %02lds", s / 60, s % 60);
+    else snprintf(buf, sizeof(buf), "%ldh %02ldm", s / 3600, (s % 3600) / 60);
+    return buf;
+}
+
+std::string format_bytes(size_t bytes) {
+    const char* units = "BKMGT";
+    double value = static_cast<double>(bytes);
+    int unit = 0;
+    while (value >= 1024 && unit < 4) {
+        value /= 1024;
+        unit++;
+    }
+    char buf[64];
+    if (unit == 0) snprintf(buf, sizeof(buf), "%zuB", bytes);
+    else snprintf(buf, sizeof(buf), "%.1f%c", value, units[unit]);
+    return buf;
+}
+
+} // namespace parallel
@@ -0,0 +1,85 @@
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+
+#include "ParallelTypes.h"
+#include "Planner.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+// One past execution of a plugin.
+struct RunSample {
+    std::string plugin;
+    size_t input_bytes = 0;
+    double seconds = 0.0;
+    size_t peak_rss = 0;     // bytes; 0 = not measured
+};
+
+struct TaskCost {
+    double seconds = 0.0;
+    size_t memory = 0;       // predicted peak RSS; 0 = unknown
+    bool known = false;      // false: no history for the plugin, counted as 0s
+};
+
+// Predicts a plugin's runtime and peak RSS from its past executions, scaled
+// by input size: a least-squares line over the recorded sizes when there are
+// several, proportional to the one recorded size otherwise, and the plain
+// mean when sizes are unknown. Memory scales up (never down) from the
+// largest recorded peak.
+class CostModel {
+public:
+    void add(const RunSample& sample);
+    TaskCost predict(const std::string& plugin, size_t input_bytes) const;
+    size_t sample_count(const std::string& plugin) const;
+
+private:
+    std::map<std::string, std::vector<RunSample>> samples_;
+};
+
+// Size of a file, or of everything under a directory; 0 if missing.
+size_t input_size(const std::string& path);
+
+struct StageEstimate {
+    std::string label;                    // "Plugin X", "Parallel block", "Sweep X", "Scatter X over N shards", "Litter"
+    std::string origin;                   // "file:line"
+    size_t tasks = 0;
+    size_t unknown = 0;                   // tasks without history
+    double makespan = 0.0;
+    size_t peak_memory = 0;               // predicted RSS (else memory= hint) of the tasks running together
+    std::vector<std::string> critical_path;
+    std::vector<std::string> never_fit;   // tasks the stage's budget can never admit
+};
+
+struct RunEstimate {
+    std::vector<StageEstimate> stages;    // in execution order
+    double makespan = 0.0;
+    size_t peak_memory = 0;
+    std::vector<std::string> critical_path;
+    size_t unknown = 0;
+};
+
+// Replays the dispatch of independent tasks under `options` with the
+// ResourceBudget rules ParallelScheduler uses (longest predicted first, or
+// config order; a task that does not fit waits with a reservation while
+// others are backfilled around it). The critical path is the chain of tasks, ending with the
+// last to finish, each of which started when the one before it freed room.
+StageEstimate simulate_block(const std::vector<PluginTask>& tasks, const std::vector<TaskCost>& costs,
+                             const ParallelBlockOptions& options);
+
+// Estimates every stage of a plan as pluma would run it, a time= hint
+// standing in for the prediction of its task: steps one after
+// another, each Parallel block and Sweep as one simulated block, and each
+// litter as a block of Kitty pipelines (a Kitty's own steps counted one
+// after another). The run's makespan is the sum over stages and its peak
+// memory the largest stage peak.
+RunEstimate estimate_plan(const Plan& plan, const CostModel& model);
+
+std::string format_seconds(double seconds);
+std::string format_bytes(size_t bytes);
+
+} // namespace parallel
+
+#endif
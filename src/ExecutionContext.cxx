@@ -0,0 +1,47 @@
+#include "ExecutionContext.h"
+
+static thread_local ExecutionContext* installed = NULL;
+
+void ExecutionContext::log(const std::string& msg) const {
+    if (!mySink) return;
+    if (myLabel.empty()) mySink->write("[PluMA] " + msg);
+    else mySink->write("[PluMA] [" + myLabel + "] " + msg);
+}
+
+void ExecutionContext::beginPhase(Phase phase) {
+    endPhase();
+    myPhase = phase;
+    myPhaseStart = std::chrono::steady_clock::now();
+}
+
+void ExecutionContext::endPhase() {
+    if (myPhase < 0) return;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - myPhaseStart).count();
+    if (myPhase == Input) myPhases.input += elapsed;
+    else if (myPhase == Run) myPhases.run += elapsed;
+    else myPhases.output += elapsed;
+    myPhase = -1;
+}
+
+ExecutionContext ExecutionContext::withPrefix(std::string prefix) const {
+    ExecutionContext child(*this);
+    child.setPrefix(prefix);
+    return child;
+}
+
+ExecutionContext& ExecutionContext::processDefault() {
+    static ExecutionContext context;
+    return context;
+}
+
+ExecutionContext& ExecutionContext::current() {
+    return installed ? *installed : processDefault();
+}
+
+ExecutionContext::Scope::Scope(ExecutionContext& context) : previous(installed) {
+    installed = &context;
+}
+
+ExecutionContext::Scope::~Scope() {
+    installed = previous;
+}
@@ -0,0 +1,104 @@
+#ifndef EXECUTION_CONTEXT_H
+#define EXECUTION_CONTEXT_H
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Destination of log messages. Each message is written as one whole line
+// under a lock, so pipelines sharing a sink never interleave mid-line.
+class LogSink {
+public:
+    LogSink() {}
+    explicit LogSink(const std::string& path) : out(path.c_str(), std::ios::out) {}
+
+    void write(const std::string& line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (out.is_open()) out << line << std::endl;
+    }
+
+private:
+    std::mutex mutex;
+    std::ofstream out;
+};
+
+// Share of the run's resources granted to a pipeline or plugin.
+struct ResourceAllotment {
+    int workers = 1;
+    size_t memory = 0;   // bytes; 0 = not limited
+    int gpu = 0;
+};
+
+// Wall time a plugin spent in its input(), run() and output() calls.
+struct PhaseTimes {
+    double input = 0.0;
+    double run = 0.0;
+    double output = 0.0;
+};
+
+// What a running pipeline needs to know about itself: the Prefix its paths
+// resolve against, where its log goes and the resources it may use. Language
+// backends install the context of the plugin they run as the current one for
+// their thread, which is what the prefix()/log() API in PluMA.cxx reads, so
+// pipelines running concurrently in one process never see each other's state.
+class ExecutionContext {
+public:
+    ExecutionContext(std::string prefix = "", std::shared_ptr<LogSink> sink = std::shared_ptr<LogSink>(),
+                     ResourceAllotment allotment = ResourceAllotment())
+        : myPrefix(prefix), mySink(sink), myAllotment(allotment) {}
+
+    const std::string& prefix() const {return myPrefix;}
+    void setPrefix(std::string prefix) {myPrefix = prefix;}
+
+    // Tag added to every log line, e.g. the Kitty a pipeline belongs to.
+    const std::string& label() const {return myLabel;}
+    void setLabel(std::string label) {myLabel = label;}
+
+    const ResourceAllotment& allotment() const {return myAllotment;}
+    void setAllotment(ResourceAllotment allotment) {myAllotment = allotment;}
+
+    std::shared_ptr<LogSink> sink() const {return mySink;}
+    void setSink(std::shared_ptr<LogSink> sink) {mySink = sink;}
+
+    void log(const std::string& msg) const;
+
+    // Language backends call beginPhase before a plugin's input(), run() and
+    // output() and endPhase once it returns; the time in between is added to
+    // that phase. Backends that cannot separate the calls charge it to Run.
+    enum Phase { Input, Run, Output };
+    void beginPhase(Phase phase);
+    void endPhase();
+    const PhaseTimes& phaseTimes() const {return myPhases;}
+
+    // Same sink, label and allotment under another prefix.
+    ExecutionContext withPrefix(std::string prefix) const;
+
+    // The context installed for the calling thread, or the process default.
+    static ExecutionContext& current();
+    static ExecutionContext& processDefault();
+
+    // Installs a context as current for the calling thread until destroyed.
+    class Scope {
+    public:
+        explicit Scope(ExecutionContext& context);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        ExecutionContext* previous;
+    };
+
+private:
+    std::string myPrefix;
+    std::string myLabel;
+    std::shared_ptr<LogSink> mySink;
+    ResourceAllotment myAllotment;
+    PhaseTimes myPhases;
+    int myPhase = -1;
+    std::chrono::steady_clock::time_point myPhaseStart;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "FairShare.h"
+
+#include "Estimator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <tuple>
+
+namespace parallel {
+
+FairShare::FairShare(const ParallelBlockOptions& budget, const std::map<std::string, double>& weights)
+    : budget_(budget)
+    , weights_(weights)
+{
+}
+
+// The user a tenant belongs to: its name up to the first '/'.
+static std::string owner(const std::string& tenant) {
+    return tenant.substr(0, tenant.find('/'));
+}
+
+double FairShare::weight(const std::string& tenant) const {
+    auto it = weights_.find(owner(tenant));
+    return it == weights_.end() ? 1.0 : it->second;
+}
+
+bool FairShare::request(uint64_t id, const std::string& tenant, const PluginTask& task, double now) {
+    ParallelBlockOptions whole;
+    whole.workers = budget_.max_workers();
+    whole.memory = budget_.total_memory();
+    whole.gpu = budget_.total_gpu();
+    if (!ResourceBudget(whole).can_dispatch(task)) return false;
+
+    Lease lease;
+    lease.tenant = tenant;
+    lease.task = task;
+    lease.requested = now;
+    leases_[id] = lease;
+    finished_[tenant].tenant = tenant;
+    return true;
+}
+
+double FairShare::share(const std::string& tenant) const {
+    double workers = 0.0, memory = 0.0, gpu = 0.0;
+    for (const auto& entry : leases_) {
+        const Lease& lease = entry.second;
+        if (lease.granted < 0 || owner(lease.tenant) != owner(tenant)) continue;
+        workers += 1;
+        memory += lease.task.memory_hint > 0 ? lease.task.memory_hint : budget_.default_memory_per_worker();
+        gpu += lease.task.gpu_hint;
+    }
+    double dominant = 0.0;
+    if (budget_.max_workers() > 0) dominant = std::max(dominant, workers / budget_.max_workers());
+    if (budget_.total_memory() > 0) dominant = std::max(dominant, memory / budget_.total_memory());
+    if (budget_.total_gpu() > 0) dominant = std::max(dominant, gpu / budget_.total_gpu());
+    return dominant / weight(tenant);
+}
+
+std::vector<uint64_t> FairShare::grant(double now) {
+    std::vector<uint64_t> granted;
+    for (;;) {
+        // Each tenant's oldest request, the tenant furthest below its share first.
+        std::map<std::string, uint64_t> heads;
+        for (const auto& entry : leases_)
+            if (entry.second.granted < 0 && !heads.count(entry.second.tenant)) heads[entry.second.tenant] = entry.first;
+        std::vector<std::tuple<double, uint64_t>> order;
+        for (const auto& head : heads) order.emplace_back(share(head.first), head.second);
+        std::sort(order.begin(), order.end());
+
+        std::vector<RunningTask> running;
+        for (const auto& entry : leases_) {
+            const Lease& lease = entry.second;
+            if (lease.granted < 0) continue;
+            double end = lease.task.expected_seconds > 0 ? lease.granted + lease.task.expected_seconds
+                                                         : std::numeric_limits<double>::infinity();
+            running.push_back({&lease.task, end});
+        }
+
+        bool started = false;
+        std::unique_ptr<Reservation> reservation;
+        for (const auto& candidate : order) {
+            Lease& lease = leases_[std::get<1>(candidate)];
+            if (!budget_.can_dispatch(lease.task)) {
+                if (!reservation) reservation.reset(new Reservation(reserve(budget_, running, lease.task)));
+                continue;
+            }
+            if (reservation && !may_backfill(*reservation, lease.task, now)) continue;
+            budget_.acquire(lease.task);
+            lease.granted = now;
+            granted.push_back(std::get<1>(candidate));
+            started = true;
+            break;   // shares changed
+        }
+        if (!started) break;
+    }
+    return granted;
+}
+
+void FairShare::account(TenantUsage& usage, const Lease& lease, double until) const {
+    if (lease.granted < 0) {
+        usage.wait_seconds += until - lease.requested;
+        return;
+    }
+    double held = until - lease.granted;
+    size_t memory = lease.task.memory_hint > 0 ? lease.task.memory_hint : budget_.default_memory_per_worker();
+    usage.tasks++;
+    usage.wait_seconds += lease.granted - lease.requested;
+    usage.worker_seconds += held;
+    usage.memory_gb_seconds += held * memory / (1024.0 * 1024.0 * 1024.0);
+    usage.gpu_seconds += held * lease.task.gpu_hint;
+}
+
+void FairShare::release(uint64_t id, double now) {
+    auto it = leases_.find(id);
+    if (it == leases_.end()) return;
+    const Lease& lease = it->second;
+    // A withdrawn request only adds to the time waited.
+    account(finished_[lease.tenant], lease, now);
+    if (lease.granted >= 0) budget_.release(lease.task);
+    leases_.erase(it);
+}
+
+void FairShare::add_run(const std::string& tenant) {
+    finished_[tenant].tenant = tenant;
+    finished_[tenant].runs++;
+}
+
+std::vector<TenantUsage> FairShare::usage(double now) const {
+    std::vector<TenantUsage> all;
+    for (const auto& entry : finished_) {
+        TenantUsage usage = entry.second;
+        usage.weight = weight(entry.first);
+        for (const auto& live : leases_) {
+            if (live.second.tenant != entry.first) continue;
+            account(usage, live.second, now);
+            if (live.second.granted < 0) usage.queued++;
+            else usage.running++;
+        }
+        usage.share = share(entry.first);
+        all.push_back(usage);
+    }
+    return all;
+}
+
+bool parse_weights(const std::string& text, std::map<std::string, double>& weights, std::string& error) {
+    std::istringstream in(text);
+    std::string entry;
+    while (std::getline(in, entry, ',')) {
+        if (entry.empty()) continue;
+        size_t colon = entry.rfind(':');
+        char* end = NULL;
+        double weight = colon == std::string::npos ? 0.0 : strtod(entry.c_str() + colon + 1, &end);
+        if (colon == std::string::npos || colon == 0 || end == entry.c_str() + colon + 1 || *end != '\0' || weight <= 0) {
+            error = "bad tenant weight '" + entry + "' (expected NAME:WEIGHT with WEIGHT > 0)";
+            return false;
+        }
+        weights[entry.substr(0, colon)] = weight;
+    }
+    return true;
+}
+
+std::string format_usage(const std::vector<TenantUsage>& usage, const ResourceBudget& budget) {
+    std::ostringstream out;
+    out << "Budget: " << budget.max_workers() << " workers, " << format_bytes(budget.total_memory());
+    if (budget.total_gpu() > 0) out << ", " << budget.total_gpu() << " GPUs";
+    out << "; in use: " << budget.active_workers() << " workers, " << format_bytes(budget.used_memory());
+    if (budget.total_gpu() > 0) out << ", " << budget.used_gpu() << " GPUs";
+    out << "\n";
+    if (usage.empty()) return out.str() + "No runs submitted yet.\n";
+
+    char line[256];
+    snprintf(line, sizeof(line), "%-16s %6s %5s %6s %7s %6s %10s %10s %10s %6s\n",
+             "Tenant", "Weight", "Runs", "Tasks", "Running", "Queued", "CPU", "Mem GB-h", "Waited", "Share");
+    out << line;
+    for (const auto& u : usage) {
+        snprintf(line, sizeof(line), "%-16s %6g %5zu %6zu %7zu %6zu %10s %10.2f %10s %5.0f%%\n",
+                 u.tenant.c_str(), u.weight, u.runs, u.tasks, u.running, u.queued,
+                 format_seconds(u.worker_seconds).c_str(), u.memory_gb_seconds / 3600.0,
+                 format_seconds(u.wait_seconds).c_str(), 100.0 * u.share);
+        out << line;
+    }
+    return out.str();
+}
+
+} // namespace parallel
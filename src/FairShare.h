@@ -0,0 +1,96 @@
+#ifndef FAIR_SHARE_H
+#define FAIR_SHARE_H
+
+#include "ParallelTypes.h"
+#include "ResourceBudget.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+// What one tenant has used of a shared budget. Seconds count from when a
+// task was granted its resources to when it gave them back, so a task
+// still running counts up to now.
+struct TenantUsage {
+    std::string tenant;
+    double weight = 1.0;
+    size_t runs = 0;                    // configs submitted
+    size_t tasks = 0;                   // tasks granted, including running ones
+    size_t running = 0;
+    size_t queued = 0;
+    double worker_seconds = 0.0;
+    double memory_gb_seconds = 0.0;     // memory held (memory= hint, else the per-worker default)
+    double gpu_seconds = 0.0;
+    double wait_seconds = 0.0;          // from request to grant, including requests still queued
+    double share = 0.0;                 // dominant share of the budget held now, over weight
+};
+
+// Shares one ResourceBudget among the pipelines of several tenants. Tasks
+// ask for their resources (request), are granted them when the policy
+// allows (grant) and give them back when they end (release).
+//
+// The next task granted is the oldest request of the tenant with the
+// smallest weighted dominant share: the largest fraction of workers,
+// memory or GPUs it holds, divided by its weight. A tenant with nothing
+// running therefore goes ahead of one holding most of the machine, however
+// many tasks the latter has queued. When that task does not fit yet, room
+// is reserved for it and other tenants' tasks are backfilled around it
+// under the same rule as ParallelScheduler, so it cannot be starved.
+//
+// A tenant named "user/label" is one of user's: its tasks count towards
+// user's share and weight, so splitting work over labels separates it in
+// usage() without adding to what the user gets.
+class FairShare {
+public:
+    // By user; tenants without a weight have weight 1.
+    FairShare(const ParallelBlockOptions& budget, const std::map<std::string, double>& weights = {});
+
+    // Queues a request on behalf of tenant; now is on the caller's clock,
+    // in seconds. False (and nothing queued) if the task could never fit
+    // the budget, even with nothing else running.
+    bool request(uint64_t id, const std::string& tenant, const PluginTask& task, double now);
+
+    // The queued requests that may start now, in the order granted.
+    std::vector<uint64_t> grant(double now);
+
+    // Ends a granted request, or withdraws a queued one.
+    void release(uint64_t id, double now);
+
+    // Counts a submitted config towards the tenant's runs.
+    void add_run(const std::string& tenant);
+
+    double weight(const std::string& tenant) const;
+    const ResourceBudget& budget() const { return budget_; }
+
+    // Every tenant seen so far, by name.
+    std::vector<TenantUsage> usage(double now) const;
+
+private:
+    struct Lease {
+        std::string tenant;
+        PluginTask task;
+        double requested = 0.0;
+        double granted = -1.0;      // < 0: still queued
+    };
+
+    double share(const std::string& tenant) const;
+    void account(TenantUsage& usage, const Lease& lease, double until) const;
+
+    ResourceBudget budget_;
+    std::map<std::string, double> weights_;
+    std::map<uint64_t, Lease> leases_;              // queued and granted, oldest first
+    std::map<std::string, TenantUsage> finished_;   // totals of released leases
+};
+
+// "alice:2,bob:1,cohort:0.5"; false on a malformed entry or a weight <= 0.
+bool parse_weights(const std::string& text, std::map<std::string, double>& weights, std::string& error);
+
+// The per-tenant table `pluma tenants` prints.
+std::string format_usage(const std::vector<TenantUsage>& usage, const ResourceBudget& budget);
+
+} // namespace parallel
+
+#endif
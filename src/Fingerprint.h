@@ -0,0 +1,36 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace parallel {
+
+// Incremental SHA-256, used to content-address plugin artifacts and files.
+class Sha256 {
+public:
+    Sha256();
+
+    void update(const void* data, size_t len);
+    void update(const std::string& s);
+    std::string hex_digest();   // finalizes; the object must not be updated afterwards
+
+private:
+    void transform(const uint8_t* block);
+
+    uint32_t state_[8];
+    uint8_t buffer_[64];
+    size_t buffer_len_ = 0;
+    uint64_t total_len_ = 0;
+};
+
+std::string fingerprint_string(const std::string& s);
+
+// Hashes a regular file's bytes, or a directory's relative entry names and
+// file contents in sorted order. A missing path hashes to the empty string.
+std::string fingerprint_path(const std::string& path);
+
+} // namespace parallel
+
+#endif
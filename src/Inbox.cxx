@@ -0,0 +1,125 @@
+#include "Inbox.h"
+#include "SampleSweep.h"
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+namespace parallel {
+
+namespace fs = std::filesystem;
+
+// A path that starts with {path} stands for the sample itself, not a file
+// under the Prefix.
+static std::string expand_path(const std::string& field, const std::string& prefix,
+                               const std::string& sample, const std::string& path) {
+    std::string raw = field;
+    if (!prefix.empty() && raw.compare(0, prefix.size(), prefix) == 0 &&
+        raw.compare(prefix.size(), 6, "{path}") == 0) {
+        raw = raw.substr(prefix.size());
+    }
+    return expand_sweep_line(raw, sample, path);
+}
+
+std::vector<PluginTask> sample_tasks(const std::vector<PluginTask>& steps, const std::string& path) {
+    std::string sample = sample_name(path);
+    std::vector<PluginTask> tasks;
+    for (const auto& step : steps) {
+        PluginTask task = step;
+        task.inputfile = expand_path(step.inputfile, step.prefix, sample, path);
+        task.outputfile = expand_path(step.outputfile, step.prefix, sample, path);
+        task.journal_id.clear();
+        tasks.push_back(task);
+    }
+    return tasks;
+}
+
+std::vector<std::string> inbox_step_errors(const std::vector<PluginTask>& steps) {
+    std::vector<std::string> errors;
+    for (const auto& step : steps) {
+        if (step.outputfile.find("{sample}") != std::string::npos ||
+            step.outputfile.find("{path}") != std::string::npos) {
+            continue;
+        }
+        errors.push_back("outputfile " + step.outputfile + " of plugin " + step.name +
+                         " names neither {sample} nor {path}, so every sample would write it");
+    }
+    return errors;
+}
+
+InboxWatcher::InboxWatcher(const std::string& dir, double idle_seconds)
+    : dir_(dir), idle_seconds_(idle_seconds), last_arrival_(std::chrono::steady_clock::now()) {
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        error_ = std::string("cannot start inotify: ") + strerror(errno);
+        return;
+    }
+    // Watch first, then list, so nothing dropped in between is missed.
+    if (inotify_add_watch(fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) < 0) {
+        error_ = "cannot watch inbox " + dir + ": " + strerror(errno);
+        return;
+    }
+    std::vector<std::string> present;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        present.push_back(it->path().filename().string());
+    }
+    std::sort(present.begin(), present.end());
+    for (const auto& name : present) add(name);
+}
+
+InboxWatcher::~InboxWatcher() {
+    if (fd_ >= 0) close(fd_);
+}
+
+void InboxWatcher::add(const std::string& name) {
+    if (name.empty() || name[0] == '.' || !seen_.insert(name).second) return;
+    queue_.push_back((fs::path(dir_) / name).string());
+    last_arrival_ = std::chrono::steady_clock::now();
+}
+
+bool InboxWatcher::read_events(int timeout_ms) {
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) <= 0) return false;
+
+    alignas(struct inotify_event) char buf[16 * (sizeof(struct inotify_event) + 256)];
+    ssize_t n;
+    while ((n = read(fd_, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + n;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            if (event->len > 0) add(event->name);
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return true;
+}
+
+BatchSource::Status InboxWatcher::next(std::string& path, int timeout_ms) {
+    if (!error_.empty()) return BatchSource::Done;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (queue_.empty()) {
+        auto now = std::chrono::steady_clock::now();
+        int wait = timeout_ms < 0 ? -1 : static_cast<int>(
+            std::max<long long>(0, std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()));
+        if (idle_seconds_ > 0) {
+            double idle = std::chrono::duration<double>(now - last_arrival_).count();
+            if (idle >= idle_seconds_) return BatchSource::Done;
+            int until_idle = static_cast<int>((idle_seconds_ - idle) * 1000) + 1;
+            wait = wait < 0 ? until_idle : std::min(wait, until_idle);
+        }
+        if (!read_events(wait) && queue_.empty() && timeout_ms >= 0 &&
+            std::chrono::steady_clock::now() >= deadline) {
+            return BatchSource::Waiting;
+        }
+    }
+    path = queue_.front();
+    queue_.pop_front();
+    produced_++;
+    return BatchSource::Ready;
+}
+
+} // namespace parallel
@@ -0,0 +1,72 @@
+#ifndef INBOX_H
+#define INBOX_H
+
+#include "ParallelScheduler.h"
+#include "ParallelTypes.h"
+
+#include <chrono>
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+// With --inbox=DIR the config is a template for one sample, its paths
+// naming the sample with the placeholders of a Sweep:
+//
+//   Plugin Trim inputfile {path} outputfile out/{sample}.trimmed.fq
+//   Plugin Align inputfile out/{sample}.trimmed.fq outputfile out/{sample}.bam
+//
+// and every file that arrives in DIR is pushed through all of its steps.
+// {path} is the sample's path in the inbox, taken as is rather than under
+// the Prefix, and {sample} its sample_name.
+
+// The config's steps for one sample, placeholders filled in.
+std::vector<PluginTask> sample_tasks(const std::vector<PluginTask>& steps, const std::string& path);
+
+// Steps whose outputfile does not name the sample, so that every sample
+// would overwrite the same file: one message per step.
+std::vector<std::string> inbox_step_errors(const std::vector<PluginTask>& steps);
+
+// Watches a directory with inotify and hands out, in order of arrival, the
+// samples dropped into it: files once they are closed after writing and
+// files or directories renamed into it. Whatever is in the directory when
+// the watch starts comes first, in sorted order. Names starting with '.'
+// are ignored, so writers can create .name and rename it when complete.
+class InboxWatcher {
+public:
+    // idle_seconds > 0: next() reports Done once no sample has arrived for
+    // that long; otherwise the watch lasts until the process ends.
+    explicit InboxWatcher(const std::string& dir, double idle_seconds = 0.0);
+    ~InboxWatcher();
+
+    InboxWatcher(const InboxWatcher&) = delete;
+    InboxWatcher& operator=(const InboxWatcher&) = delete;
+
+    // Waits up to timeout_ms (-1: as long as it takes) for the next sample.
+    BatchSource::Status next(std::string& path, int timeout_ms);
+
+    // Why the directory cannot be watched; empty if fine.
+    const std::string& error() const { return error_; }
+
+    // Samples handed out so far.
+    size_t produced() const { return produced_; }
+
+private:
+    void add(const std::string& name);
+    bool read_events(int timeout_ms);
+
+    std::string dir_;
+    double idle_seconds_;
+    int fd_ = -1;
+    std::deque<std::string> queue_;
+    std::set<std::string> seen_;
+    std::chrono::steady_clock::time_point last_arrival_;
+    size_t produced_ = 0;
+    std::string error_;
+};
+
+} // namespace parallel
+
+#endif
@@ -0,0 +1,116 @@
+#include "IntermediateCollector.h"
+#include "DependencyGraph.h"
+#include "Estimator.h"
+
+#include <filesystem>
+
+namespace parallel {
+
+namespace fs = std::filesystem;
+
+IntermediateCollector::IntermediateCollector(Regenerable regenerable, const std::string& move_to)
+    : regenerable_(std::move(regenerable)), move_to_(move_to) {}
+
+// A step by what it runs, so a reader is known again when it completes.
+std::string IntermediateCollector::step_key(const PluginTask& task) {
+    return task.name + '\n' + fs::path(task.inputfile).lexically_normal().generic_string() + '\n' +
+           fs::path(task.outputfile).lexically_normal().generic_string();
+}
+
+void IntermediateCollector::add_steps(const std::vector<PluginTask>& steps) {
+    for (size_t i = 0; i < steps.size(); i++) {
+        if (!steps[i].intermediate || steps[i].outputfile.empty()) continue;
+        Entry& entry = entries_[steps[i].outputfile];
+        entry.producer = steps[i];
+        for (size_t j = i + 1; j < steps.size(); j++) {
+            if (steps[j].inputfile.empty() || !paths_overlap(steps[j].inputfile, steps[i].outputfile)) continue;
+            readers_.emplace(step_key(steps[j]), steps[i].outputfile);
+            entry.readers++;
+        }
+        entry.read = entry.readers > 0;
+    }
+}
+
+std::vector<std::string> IntermediateCollector::completed(const PluginTask& task) {
+    // Only the task's own output and those it was counted as reading can
+    // have become collectable.
+    std::vector<std::string> candidates;
+    auto it = entries_.find(task.outputfile);
+    if (it != entries_.end() && it->second.producer.name == task.name) {
+        it->second.producer = task;
+        it->second.produced = true;
+        candidates.push_back(it->first);
+    }
+    auto reading = readers_.equal_range(step_key(task));
+    for (auto r = reading.first; r != reading.second; ++r) {
+        auto e = entries_.find(r->second);
+        if (e == entries_.end()) continue;
+        if (e->second.readers > 0) e->second.readers--;
+        e->second.completed_readers.push_back(task);
+        candidates.push_back(r->second);
+    }
+    readers_.erase(reading.first, reading.second);
+
+    error_.clear();
+    std::vector<std::string> collected;
+    for (const std::string& path : candidates) {
+        auto e = entries_.find(path);
+        if (e == entries_.end()) continue;
+        const Entry& entry = e->second;
+        if (!entry.read || !entry.produced || entry.readers > 0 || !regenerable_(entry.producer)) continue;
+        // Already gone: collected by the run a resumed one continues.
+        std::error_code ec;
+        if (!fs::exists(path, ec)) {
+            entries_.erase(e);
+            continue;
+        }
+        if (collecting_) collecting_(path, entry.completed_readers);
+        if (collect(path)) {
+            collected.push_back(path);
+            entries_.erase(e);
+        }
+    }
+    return collected;
+}
+
+void IntermediateCollector::forget(const std::vector<PluginTask>& steps) {
+    for (const PluginTask& step : steps) {
+        auto it = entries_.find(step.outputfile);
+        if (it != entries_.end() && it->second.producer.name == step.name) entries_.erase(it);
+        readers_.erase(step_key(step));
+    }
+}
+
+std::string IntermediateCollector::moved_path(const std::string& path) const {
+    fs::path relative = fs::path(path).lexically_normal().relative_path();
+    return (fs::path(move_to_) / relative).string();
+}
+
+bool IntermediateCollector::collect(const std::string& path) {
+    std::error_code ec;
+    if (!fs::exists(path, ec)) return true;
+    size_t bytes = input_size(path);
+    if (move_to_.empty()) {
+        fs::remove_all(path, ec);
+    } else {
+        fs::path target = moved_path(path);
+        fs::create_directories(target.parent_path(), ec);
+        fs::remove_all(target, ec);
+        ec.clear();
+        fs::rename(path, target, ec);
+        if (ec) {
+            // Another filesystem: copy, then remove the original.
+            ec.clear();
+            fs::copy(path, target, fs::copy_options::recursive, ec);
+            if (!ec) fs::remove_all(path, ec);
+        }
+    }
+    if (ec) {
+        error_ = "cannot collect intermediate " + path + ": " + ec.message();
+        return false;
+    }
+    collected_bytes_ += bytes;
+    return true;
+}
+
+} // namespace parallel
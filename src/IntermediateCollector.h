@@ -0,0 +1,88 @@
+#ifndef INTERMEDIATE_COLLECTOR_H
+#define INTERMEDIATE_COLLECTOR_H
+
+#include "ParallelTypes.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+// Reference counts the outputs of steps marked intermediate=yes by the
+// later steps that read them, and collects each one (deletes it, or moves
+// it out of the way) as soon as the last of those readers has completed,
+// so a run keeps only its working set on scratch disk:
+//
+//   Plugin Trim inputfile reads.fq outputfile trimmed.fq intermediate=yes
+//   Plugin Align inputfile trimmed.fq outputfile aligned.bam
+//
+// An output is collected only if `regenerable` says its producer could
+// recreate it (a later --resume re-runs the producer when the file is
+// missing); one nothing reads, or whose producer or a reader failed or
+// never ran, stays. Its readers are the steps after its producer whose
+// inputs overlap it, as ParallelScheduler infers dependencies; only their
+// completing counts, not that of other steps reading the same path.
+class IntermediateCollector {
+public:
+    using Regenerable = std::function<bool(const PluginTask& producer)>;
+    // Told of a path about to be collected, with the readers that completed it.
+    using Collecting = std::function<void(const std::string& path, const std::vector<PluginTask>& readers)>;
+
+    // With move_to empty collected files are deleted; otherwise they are
+    // moved to the same relative path under move_to.
+    explicit IntermediateCollector(Regenerable regenerable, const std::string& move_to = "");
+
+    // Called before each file is collected, while it is still there.
+    void on_collect(Collecting collecting) { collecting_ = std::move(collecting); }
+
+    // Registers the intermediate outputs among `steps`, given in execution
+    // order, with the number of later steps reading each.
+    void add_steps(const std::vector<PluginTask>& steps);
+
+    // Called when `task` has completed, or was skipped because a resumed
+    // run completed it before: its intermediate output becomes collectable
+    // and, if it is a registered reader of one, it no longer needs its
+    // input. Returns the paths collected as a result, having collected them.
+    std::vector<std::string> completed(const PluginTask& task);
+
+    // Stops tracking the outputs of `steps` and their reads, once none of
+    // them will complete any more (an inbox sample that has ended): what
+    // is left of them is never collected.
+    void forget(const std::vector<PluginTask>& steps);
+
+    // Where a collected path ends up when moved.
+    std::string moved_path(const std::string& path) const;
+
+    bool moves() const { return !move_to_.empty(); }
+    size_t tracked() const { return entries_.size(); }
+    size_t collected_bytes() const { return collected_bytes_; }
+
+    // Why the last collection failed; empty if it did not.
+    const std::string& error() const { return error_; }
+
+private:
+    struct Entry {
+        PluginTask producer;
+        size_t readers = 0;      // later steps yet to complete
+        bool read = false;       // some later step reads it; otherwise it is a result and stays
+        bool produced = false;
+        std::vector<PluginTask> completed_readers;
+    };
+
+    static std::string step_key(const PluginTask& task);
+    bool collect(const std::string& path);
+
+    Regenerable regenerable_;
+    Collecting collecting_;
+    std::string move_to_;
+    std::map<std::string, Entry> entries_;   // by output path
+    std::multimap<std::string, std::string> readers_;   // step_key() of a reader -> output it has yet to read
+    size_t collected_bytes_ = 0;
+    std::string error_;
+};
+
+} // namespace parallel
+
+#endif
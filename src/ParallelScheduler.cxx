@@ -1,80 +1,269 @@
 #include "ParallelScheduler.h"
 
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <poll.h>
 #include <unistd.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <limits>
+#include <memory>
 #include <map>
+#include <set>
+#include <tuple>
 #include <iostream>
 
 namespace parallel {
 
+// Peak RSS of a reaped worker; Linux reports ru_maxrss in kilobytes.
+static size_t max_rss_bytes(const struct rusage& usage) {
+    return usage.ru_maxrss > 0 ? static_cast<size_t>(usage.ru_maxrss) * 1024 : 0;
+}
+
+// Forks a child that runs fn(task), with stdout and stderr on /dev/null
+// unless output is Inherit, and exits with its return value. Returns the
+// child's pid, or -1.
+static pid_t spawn_worker(const PluginTask& task, const ParallelScheduler::WorkerFunction& fn,
+                          ParallelScheduler::WorkerOutput output) {
+    sigset_t block_mask, prev_mask;
+    sigemptyset(&block_mask);
+    sigaddset(&block_mask, SIGTERM);
+    sigaddset(&block_mask, SIGINT);
+
+    sigprocmask(SIG_BLOCK, &block_mask, &prev_mask);
+    pid_t pid = fork();
+    if (pid == 0) {
+        struct sigaction sa = {};
+        sa.sa_handler = SIG_DFL;
+        sigaction(SIGTERM, &sa, nullptr);
+        sigaction(SIGINT, &sa, nullptr);
+
+        if (output == ParallelScheduler::WorkerOutput::Discard) {
+            int devnull = open("/dev/null", O_WRONLY);
+            if (devnull >= 0) {
+                dup2(devnull, STDOUT_FILENO);
+                dup2(devnull, STDERR_FILENO);
+                close(devnull);
+            }
+        }
+
+        sigprocmask(SIG_SETMASK, &prev_mask, nullptr);
+
+        int rc = fn(task);
+        // _exit() skips the stdio buffers' flush at exit.
+        std::cout.flush();
+        fflush(nullptr);
+        _exit(rc);
+    }
+    sigprocmask(SIG_SETMASK, &prev_mask, nullptr);
+    return pid;
+}
+
+// Sleeps until one of pids may have exited or timeout_ms has passed (-1: no
+// limit). Each is watched through a pidfd where the kernel has them, else
+// they are looked at again every few milliseconds.
+static void wait_for_exit(const std::vector<pid_t>& pids, int timeout_ms) {
+    const int recheck_ms = 10;
+    if (pids.empty()) return;
+    std::vector<struct pollfd> fds;
+#ifdef SYS_pidfd_open
+    for (pid_t pid : pids) {
+        int fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+        if (fd < 0) break;
+        fds.push_back({fd, POLLIN, 0});
+    }
+#endif
+    if (fds.size() == pids.size()) poll(fds.data(), fds.size(), timeout_ms);
+    else poll(nullptr, 0, timeout_ms < 0 || timeout_ms > recheck_ms ? recheck_ms : timeout_ms);
+    for (const struct pollfd& fd : fds) close(fd.fd);
+}
+
+// Reaps one of the running workers, waiting up to timeout_ms for one to
+// exit (-1: for as long as it takes). Returns its pid, or 0 if none exited
+// in time. Only the workers' own pids are waited for: wait4(-1) would also
+// take the exit status of any other child of the process, such as an
+// Engine run or one the program embedding libpluma forked itself.
+template <class Workers>
+static pid_t reap_worker(const Workers& running, int timeout_ms, int& status, struct rusage& usage) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::vector<pid_t> pids;
+    for (const auto& worker : running) pids.push_back(worker.first);
+    for (;;) {
+        for (pid_t pid : pids) {
+            if (wait4(pid, &status, WNOHANG, &usage) == pid) return pid;
+        }
+        int wait_ms = -1;
+        if (timeout_ms >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) return 0;
+            wait_ms = static_cast<int>(left);
+        }
+        wait_for_exit(pids, wait_ms);
+    }
+}
+
+std::vector<double> critical_path_lengths(const TaskGraph& graph) {
+    const size_t n = graph.tasks.size();
+    std::vector<std::vector<size_t>> dependents(n);
+    std::vector<size_t> pending(n, 0);   // dependents not yet measured
+    for (size_t i = 0; i < n; i++) {
+        for (size_t dep : graph.dependencies[i]) {
+            dependents[dep].push_back(i);
+            pending[dep]++;
+        }
+    }
+
+    // Measure tasks from the sinks back, each once all its dependents are.
+    std::vector<double> length(n, 0.0);
+    std::vector<size_t> stack;
+    for (size_t i = 0; i < n; i++) {
+        if (pending[i] == 0) stack.push_back(i);
+    }
+    while (!stack.empty()) {
+        size_t i = stack.back();
+        stack.pop_back();
+        double longest = 0.0;
+        for (size_t d : dependents[i]) longest = std::max(longest, length[d]);
+        length[i] = graph.tasks[i].expected_seconds + longest;
+        for (size_t dep : graph.dependencies[i]) {
+            if (--pending[dep] == 0) stack.push_back(dep);
+        }
+    }
+    return length;
+}
+
 SchedulerResult ParallelScheduler::run(const ParallelBlock& block, WorkerFunction fn) {
+    TaskGraph graph;
+    graph.tasks = block.tasks;
+    graph.dependencies.resize(block.tasks.size());
+    return run_graph(graph, block.options, fn);
+}
+
+SchedulerResult ParallelScheduler::run_graph(const TaskGraph& graph, const ParallelBlockOptions& options,
+                                             WorkerFunction fn) {
     SchedulerResult result;
-    if (block.tasks.empty()) return result;
+    if (graph.tasks.empty()) return result;
 
     auto wall_start = std::chrono::steady_clock::now();
-    ResourceBudget budget(block.options);
+    ResourceBudget budget(resolve_defaults(options));
 
     struct RunningWorker {
         size_t task_index;
         std::chrono::steady_clock::time_point start_time;
     };
 
+    const size_t n = graph.tasks.size();
+    std::vector<size_t> waiting_on(n, 0);
+    std::vector<std::vector<size_t>> dependents(n);
+    for (size_t i = 0; i < n; i++) {
+        waiting_on[i] = graph.dependencies[i].size();
+        for (size_t dep : graph.dependencies[i]) dependents[dep].push_back(i);
+    }
+
+    // Ready tasks are dispatched longest critical path first, then lowest
+    // index (config order) first.
+    std::vector<double> priority(n, 0.0);
+    if (options.order == DispatchOrder::Longest) priority = critical_path_lengths(graph);
+    std::set<std::pair<double, size_t>> ready;
+    auto make_ready = [&](size_t idx) { ready.insert({-priority[idx], idx}); };
+    for (size_t i = 0; i < n; i++) {
+        if (waiting_on[i] == 0) make_ready(i);
+    }
+
     std::map<pid_t, RunningWorker> running;
-    size_t next_task = 0;
     bool abort_flag = false;
 
-    sigset_t block_mask, prev_mask;
-    sigemptyset(&block_mask);
-    sigaddset(&block_mask, SIGTERM);
-    sigaddset(&block_mask, SIGINT);
-
-    auto try_dispatch = [&]() {
-        while (next_task < block.tasks.size() && !abort_flag) {
-            const auto& task = block.tasks[next_task];
-            if (!budget.can_dispatch(task)) break;
+    auto make_result = [&](size_t idx, int exit_code) {
+        PluginResult pr;
+        pr.name = graph.tasks[idx].name;
+        pr.task_index = idx;
+        pr.exit_code = exit_code;
+        return pr;
+    };
 
-            budget.acquire(task);
-            auto task_start = std::chrono::steady_clock::now();
+    auto on_success = [&](size_t idx) {
+        for (size_t d : dependents[idx]) {
+            if (--waiting_on[d] == 0) make_ready(d);
+        }
+    };
 
-            sigprocmask(SIG_BLOCK, &block_mask, &prev_mask);
-            pid_t pid = fork();
-            if (pid == 0) {
-                struct sigaction sa = {};
-                sa.sa_handler = SIG_DFL;
-                sigaction(SIGTERM, &sa, nullptr);
-                sigaction(SIGINT, &sa, nullptr);
-
-                int devnull = open("/dev/null", O_WRONLY);
-                if (devnull >= 0) {
-                    dup2(devnull, STDOUT_FILENO);
-                    dup2(devnull, STDERR_FILENO);
-                    close(devnull);
-                }
+    // Everything downstream of a failed task can never run. A task below
+    // several failed ones is skipped once for the whole run.
+    std::vector<bool> skipped(n, false);
+    auto on_failure = [&](size_t idx) {
+        std::vector<size_t> stack(dependents[idx].begin(), dependents[idx].end());
+        while (!stack.empty()) {
+            size_t d = stack.back();
+            stack.pop_back();
+            if (skipped[d]) continue;
+            skipped[d] = true;
+            PluginResult pr = make_result(d, -1);
+            pr.skipped = true;
+            result.skipped.push_back(pr);
+            for (size_t dd : dependents[d]) stack.push_back(dd);
+        }
+        if (options.fail_mode == FailMode::Fast) {
+            abort_flag = true;
+        }
+    };
 
-                sigprocmask(SIG_SETMASK, &prev_mask, nullptr);
+    auto seconds_since_start = [&](std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration<double>(t - wall_start).count();
+    };
 
-                int rc = fn(task);
-                _exit(rc);
+    // The first ready task that does not fit gets a reservation; tasks
+    // behind it are backfilled only where they cannot delay it.
+    auto try_dispatch = [&]() {
+        std::unique_ptr<Reservation> reservation;
+        double now = seconds_since_start(std::chrono::steady_clock::now());
+        for (auto it = ready.begin(); it != ready.end() && !abort_flag;) {
+            size_t idx = it->second;
+            const auto& task = graph.tasks[idx];
+            if (!budget.can_dispatch(task)) {
+                if (running.empty()) {
+                    // Nothing is running, so this task can never fit the budget.
+                    it = ready.erase(it);
+                    result.failed.push_back(make_result(idx, -1));
+                    on_failure(idx);
+                    continue;
+                }
+                if (!options.backfill) break;
+                if (!reservation) {
+                    std::vector<RunningTask> busy;
+                    for (const auto& [pid, w] : running) {
+                        const PluginTask& t = graph.tasks[w.task_index];
+                        double end = t.expected_seconds > 0
+                            ? std::max(now, seconds_since_start(w.start_time) + t.expected_seconds)
+                            : std::numeric_limits<double>::infinity();
+                        busy.push_back({&t, end});
+                    }
+                    reservation.reset(new Reservation(reserve(budget, busy, task)));
+                }
+                ++it;
+                continue;
+            }
+            if (reservation && !may_backfill(*reservation, task, now)) {
+                ++it;
+                continue;
             }
-            sigprocmask(SIG_SETMASK, &prev_mask, nullptr);
 
+            it = ready.erase(it);
+            budget.acquire(task);
+            auto task_start = std::chrono::steady_clock::now();
+
+            pid_t pid = spawn_worker(task, fn, output_);
             if (pid > 0) {
-                running[pid] = {next_task, task_start};
-                next_task++;
+                running[pid] = {idx, task_start};
             } else {
                 budget.release(task);
-                PluginResult pr;
-                pr.name = task.name;
-                pr.exit_code = -1;
-                result.failed.push_back(pr);
-                next_task++;
-                if (block.options.fail_mode == FailMode::Fast) {
-                    abort_flag = true;
-                }
+                result.failed.push_back(make_result(idx, -1));
+                on_failure(idx);
             }
         }
     };
@@ -85,7 +274,13 @@ SchedulerResult ParallelScheduler::run(const ParallelBlock& block, WorkerFunctio
         }
         for (auto& [pid, w] : running) {
             int st;
-            waitpid(pid, &st, 0);
+            struct rusage usage = {};
+            wait4(pid, &st, 0, &usage);
+            PluginResult pr = make_result(w.task_index, -1);
+            pr.elapsed_seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - w.start_time).count();
+            pr.peak_rss = max_rss_bytes(usage);
+            result.failed.push_back(pr);
         }
         running.clear();
     };
@@ -94,9 +289,8 @@ SchedulerResult ParallelScheduler::run(const ParallelBlock& block, WorkerFunctio
 
     while (!running.empty()) {
         int status;
-        pid_t finished = waitpid(-1, &status, 0);
-        if (finished <= 0) continue;
-
+        struct rusage usage = {};
+        pid_t finished = reap_worker(running, -1, status, usage);
         auto it = running.find(finished);
         if (it == running.end()) continue;
 
@@ -104,21 +298,20 @@ SchedulerResult ParallelScheduler::run(const ParallelBlock& block, WorkerFunctio
         double elapsed = std::chrono::duration<double>(
             std::chrono::steady_clock::now() - it->second.start_time).count();
 
-        const auto& task = block.tasks[idx];
-        budget.release(task);
+        budget.release(graph.tasks[idx]);
         running.erase(it);
 
-        PluginResult pr;
-        pr.name = task.name;
+        PluginResult pr = make_result(idx, WIFEXITED(status) ? WEXITSTATUS(status) : -1);
         pr.elapsed_seconds = elapsed;
-        pr.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        pr.peak_rss = max_rss_bytes(usage);
 
         if (pr.exit_code == 0) {
             result.completed.push_back(pr);
+            on_success(idx);
         } else {
             result.failed.push_back(pr);
-            if (block.options.fail_mode == FailMode::Fast) {
-                abort_flag = true;
+            on_failure(idx);
+            if (options.fail_mode == FailMode::Fast) {
                 kill_all_running();
                 break;
             }
@@ -132,4 +325,318 @@ SchedulerResult ParallelScheduler::run(const ParallelBlock& block, WorkerFunctio
     return result;
 }
 
+SchedulerResult ParallelScheduler::run_stream(TaskSource& source, const ParallelBlockOptions& options,
+                                              WorkerFunction fn, ResultFunction on_result) {
+    SchedulerResult result;
+    auto wall_start = std::chrono::steady_clock::now();
+    ResourceBudget budget(resolve_defaults(options));
+
+    struct RunningWorker {
+        PluginTask task;
+        size_t task_index;
+        std::chrono::steady_clock::time_point start_time;
+    };
+
+    std::map<pid_t, RunningWorker> running;
+    PluginTask pending;              // pulled from the source, waiting for room
+    bool have_pending = false;
+    bool exhausted = false;
+    bool abort_flag = false;
+    size_t pending_index = 0, produced = 0;
+
+    auto finish = [&](const PluginTask& task, size_t idx, int exit_code, double elapsed, size_t peak_rss) {
+        PluginResult pr;
+        pr.name = task.name;
+        pr.task_index = idx;
+        pr.exit_code = exit_code;
+        pr.elapsed_seconds = elapsed;
+        pr.peak_rss = peak_rss;
+        if (exit_code != 0) {
+            result.failed.push_back(pr);
+            if (options.fail_mode == FailMode::Fast) abort_flag = true;
+        }
+        if (on_result) on_result(task, pr);
+    };
+
+    auto try_dispatch = [&]() {
+        while (!abort_flag) {
+            if (!have_pending) {
+                if (exhausted || !source.next(pending)) {
+                    exhausted = true;
+                    return;
+                }
+                have_pending = true;
+                pending_index = produced++;
+            }
+            if (!budget.can_dispatch(pending)) {
+                if (!running.empty()) return;
+                // Nothing is running, so this task can never fit the budget.
+                have_pending = false;
+                finish(pending, pending_index, -1, 0.0, 0);
+                continue;
+            }
+
+            have_pending = false;
+            budget.acquire(pending);
+            auto task_start = std::chrono::steady_clock::now();
+            pid_t pid = spawn_worker(pending, fn, output_);
+            if (pid > 0) {
+                running.emplace(pid, RunningWorker{std::move(pending), pending_index, task_start});
+            } else {
+                budget.release(pending);
+                finish(pending, pending_index, -1, 0.0, 0);
+            }
+        }
+    };
+
+    auto kill_all_running = [&]() {
+        for (auto& [pid, w] : running) {
+            kill(pid, SIGTERM);
+        }
+        for (auto& [pid, w] : running) {
+            int st;
+            struct rusage usage = {};
+            wait4(pid, &st, 0, &usage);
+            finish(w.task, w.task_index, -1, std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - w.start_time).count(), max_rss_bytes(usage));
+        }
+        running.clear();
+    };
+
+    try_dispatch();
+
+    while (!running.empty()) {
+        int status;
+        struct rusage usage = {};
+        pid_t finished = reap_worker(running, -1, status, usage);
+        auto it = running.find(finished);
+        if (it == running.end()) continue;
+
+        RunningWorker worker = std::move(it->second);
+        running.erase(it);
+        budget.release(worker.task);
+
+        double elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - worker.start_time).count();
+        finish(worker.task, worker.task_index, WIFEXITED(status) ? WEXITSTATUS(status) : -1, elapsed,
+               max_rss_bytes(usage));
+        if (abort_flag) {
+            kill_all_running();
+            break;
+        }
+
+        try_dispatch();
+    }
+
+    result.total_elapsed_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - wall_start).count();
+    return result;
+}
+
+SchedulerResult ParallelScheduler::run_batches(BatchSource& source, const ParallelBlockOptions& options,
+                                               WorkerFunction fn, ResultFunction on_result) {
+    // How long to wait for a new batch before checking on the workers again.
+    const int poll_ms = 100;
+
+    SchedulerResult result;
+    auto wall_start = std::chrono::steady_clock::now();
+    ResourceBudget budget(resolve_defaults(options));
+
+    // Tasks that have not ended yet, by their index over all batches.
+    struct Node {
+        PluginTask task;
+        size_t batch;
+        double priority;
+        size_t waiting_on;
+        std::vector<size_t> dependents;
+    };
+    struct RunningWorker {
+        size_t task_index;
+        std::chrono::steady_clock::time_point start_time;
+    };
+
+    std::map<size_t, Node> nodes;
+    std::set<std::tuple<size_t, double, size_t>> ready;   // (batch, -priority, index)
+    std::map<pid_t, RunningWorker> running;
+    size_t batches = 0, admitted = 0;
+    bool exhausted = false;
+    bool abort_flag = false;
+
+    auto make_ready = [&](size_t idx) {
+        const Node& node = nodes.at(idx);
+        ready.insert(std::make_tuple(node.batch, -node.priority, idx));
+    };
+
+    auto admit = [&](const TaskGraph& batch) {
+        std::vector<double> priority(batch.tasks.size(), 0.0);
+        if (options.order == DispatchOrder::Longest) priority = critical_path_lengths(batch);
+        size_t base = admitted;
+        for (size_t i = 0; i < batch.tasks.size(); i++) {
+            nodes[base + i] = Node{batch.tasks[i], batches, priority[i], batch.dependencies[i].size(), {}};
+            for (size_t dep : batch.dependencies[i]) nodes[base + dep].dependents.push_back(base + i);
+        }
+        for (size_t i = 0; i < batch.tasks.size(); i++) {
+            if (nodes[base + i].waiting_on == 0) make_ready(base + i);
+        }
+        admitted += batch.tasks.size();
+        batches++;
+    };
+
+    auto pull = [&](int timeout_ms) {
+        TaskGraph batch;
+        BatchSource::Status status = source.next(batch, timeout_ms);
+        if (status == BatchSource::Done) exhausted = true;
+        else if (status == BatchSource::Ready) admit(batch);
+        return status;
+    };
+
+    auto make_result = [&](size_t idx, int exit_code) {
+        PluginResult pr;
+        pr.name = nodes.at(idx).task.name;
+        pr.task_index = idx;
+        pr.exit_code = exit_code;
+        return pr;
+    };
+
+    auto on_success = [&](size_t idx) {
+        for (size_t d : nodes.at(idx).dependents) {
+            if (--nodes.at(d).waiting_on == 0) make_ready(d);
+        }
+        nodes.erase(idx);
+    };
+
+    // Everything downstream of a failed task, all in its batch, can never run.
+    auto on_failure = [&](size_t idx) {
+        std::vector<size_t> stack(nodes.at(idx).dependents);
+        nodes.erase(idx);
+        while (!stack.empty()) {
+            size_t d = stack.back();
+            stack.pop_back();
+            auto it = nodes.find(d);
+            if (it == nodes.end()) continue;
+            PluginResult pr = make_result(d, -1);
+            pr.skipped = true;
+            result.skipped.push_back(pr);
+            if (on_result) on_result(it->second.task, pr);
+            stack.insert(stack.end(), it->second.dependents.begin(), it->second.dependents.end());
+            nodes.erase(it);
+        }
+        if (options.fail_mode == FailMode::Fast) abort_flag = true;
+    };
+
+    auto fail = [&](size_t idx, PluginResult pr) {
+        result.failed.push_back(pr);
+        if (on_result) on_result(nodes.at(idx).task, pr);
+        on_failure(idx);
+    };
+
+    auto seconds_since_start = [&](std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration<double>(t - wall_start).count();
+    };
+
+    auto try_dispatch = [&]() {
+        std::unique_ptr<Reservation> reservation;
+        double now = seconds_since_start(std::chrono::steady_clock::now());
+        for (auto it = ready.begin(); it != ready.end() && !abort_flag;) {
+            size_t idx = std::get<2>(*it);
+            const PluginTask& task = nodes.at(idx).task;
+            if (!budget.can_dispatch(task)) {
+                if (running.empty()) {
+                    // Nothing is running, so this task can never fit the budget.
+                    it = ready.erase(it);
+                    fail(idx, make_result(idx, -1));
+                    continue;
+                }
+                if (!options.backfill) break;
+                if (!reservation) {
+                    std::vector<RunningTask> busy;
+                    for (const auto& [pid, w] : running) {
+                        const PluginTask& t = nodes.at(w.task_index).task;
+                        double end = t.expected_seconds > 0
+                            ? std::max(now, seconds_since_start(w.start_time) + t.expected_seconds)
+                            : std::numeric_limits<double>::infinity();
+                        busy.push_back({&t, end});
+                    }
+                    reservation.reset(new Reservation(reserve(budget, busy, task)));
+                }
+                ++it;
+                continue;
+            }
+            if (reservation && !may_backfill(*reservation, task, now)) {
+                ++it;
+                continue;
+            }
+
+            it = ready.erase(it);
+            budget.acquire(task);
+            auto task_start = std::chrono::steady_clock::now();
+            pid_t pid = spawn_worker(task, fn, output_);
+            if (pid > 0) {
+                running[pid] = {idx, task_start};
+            } else {
+                budget.release(task);
+                fail(idx, make_result(idx, -1));
+            }
+        }
+    };
+
+    auto reap = [&](pid_t pid, int status, const struct rusage& usage) {
+        auto it = running.find(pid);
+        if (it == running.end()) return;
+        size_t idx = it->second.task_index;
+        PluginResult pr = make_result(idx, WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+        pr.elapsed_seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - it->second.start_time).count();
+        pr.peak_rss = max_rss_bytes(usage);
+        budget.release(nodes.at(idx).task);
+        running.erase(it);
+
+        if (pr.exit_code != 0) {
+            fail(idx, pr);
+            return;
+        }
+        if (on_result) on_result(nodes.at(idx).task, pr);
+        on_success(idx);
+    };
+
+    while (!abort_flag) {
+        // Take every batch that has already arrived before choosing what to start.
+        while (!exhausted && pull(0) == BatchSource::Ready) {}
+        try_dispatch();
+        if (abort_flag) break;
+
+        if (running.empty()) {
+            if (exhausted) break;
+            pull(-1);
+            continue;
+        }
+
+        int status;
+        struct rusage usage = {};
+        pid_t finished = reap_worker(running, exhausted ? -1 : 0, status, usage);
+        if (finished > 0) reap(finished, status, usage);
+        else if (finished == 0) pull(poll_ms);
+    }
+
+    if (abort_flag) {
+        for (auto& [pid, w] : running) kill(pid, SIGTERM);
+        for (auto& [pid, w] : running) {
+            int st;
+            struct rusage usage = {};
+            wait4(pid, &st, 0, &usage);
+            PluginResult pr = make_result(w.task_index, -1);
+            pr.elapsed_seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - w.start_time).count();
+            pr.peak_rss = max_rss_bytes(usage);
+            result.failed.push_back(pr);
+            if (on_result) on_result(nodes.at(w.task_index).task, pr);
+        }
+        running.clear();
+    }
+
+    result.total_elapsed_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - wall_start).count();
+    return result;
+}
+
 } // namespace parallel
@@ -8,11 +8,79 @@
 
 namespace parallel {
 
+// Tasks produced one at a time; next() returns false once there are no more.
+class TaskSource {
+public:
+    virtual ~TaskSource() {}
+    virtual bool next(PluginTask& task) = 0;
+};
+
+// Groups of dependent tasks, such as the steps of one sample, that arrive
+// while a run is under way.
+class BatchSource {
+public:
+    enum Status { Ready, Waiting, Done };
+    virtual ~BatchSource() {}
+    // Waits up to timeout_ms (-1: as long as it takes) for the next batch.
+    // Ready: `batch` holds it, its dependencies indexing its own tasks.
+    // Waiting: nothing arrived in time. Done: nothing more will come.
+    virtual Status next(TaskGraph& batch, int timeout_ms) = 0;
+};
+
+// Expected seconds from the start of each task to the end of the longest
+// chain of dependents it heads: its own expected_seconds plus the longest
+// such length among the tasks that depend on it.
+std::vector<double> critical_path_lengths(const TaskGraph& graph);
+
 class ParallelScheduler {
 public:
     using WorkerFunction = std::function<int(const PluginTask&)>;
+    using ResultFunction = std::function<void(const PluginTask&, const PluginResult&)>;
+
+    // Where workers' stdout and stderr go. Discard sends them to /dev/null,
+    // so plugins running side by side do not interleave their output;
+    // Inherit keeps the scheduler's, for workers whose output is all they
+    // report, such as kitties running whole pipelines.
+    enum class WorkerOutput { Discard, Inherit };
+
+    explicit ParallelScheduler(WorkerOutput output = WorkerOutput::Discard) : output_(output) {}
 
     SchedulerResult run(const ParallelBlock& block, WorkerFunction fn);
+
+    // Runs every task as soon as all of its dependencies have completed,
+    // sharing one ResourceBudget built from `options`. Dependents of a
+    // failed task are reported in SchedulerResult::skipped. Of the ready
+    // tasks, the one heading the longest critical path starts first (ties,
+    // and every task under order=config, in config order). When that task
+    // does not fit, it is given a reservation and the tasks behind it are
+    // backfilled: started now if they fit and are not expected to delay it.
+    SchedulerResult run_graph(const TaskGraph& graph, const ParallelBlockOptions& options, WorkerFunction fn);
+
+    // Runs independent tasks pulled from `source` only when the budget has
+    // room for them, so at most one task beyond those running is held at any
+    // time, and tasks start in the order the source produces them. Each
+    // finished task is passed to `on_result` rather than kept:
+    // only SchedulerResult::failed is filled in, and task_index counts tasks
+    // in the order the source produced them.
+    SchedulerResult run_stream(TaskSource& source, const ParallelBlockOptions& options,
+                               WorkerFunction fn, ResultFunction on_result = ResultFunction());
+
+    // Runs the batches pulled from `source` as they arrive, all sharing one
+    // ResourceBudget, until the source is done and the last task has ended.
+    // A task is ready once the tasks of its batch it depends on have
+    // completed; of the ready tasks, those of the earliest batch start first
+    // (within a batch, longest critical path first), so every batch finishes
+    // as soon as it can while later batches' first steps use the room left.
+    // Backfilling and fail= work as in run_graph, a failure skipping only
+    // dependents in its own batch. As in run_stream, finished tasks go to
+    // `on_result`, and so do skipped ones (PluginResult::skipped), so every
+    // task admitted is passed to it once; task_index counts tasks over all
+    // batches in arrival order.
+    SchedulerResult run_batches(BatchSource& source, const ParallelBlockOptions& options,
+                                WorkerFunction fn, ResultFunction on_result = ResultFunction());
+
+private:
+    WorkerOutput output_;
 };
 
 } // namespace parallel
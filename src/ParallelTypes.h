@@ -13,15 +13,28 @@ struct PluginTask {
     std::string outputfile;
     size_t memory_hint = 0;  // bytes; 0 = use default allocation
     int gpu_hint = 0;        // GPU slots required; 0 = no GPU
+    std::string prefix;      // Prefix in effect where the task was declared
+    bool cacheable = true;   // false: cache=no, never memoize (side effects beyond outputfile)
+    std::string journal_id;  // identity in the run journal; empty when not journaling
+    int source_line = -1;    // line of the Plugin directive in its config file
+    double expected_seconds = 0.0;  // time= hint, else predicted from the runtime history; 0 = unknown
+    bool intermediate = false;      // intermediate=yes: outputfile may go once every later reader has run
 };
 
 enum class FailMode { Fast, Continue };
 
+// Which ready task is started first: the one with the longest expected
+// runtime (critical path, when tasks depend on each other), or the first
+// in the config.
+enum class DispatchOrder { Longest, Config };
+
 struct ParallelBlockOptions {
     int workers = 0;         // 0 = use system default (nproc / 2)
     size_t memory = 0;       // 0 = use system default (80% RAM)
     int gpu = 0;             // 0 = use all detected GPUs
     FailMode fail_mode = FailMode::Fast;
+    DispatchOrder order = DispatchOrder::Longest;
+    bool backfill = true;    // false: a task that does not fit holds back every task behind it
 };
 
 struct ParallelBlock {
@@ -32,27 +45,74 @@ struct ParallelBlock {
 
 struct PluginResult {
     std::string name;
+    size_t task_index = 0;   // position of the task in ParallelBlock::tasks / TaskGraph::tasks
     int exit_code = 0;
     double elapsed_seconds = 0.0;
+    size_t peak_rss = 0;     // of the worker process, in bytes; 0 = not measured
+    bool skipped = false;    // never started, as a task it depends on failed
+};
+
+// Tasks plus the edges between them: dependencies[i] lists the tasks that
+// must complete before tasks[i] may start.
+struct TaskGraph {
+    std::vector<PluginTask> tasks;
+    std::vector<std::vector<size_t>> dependencies;
 };
 
 struct SchedulerResult {
     std::vector<PluginResult> completed;
     std::vector<PluginResult> failed;
+    std::vector<PluginResult> skipped;  // never started because a dependency failed
     double total_elapsed_seconds = 0.0;
 };
 
-enum class ConfigStepKind { Sequential, Parallel };
+// A Sweep ... EndSweep block: one Plugin line run once per sample, where
+// the samples are the lines of a sample list or the paths matching a glob.
+struct SweepBlock {
+    ParallelBlockOptions options;
+    std::string samples;         // sample list file (samples=), prefixed
+    std::string pattern;         // input glob (glob=), prefixed
+    std::string plugin_line;     // Plugin line with {sample}/{path} placeholders
+    std::string prefix;          // Prefix in effect for the block
+    int source_line = -1;        // line of the Sweep directive
+    int plugin_source_line = -1; // line of the Plugin directive
+};
+
+// Where a Scatter block may cut its input: after any line, after every
+// record_lines lines (by=records, e.g. 4 for FASTQ), or at any byte.
+enum class ShardUnit { Lines, Records, Bytes };
+
+// A Scatter ... EndScatter block: one Plugin line whose input is split into
+// shards, each run as its own task, and whose shard outputs are gathered
+// into the line's outputfile.
+struct ScatterBlock {
+    ParallelBlockOptions options;
+    int shards = 0;              // shards=N, at most; fewer when the input is small
+    ShardUnit unit = ShardUnit::Lines;
+    int record_lines = 4;        // lines per record for by=records (record=)
+    int header_lines = 0;        // leading lines repeated at the top of every shard (header=)
+    std::string gather = "concat"; // "concat", or the merge plugin given the list of shard outputs
+    std::string plugin_line;
+    std::string prefix;          // Prefix in effect for the block
+    int source_line = -1;        // line of the Scatter directive
+    int plugin_source_line = -1; // line of the Plugin directive
+};
+
+enum class ConfigStepKind { Sequential, Parallel, Sweep, Scatter };
 
 struct SequentialStep {
     std::string keyword;     // "Plugin", "Prefix", "Kitty", "Pipeline"
     std::string raw_line;
+    std::string prefix;      // Prefix in effect after this line
+    int source_line = -1;
 };
 
 struct ConfigStep {
     ConfigStepKind kind;
     SequentialStep sequential;  // valid when kind == Sequential
     ParallelBlock parallel;     // valid when kind == Parallel
+    SweepBlock sweep;           // valid when kind == Sweep
+    ScatterBlock scatter;       // valid when kind == Scatter
 };
 
 struct ParseError {
@@ -0,0 +1,221 @@
+#include "Planner.h"
+#include "ConfigParser.h"
+#include "DependencyGraph.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace parallel {
+
+namespace fs = std::filesystem;
+
+static std::string canonical_key(const std::string& path) {
+    std::error_code ec;
+    fs::path p = fs::weakly_canonical(path, ec);
+    return ec ? fs::path(path).lexically_normal().generic_string() : p.generic_string();
+}
+
+struct PlanBuilder {
+    Plan plan;
+    std::map<std::string, std::string> sources;   // canonical path -> contents
+    std::vector<std::string> stack;               // includes being expanded
+
+    // Contents of a config file, read from disk on first use only.
+    bool source(const std::string& path, const std::string& key, std::string& contents) {
+        auto it = sources.find(key);
+        if (it == sources.end()) {
+            std::ifstream in(path);
+            if (!in) return false;
+            std::stringstream ss;
+            ss << in.rdbuf();
+            it = sources.emplace(key, ss.str()).first;
+            plan.files.push_back(path);
+        }
+        contents = it->second;
+        return true;
+    }
+
+    PlanStep* add(const PluginTask& task, const std::string& path, const std::string& kitty, int litter, int group) {
+        if (task.name.empty()) return NULL;
+        PlanStep step;
+        step.task = task;
+        step.origin = path + ":" + std::to_string(task.source_line);
+        step.kitty = kitty;
+        step.parallel = group >= 0;
+        step.group = group;
+        step.litter = litter;
+        plan.steps.push_back(std::move(step));
+        return &plan.steps.back();
+    }
+
+    int add_group(PlanGroup::Kind kind, const ParallelBlockOptions& options, const std::string& origin) {
+        PlanGroup group;
+        group.kind = kind;
+        group.options = options;
+        group.origin = origin;
+        plan.groups.push_back(group);
+        return static_cast<int>(plan.groups.size()) - 1;
+    }
+
+    void expand(const std::string& path, const std::string& prefix, const std::string& outer_kitty, int outer_litter) {
+        std::string key = canonical_key(path);
+        if (std::find(stack.begin(), stack.end(), key) != stack.end()) {
+            std::string chain;
+            for (const auto& s : stack) chain += s + " -> ";
+            plan.errors.push_back(path + ": Pipeline include cycle: " + chain + key);
+            return;
+        }
+
+        std::string contents;
+        if (!source(path, key, contents)) {
+            plan.errors.push_back(path + ": cannot open config file");
+            return;
+        }
+        std::istringstream in(contents);
+        ParseResult parsed = parse_config(in, prefix);
+        for (const auto& e : parsed.errors) {
+            plan.errors.push_back(path + ":" + std::to_string(e.line) + ": " + e.message);
+        }
+
+        stack.push_back(key);
+        // Only the Kitty pipelines between LitterLaunch and LitterGather run
+        // as part of the litter; everything else in this file runs where the
+        // file itself runs.
+        std::string kitty = outer_kitty;
+        int litter = -1;
+        bool in_litter = false;
+        for (const auto& step : parsed.steps) {
+            if (step.kind == ConfigStepKind::Parallel) {
+                int group = add_group(PlanGroup::Parallel, step.parallel.options,
+                                      path + ":" + std::to_string(step.parallel.source_line));
+                for (const auto& task : step.parallel.tasks) add(task, path, kitty, outer_litter, group);
+                continue;
+            }
+            if (step.kind == ConfigStepKind::Sweep) {
+                PluginTask task = parse_plugin_task(step.sweep.plugin_line, step.sweep.prefix);
+                task.source_line = step.sweep.plugin_source_line;
+                int group = add_group(PlanGroup::Sweep, step.sweep.options,
+                                      path + ":" + std::to_string(step.sweep.source_line));
+                if (PlanStep* added = add(task, path, kitty, outer_litter, group)) {
+                    added->sweep = true;
+                    added->sweep_block = step.sweep;
+                }
+                continue;
+            }
+
+            if (step.kind == ConfigStepKind::Scatter) {
+                PluginTask task = parse_plugin_task(step.scatter.plugin_line, step.scatter.prefix);
+                task.source_line = step.scatter.plugin_source_line;
+                int group = add_group(PlanGroup::Scatter, step.scatter.options,
+                                      path + ":" + std::to_string(step.scatter.source_line));
+                if (PlanStep* added = add(task, path, kitty, outer_litter, group)) {
+                    added->scatter = true;
+                    added->scatter_block = step.scatter;
+                }
+                continue;
+            }
+
+            const auto& seq = step.sequential;
+            std::istringstream iss(seq.raw_line);
+            std::string keyword, arg;
+            iss >> keyword >> arg;
+            if (keyword == "Pipeline") {
+                if (!arg.empty()) expand(arg, seq.prefix, kitty, in_litter ? litter : outer_litter);
+            } else if (keyword == "Kitty") {
+                kitty = arg;
+                in_litter = litter >= 0;
+            } else if (keyword == "LitterLaunch") {
+                litter = add_group(PlanGroup::Litter, parse_parallel_options(seq.raw_line),
+                                   path + ":" + std::to_string(seq.source_line));
+            } else if (keyword == "LitterGather") {
+                kitty = outer_kitty;
+                litter = -1;
+                in_litter = false;
+            } else if (keyword != "Prefix") {
+                PluginTask task = parse_plugin_task(seq.raw_line, seq.prefix);
+                task.source_line = seq.source_line;
+                add(task, path, kitty, outer_litter, -1);
+            }
+        }
+        stack.pop_back();
+    }
+};
+
+Plan build_plan(const std::string& path, const std::string& prefix) {
+    PlanBuilder builder;
+    builder.expand(path, prefix, "", -1);
+    return builder.plan;
+}
+
+// out/run.csv is produced by out/run, but out/run/x.csv is not (unless
+// out/run is a directory output, which paths_overlap covers).
+static bool extends_name(const std::string& input, const std::string& output) {
+    std::string in = fs::path(input).lexically_normal().generic_string();
+    std::string out = fs::path(output).lexically_normal().generic_string();
+    if (out.empty() || in.size() <= out.size() || in.compare(0, out.size(), out) != 0) return false;
+    return in.find('/', out.size()) == std::string::npos;
+}
+
+std::vector<std::string> check_plan(const Plan& plan,
+                                    const std::map<std::string, std::string>& pluginLanguages) {
+    std::vector<std::string> problems;
+    std::set<std::string> seen;
+    auto report = [&](const std::string& msg) {
+        if (seen.insert(msg).second) problems.push_back(msg);
+    };
+
+    for (size_t i = 0; i < plan.steps.size(); i++) {
+        const PlanStep& step = plan.steps[i];
+        const PluginTask& task = step.task;
+        auto lang = pluginLanguages.find(task.name + "Plugin");
+        if (lang == pluginLanguages.end() || lang->second.empty()) {
+            report(step.origin + ": plugin " + task.name + " is not installed");
+        }
+
+        if (step.scatter && step.scatter_block.gather != "concat") {
+            auto merge = pluginLanguages.find(step.scatter_block.gather + "Plugin");
+            if (merge == pluginLanguages.end() || merge->second.empty()) {
+                report(step.origin + ": gather plugin " + step.scatter_block.gather + " is not installed");
+            }
+        }
+
+        // A glob may legitimately match nothing yet; a sample list must be there.
+        std::string input = step.sweep ? step.sweep_block.samples : task.inputfile;
+        if (input.empty() || input == task.prefix) continue;
+        // A template path of an --inbox config, filled in per sample.
+        if (!step.sweep && (input.find("{sample}") != std::string::npos || input.find("{path}") != std::string::npos)) continue;
+        bool produced = false;
+        for (size_t j = 0; j < i && !produced; j++) {
+            const std::string& out = plan.steps[j].task.outputfile;
+            produced = paths_overlap(input, out) || extends_name(input, out);
+        }
+        std::error_code ec;
+        if (!produced && !fs::exists(input, ec)) {
+            report(step.origin + ": " + (step.sweep ? "sample list " : "input ") + input + " of plugin " +
+                   task.name + " does not exist and no earlier plugin writes it");
+        }
+    }
+    return problems;
+}
+
+std::vector<std::string> plan_languages(const Plan& plan,
+                                        const std::map<std::string, std::string>& pluginLanguages) {
+    std::vector<std::string> languages;
+    auto add = [&](const std::string& plugin) {
+        auto lang = pluginLanguages.find(plugin + "Plugin");
+        if (lang == pluginLanguages.end() || lang->second.empty()) return;
+        if (std::find(languages.begin(), languages.end(), lang->second) == languages.end())
+            languages.push_back(lang->second);
+    };
+    for (size_t i = 0; i < plan.steps.size(); i++) {
+        add(plan.steps[i].task.name);
+        if (plan.steps[i].scatter && plan.steps[i].scatter_block.gather != "concat")
+            add(plan.steps[i].scatter_block.gather);
+    }
+    return languages;
+}
+
+} // namespace parallel
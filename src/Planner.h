@@ -0,0 +1,63 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include "ParallelTypes.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+// Steps that run concurrently: a Parallel block, a Sweep, the shards of a
+// Scatter, or the Kitty pipelines between LitterLaunch and LitterGather.
+struct PlanGroup {
+    enum Kind { Parallel, Sweep, Scatter, Litter };
+    Kind kind = Parallel;
+    ParallelBlockOptions options;
+    std::string origin;      // "file:line" of the directive opening the group
+};
+
+struct PlanStep {
+    PluginTask task;
+    std::string origin;      // "file:line" of the Plugin directive
+    std::string kitty;       // Kitty the step runs under; empty outside litters
+    bool parallel = false;   // declared inside a Parallel block
+    bool sweep = false;      // Plugin line of a Sweep block; task still has its placeholders
+    SweepBlock sweep_block;  // valid when sweep
+    bool scatter = false;    // Plugin line of a Scatter block; task is the unsharded run
+    ScatterBlock scatter_block;  // valid when scatter
+    int group = -1;          // Parallel block, Sweep or Scatter in Plan::groups; -1 = runs alone
+    int litter = -1;         // litter in Plan::groups the step's Kitty belongs to; -1 = none
+};
+
+// Everything a config would run, in execution order, with Pipeline includes
+// expanded. Each include file is read once however often it is used.
+struct Plan {
+    std::vector<PlanStep> steps;
+    std::vector<PlanGroup> groups;
+    std::vector<std::string> files;     // distinct config files read, in first-use order
+    std::vector<std::string> errors;    // syntax errors, unreadable files, include cycles
+};
+
+Plan build_plan(const std::string& path, const std::string& prefix = "");
+
+// Problems that would stop the run part way: plugins missing from
+// pluginLanguages and inputs that neither exist nor are produced by an
+// earlier step. An earlier output also produces the files that extend its
+// name (out -> out.csv), since plugins often treat outputfile as a prefix.
+// A Sweep step is checked for its sample list rather than its input, a
+// Scatter step for its gather plugin too, and an input naming {sample} or
+// {path} (an --inbox template) not at all.
+std::vector<std::string> check_plan(const Plan& plan,
+                                    const std::map<std::string, std::string>& pluginLanguages);
+
+// The languages of the plugins a plan runs, gather plugins included, in the
+// order they are first needed; so that only their runtimes are started.
+// Plugins missing from pluginLanguages are left out.
+std::vector<std::string> plan_languages(const Plan& plan,
+                                        const std::map<std::string, std::string>& pluginLanguages);
+
+} // namespace parallel
+
+#endif
@@ -0,0 +1,104 @@
+#include "PluginCache.h"
+#include "Fingerprint.h"
+
+namespace parallel {
+
+namespace fs = std::filesystem;
+
+static const char* CACHE_FORMAT = "pluma-cache-v1";
+
+PluginCache::PluginCache(const std::string& directory)
+    : directory_(directory), local_(directory)
+{
+}
+
+void PluginCache::add_remote(std::unique_ptr<CacheStore> store) {
+    remotes_.push_back(std::move(store));
+}
+
+std::string PluginCache::key(const std::string& artifact, const PluginTask& task) const {
+    Sha256 h;
+    auto field = [&h](const std::string& s) {
+        h.update(s);
+        h.update("\0", 1);
+    };
+    field(CACHE_FORMAT);
+    field(task.name);
+    field(fingerprint_path(artifact));
+    field(fingerprint_path(task.inputfile));
+    field(fs::path(task.outputfile).lexically_normal().generic_string());
+    return h.hex_digest();
+}
+
+bool PluginCache::restore(const std::string& key, const std::string& outputfile) const {
+    std::error_code ec;
+    if (!local_.contains(key)) {
+        bool found = false;
+        for (const auto& remote : remotes_) {
+            std::string staging = local_.make_staging();
+            if (remote->fetch(key, staging) && local_.commit(key, staging)) {
+                found = true;
+                break;
+            }
+            fs::remove_all(staging, ec);
+        }
+        if (!found) return false;
+    }
+    fs::path entry = local_.entry_path(key);
+
+    fs::path dest_dir = fs::path(outputfile).parent_path();
+    if (!dest_dir.empty()) fs::create_directories(dest_dir, ec);
+
+    for (const auto& item : fs::directory_iterator(entry, ec)) {
+        fs::path dest = dest_dir / item.path().filename();
+        fs::remove_all(dest, ec);
+        fs::copy(item.path(), dest, fs::copy_options::recursive | fs::copy_options::overwrite_existing, ec);
+        if (ec) return false;
+    }
+    return true;
+}
+
+std::vector<fs::path> collect_outputs(const std::string& outputfile, PluginCache::Clock::time_point since) {
+    std::vector<fs::path> outputs;
+    std::error_code ec;
+    fs::path out(outputfile);
+    if (fs::exists(out, ec)) outputs.push_back(out);
+
+    std::string base = out.filename().string();
+    fs::path dir = out.parent_path().empty() ? fs::path(".") : out.parent_path();
+    if (base.empty()) return outputs;
+
+    for (const auto& item : fs::directory_iterator(dir, ec)) {
+        std::string name = item.path().filename().string();
+        if (name.size() <= base.size() || name.compare(0, base.size(), base) != 0) continue;
+        if (item.last_write_time(ec) < since) continue;
+        outputs.push_back(item.path());
+    }
+    return outputs;
+}
+
+bool PluginCache::store(const std::string& key, const std::string& outputfile, Clock::time_point since) const {
+    std::vector<fs::path> outputs = collect_outputs(outputfile, since);
+    if (outputs.empty()) return false;
+
+    std::error_code ec;
+    if (!local_.contains(key)) {
+        std::string staging = local_.make_staging();
+        for (const auto& item : outputs) {
+            fs::copy(item, fs::path(staging) / item.filename(), fs::copy_options::recursive, ec);
+            if (ec) {
+                fs::remove_all(staging, ec);
+                return false;
+            }
+        }
+        if (!local_.commit(key, staging)) return false;
+    }
+
+    bool ok = true;
+    for (const auto& remote : remotes_) {
+        if (!remote->publish(key, local_.entry_path(key))) ok = false;
+    }
+    return ok;
+}
+
+} // namespace parallel
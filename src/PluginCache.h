@@ -0,0 +1,55 @@
+#ifndef PLUGIN_CACHE_H
+#define PLUGIN_CACHE_H
+
+#include "ParallelTypes.h"
+#include "CacheStore.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+// Memoizes plugin invocations in a local directory. An entry is keyed by the
+// plugin artifact, the input file contents and the resolved output path, and
+// holds a copy of everything the plugin wrote under that output path.
+// Remote stores are consulted after the local directory, and entries found
+// there are copied into it; new entries are uploaded to every remote store.
+class PluginCache {
+public:
+    using Clock = std::filesystem::file_time_type::clock;
+
+    explicit PluginCache(const std::string& directory);
+
+    void add_remote(std::unique_ptr<CacheStore> store);
+
+    std::string key(const std::string& artifact, const PluginTask& task) const;
+
+    // Copies a cached entry back next to outputfile; false on a miss.
+    bool restore(const std::string& key, const std::string& outputfile) const;
+
+    // Saves the outputs a plugin produced since `since`. Entries are published
+    // with a rename, so concurrent workers never observe a partial entry.
+    // False if there was nothing to save or any store rejected the entry.
+    bool store(const std::string& key, const std::string& outputfile, Clock::time_point since) const;
+
+    bool contains(const std::string& key) const { return local_.contains(key); }
+    std::string entry_path(const std::string& key) const { return local_.entry_path(key); }
+    const std::string& directory() const { return directory_; }
+
+private:
+    std::string directory_;
+    DirectoryStore local_;
+    std::vector<std::unique_ptr<CacheStore>> remotes_;
+};
+
+// The output path itself plus siblings that extend its name (out.csv.log,
+// out_stats.txt) and were modified since `since`; plugins commonly treat
+// outputfile as a prefix.
+std::vector<std::filesystem::path> collect_outputs(const std::string& outputfile,
+                                                   PluginCache::Clock::time_point since);
+
+} // namespace parallel
+
+#endif
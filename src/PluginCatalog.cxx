@@ -0,0 +1,196 @@
+#include "PluginCatalog.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace parallel {
+
+namespace fs = std::filesystem;
+
+// The mtime saved for a directory modified too recently to trust it.
+static const int64_t RECENT = INT64_MIN;
+
+static int64_t stamp(fs::file_time_type mtime, fs::file_time_type now) {
+    if (now - mtime < std::chrono::seconds(2)) return RECENT;
+    return static_cast<int64_t>(mtime.time_since_epoch().count());
+}
+
+static std::vector<std::string> split_tabs(const std::string& line) {
+    std::vector<std::string> fields;
+    std::istringstream iss(line);
+    std::string field;
+    while (std::getline(iss, field, '\t')) fields.push_back(field);
+    return fields;
+}
+
+// Catalog paths are tab-separated fields on lines of their own.
+static bool plain(const std::string& s) {
+    return s.find_first_of("\t\n\r") == std::string::npos;
+}
+
+PluginCatalog::PluginCatalog(const std::string& path, const std::string& rules) : path_(path), rules_(rules) {
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line) || line != "v1\t" + rules) return;
+
+    // Each dir line belongs to the root before it, each plugin line to the dir before it.
+    Root* root = nullptr;
+    Directory* dir = nullptr;
+    while (std::getline(in, line)) {
+        std::vector<std::string> f = split_tabs(line);
+        try {
+            if (f.size() == 3 && f[0] == "root") {
+                root = &roots_[f[1]];
+                root->mtime = std::stoll(f[2]);
+                dir = nullptr;
+            }
+            else if (f.size() == 3 && f[0] == "dir" && root) {
+                root->dirs.push_back(f[1]);
+                dir = &dirs_[f[1]];
+                dir->mtime = std::stoll(f[2]);
+            }
+            else if (f.size() == 4 && f[0] == "plugin" && dir) {
+                dir->entries.push_back({f[1], f[2], f[3]});
+            }
+        } catch (...) {
+            // A damaged catalog only costs a full scan.
+            roots_.clear();
+            dirs_.clear();
+            return;
+        }
+    }
+}
+
+std::vector<CatalogEntry> PluginCatalog::scan(const std::string& root, const Scanner& scanner, int threads) {
+    rescanned_ = 0;
+    std::error_code ec;
+    fs::file_time_type now = fs::file_time_type::clock::now();
+    fs::file_time_type rootTime = fs::last_write_time(root, ec);
+    if (ec || !fs::is_directory(root, ec)) {
+        if (roots_.erase(root)) changed_ = true;
+        return std::vector<CatalogEntry>();
+    }
+
+    Root& known = roots_[root];
+    int64_t mtime = stamp(rootTime, now);
+    if (mtime == RECENT || mtime != known.mtime) {
+        known.mtime = mtime;
+        known.dirs.clear();
+        for (fs::directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+            std::string name = it->path().filename().string();
+            std::error_code dirError;
+            if (name.empty() || name[0] == '.' || !it->is_directory(dirError)) continue;
+            known.dirs.push_back((fs::path(root) / name).string());
+        }
+        std::sort(known.dirs.begin(), known.dirs.end());
+        changed_ = true;
+    }
+
+    // Checking every directory's mtime is most of the cost on a network
+    // file system, so it is done in parallel along with the scans.
+    const std::vector<std::string>& dirs = known.dirs;
+    std::vector<Directory> scanned(dirs.size());
+    std::vector<char> state(dirs.size(), 0);    // 0 unchanged, 1 scanned, 2 gone
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i; (i = next++) < dirs.size();) {
+            std::error_code statError;
+            fs::file_time_type dirTime = fs::last_write_time(dirs[i], statError);
+            if (statError) {
+                state[i] = 2;
+                continue;
+            }
+            int64_t dirMtime = stamp(dirTime, now);
+            std::map<std::string, Directory>::const_iterator cached = dirs_.find(dirs[i]);
+            if (dirMtime != RECENT && cached != dirs_.end() && cached->second.mtime == dirMtime) continue;
+            scanned[i].mtime = dirMtime;
+            scanned[i].entries = scanner(dirs[i]);
+            state[i] = 1;
+        }
+    };
+    size_t count = std::min(dirs.size(), static_cast<size_t>(std::max(threads, 1)));
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < count; t++) pool.emplace_back(work);
+    work();
+    for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+
+    std::vector<CatalogEntry> entries;
+    std::vector<std::string> present;
+    for (size_t i = 0; i < dirs.size(); i++) {
+        if (state[i] == 2) {
+            dirs_.erase(dirs[i]);
+            changed_ = true;
+            continue;
+        }
+        if (state[i] == 1) {
+            dirs_[dirs[i]] = scanned[i];
+            rescanned_++;
+            changed_ = true;
+        }
+        const std::vector<CatalogEntry>& found = dirs_[dirs[i]].entries;
+        entries.insert(entries.end(), found.begin(), found.end());
+        present.push_back(dirs[i]);
+    }
+    known.dirs = present;
+    return entries;
+}
+
+bool PluginCatalog::save() {
+    if (!changed_) return true;
+    std::ostringstream out;
+    out << "v1\t" << rules_ << "\n";
+    for (std::map<std::string, Root>::const_iterator root = roots_.begin(); root != roots_.end(); ++root) {
+        if (!plain(root->first)) continue;
+        out << "root\t" << root->first << "\t" << root->second.mtime << "\n";
+        for (size_t i = 0; i < root->second.dirs.size(); i++) {
+            const std::string& dir = root->second.dirs[i];
+            const Directory& found = dirs_[dir];
+            bool saved = plain(dir);
+            for (size_t j = 0; saved && j < found.entries.size(); j++)
+                saved = plain(found.entries[j].name) && plain(found.entries[j].language) && plain(found.entries[j].path);
+            // Left out, it is scanned again next time.
+            if (!saved) continue;
+            out << "dir\t" << dir << "\t" << found.mtime << "\n";
+            for (size_t j = 0; j < found.entries.size(); j++)
+                out << "plugin\t" << found.entries[j].name << "\t" << found.entries[j].language << "\t"
+                    << found.entries[j].path << "\n";
+        }
+    }
+
+    std::error_code ec;
+    fs::path parent = fs::path(path_).parent_path();
+    if (!parent.empty()) fs::create_directories(parent, ec);
+    std::string staging = path_ + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream file(staging, std::ios::binary | std::ios::trunc);
+        file << out.str();
+        if (!file.flush()) {
+            fs::remove(staging, ec);
+            return false;
+        }
+    }
+    fs::rename(staging, path_, ec);
+    if (ec) {
+        fs::remove(staging, ec);
+        return false;
+    }
+    changed_ = false;
+    return true;
+}
+
+std::string PluginCatalog::default_path() {
+    const char* env = getenv("PLUMA_CATALOG");
+    if (env && *env) return env;
+    const char* home = getenv("HOME");
+    return std::string(home && *home ? home : ".") + "/.pluma/catalog";
+}
+
+} // namespace parallel
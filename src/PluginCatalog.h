@@ -0,0 +1,72 @@
+#ifndef PLUGIN_CATALOG_H
+#define PLUGIN_CATALOG_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+// A plugin as the languages register it.
+struct CatalogEntry {
+    std::string name;       // artifact file name without prefix and extension ("CopyPlugin")
+    std::string language;
+    std::string path;       // the artifact
+};
+
+// What was found in each plugin directory (a subdirectory of a root on the
+// plugin path), saved between runs so that startup does not have to list
+// every directory again. A directory is scanned only when its mtime, which
+// changes when files are added, removed or renamed in it, differs from the
+// one saved; a root is listed again only when its own mtime changes. A
+// directory modified in the last seconds before a scan is scanned again
+// the next time too, since a change within the same mtime tick would not
+// show.
+class PluginCatalog {
+public:
+    // Finds the plugins in one plugin directory. Called from several
+    // threads at once.
+    using Scanner = std::function<std::vector<CatalogEntry>(const std::string& dir)>;
+
+    // Loads the catalog at path. rules names what the scanner looks for
+    // (languages, extensions); a catalog saved under other rules is ignored.
+    PluginCatalog(const std::string& path, const std::string& rules);
+
+    // The plugins under root, directory by directory in name order, scanning
+    // the changed directories with up to `threads` threads.
+    std::vector<CatalogEntry> scan(const std::string& root, const Scanner& scanner, int threads = 8);
+
+    // Directories the last scan() had to scan.
+    size_t rescanned() const { return rescanned_; }
+
+    // Writes the catalog if a scan changed it, replacing the file with a
+    // rename so concurrent runs read either version whole. Roots not scanned
+    // since it was loaded are kept.
+    bool save();
+
+    // $PLUMA_CATALOG, else ~/.pluma/catalog.
+    static std::string default_path();
+
+private:
+    struct Directory {
+        int64_t mtime = 0;
+        std::vector<CatalogEntry> entries;
+    };
+    struct Root {
+        int64_t mtime = 0;
+        std::vector<std::string> dirs;
+    };
+
+    std::string path_;
+    std::string rules_;
+    std::map<std::string, Root> roots_;
+    std::map<std::string, Directory> dirs_;
+    size_t rescanned_ = 0;
+    bool changed_ = false;
+};
+
+} // namespace parallel
+
+#endif
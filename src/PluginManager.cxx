@@ -31,6 +31,60 @@
 \*********************************************************************************/
 
 #include "PluginManager.h"
+#include <future>
+#include <mutex>
 #include <vector>
+#if !PLUMA_PLATFORM_WINDOWS
+#include <pthread.h>
+#endif
 std::vector<Language*> PluginManager::supported;
-std::string PluginManager::myPrefix = "";
+
+// Runtimes being started in the background, by language
+static std::map<std::string, std::shared_future<void> > starting;
+static std::mutex startingMutex;
+static thread_local bool startingThread = false;
+
+// A child forked while a runtime is half started would inherit it half
+// started, and any lock its thread held; so fork() waits until all have
+// started. Not on a starting thread itself, which would wait for itself.
+static void awaitAllLanguages() {
+    if (startingThread) return;
+    std::vector<std::shared_future<void> > pending;
+    {
+        std::lock_guard<std::mutex> lock(startingMutex);
+        for (std::map<std::string, std::shared_future<void> >::iterator itr = starting.begin(); itr != starting.end(); itr++)
+            pending.push_back(itr->second);
+    }
+    for (size_t i = 0; i < pending.size(); i++) pending[i].wait();
+}
+
+void PluginManager::startLanguages(const std::vector<std::string>& langs) {
+    std::lock_guard<std::mutex> lock(startingMutex);
+#if !PLUMA_PLATFORM_WINDOWS
+    static bool registered = false;
+    if (!registered) registered = pthread_atfork(awaitAllLanguages, NULL, NULL) == 0;
+#endif
+    for (size_t i = 0; i < langs.size(); i++) {
+        if (starting.count(langs[i])) continue;
+        for (size_t j = 0; j < supported.size(); j++) {
+            Language* language = supported[j];
+            if (language->lang() != langs[i] || !language->loadsInBackground()) continue;
+            PluginManager::getInstance().log("Starting the "+langs[i]+" runtime in the background.");
+            starting[langs[i]] = std::async(std::launch::async, [language]() {
+                startingThread = true;
+                language->load();
+            }).share();
+        }
+    }
+}
+
+void PluginManager::awaitLanguage(const std::string& lang) {
+    std::shared_future<void> pending;
+    {
+        std::lock_guard<std::mutex> lock(startingMutex);
+        std::map<std::string, std::shared_future<void> >::iterator itr = starting.find(lang);
+        if (itr == starting.end()) return;
+        pending = itr->second;
+    }
+    pending.wait();
+}
@@ -36,6 +36,7 @@
 #define PLUGINMANAGER_H
 
 #include "PluginMaker.h"
+#include "ExecutionContext.h"
 
 #include <cstdlib>
 #include <string>
@@ -63,7 +64,6 @@ public:
     std::set<std::string> installed;
     static std::vector<Language*> supported;
     std::map<std::string, std::string> pluginLanguages;
-    static std::string myPrefix;
 
     static PluginManager& getInstance()
     {
@@ -74,9 +74,7 @@ public:
 
     PluginManager() {}
     PluginManager(PluginManager const&) = delete;
-    ~PluginManager() {
-        if (logfile) delete logfile;
-    }
+    ~PluginManager() {}
     void operator=(PluginManager const&) = delete;
 
 public:
@@ -86,35 +84,51 @@ public:
 
     void add(std::string name) {installed.insert(name);}
 
+    // Languages of the installed plugins
+    std::vector<std::string> languages() const {
+        std::set<std::string> seen;
+        std::vector<std::string> langs;
+        for (std::map<std::string, std::string>::const_iterator itr = pluginLanguages.begin(); itr != pluginLanguages.end(); itr++)
+            if (seen.insert(itr->second).second) langs.push_back(itr->second);
+        return langs;
+    }
+
     Plugin* create(std::string name) {
         return makers[name]->create();
     }
 
+    // The log of the process default context, inherited by every pipeline
     void setLogFile(std::string lf) {
-        if (logfile) delete logfile;
-        logfile = new std::ofstream(lf.c_str(), std::ios::out);
+        ExecutionContext::processDefault().setSink(std::make_shared<LogSink>(lf));
+    }
+
+    // Context of the pipeline running on this thread
+    static ExecutionContext& context() {
+        return ExecutionContext::current();
     }
 
     static void log(std::string msg) {
-        *(getInstance().logfile) << "[PluMA] " << msg << std::endl;
+        context().log(msg);
     }
 
     static void dependency(std::string plugin) {
        if (getInstance().installed.count(plugin) == 0) {
-           *(getInstance().logfile) << "[PluMA] Plugin dependency " << plugin << " not met.  Exiting..." << std::endl;  exit(1);
+           log("Plugin dependency " + plugin + " not met.  Exiting...");  exit(1);
         } else {
-            *(getInstance().logfile) << "[PluMA] Plugin dependency " << plugin << " met." << std::endl;
+            log("Plugin dependency " + plugin + " met.");
         }
     }
 
     static char* prefix() {
-        return (char*) myPrefix.c_str();
+        return (char*) context().prefix().c_str();
     }
 
     static std::string addPrefix(std::string filename) {
         return std::string(prefix())+"/"+filename;
     }
 
+    // Constructs every language this build supports. No runtime starts here:
+    // each starts with startLanguages() or when its first plugin runs.
     static void supportedLanguages(
         std::string pluginpath,
         int argc,
@@ -140,6 +154,14 @@ public:
 #endif
     }
 
+    // Starts the runtimes of langs that can start in the background
+    // (Language::loadsInBackground), each on a thread of its own, so they are
+    // up by the time their first plugin runs. fork() waits for them to finish.
+    static void startLanguages(const std::vector<std::string>& langs);
+
+    // Waits for the background start of lang, if there is one.
+    static void awaitLanguage(const std::string& lang);
+
     static void languageLoad(std::string lang) {
         for (int i = 0; i < supported.size(); i++) {
             if (supported[i]->lang() == lang) {
@@ -155,9 +177,6 @@ public:
             }
         }
     }
-
-private:
-    std::ofstream* logfile;
 };
 
 #endif
@@ -47,9 +47,32 @@ template<class T>
 class PluginProxy : public Proxy
 {
 public:
+#ifdef PLUMA_STATIC_PLUGIN
+    // Linked into pluma (SConstruct --static-plugins): the static plugin
+    // table points at create() instead, so nothing is registered at run time.
+    PluginProxy(std::string keyword, PluginManager& mgr) : myCreate(&PluginProxy::create) {};
+#else
     PluginProxy(std::string keyword, PluginManager& mgr) {
         mgr.addMaker(keyword, new PluginMaker<T>());
     };
+#endif
+
+    static Plugin* create();
+
+#ifdef PLUMA_STATIC_PLUGIN
+private:
+    // Makes the plugin's object file define create(), for the table
+    Plugin* (*myCreate)();
+#endif
 };
 
+// The static plugin table only declares the plugin classes, so it takes
+// create() from the plugins' own object files.
+#ifndef PLUMA_STATIC_TABLE
+template<class T>
+Plugin* PluginProxy<T>::create() {
+    return new T();
+}
+#endif
+
 #endif
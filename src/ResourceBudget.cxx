@@ -1,7 +1,71 @@
 #include "ResourceBudget.h"
 
+#include <unistd.h>
+#include <dirent.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
 namespace parallel {
 
+int detect_cpu_count() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? static_cast<int>(n) : 1;
+}
+
+size_t detect_total_memory() {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || page_size <= 0) return 0;
+    return static_cast<size_t>(pages) * static_cast<size_t>(page_size);
+}
+
+int detect_gpu_count() {
+    // CUDA_VISIBLE_DEVICES narrows what a plugin can see, so honor it first.
+    const char* visible = std::getenv("CUDA_VISIBLE_DEVICES");
+    if (visible) {
+        std::string devices(visible);
+        if (devices.empty() || devices == "-1") return 0;
+        int count = 1;
+        for (char c : devices) if (c == ',') count++;
+        return count;
+    }
+
+    int count = 0;
+    DIR* dev = opendir("/dev");
+    if (!dev) return 0;
+    while (struct dirent* entry = readdir(dev)) {
+        const char* name = entry->d_name;
+        if (std::strncmp(name, "nvidia", 6) != 0 || name[6] == '\0') continue;
+        bool numeric = true;
+        for (const char* p = name + 6; *p; p++) {
+            if (!std::isdigit(static_cast<unsigned char>(*p))) { numeric = false; break; }
+        }
+        if (numeric) count++;
+    }
+    closedir(dev);
+    return count;
+}
+
+ParallelBlockOptions resolve_defaults(const ParallelBlockOptions& opts) {
+    ParallelBlockOptions resolved = opts;
+    if (resolved.workers <= 0) {
+        resolved.workers = detect_cpu_count() / 2;
+        if (resolved.workers < 1) resolved.workers = 1;
+    }
+    if (resolved.memory == 0) {
+        resolved.memory = detect_total_memory() / 10 * 8;
+    }
+    if (resolved.gpu <= 0) {
+        resolved.gpu = detect_gpu_count();
+    }
+    return resolved;
+}
+
 ResourceBudget::ResourceBudget(const ParallelBlockOptions& opts)
     : total_memory_(opts.memory)
     , total_gpu_(opts.gpu)
@@ -46,4 +110,28 @@ int    ResourceBudget::used_gpu()       const { return used_gpu_; }
 int    ResourceBudget::max_workers()    const { return max_workers_; }
 int    ResourceBudget::active_workers() const { return active_workers_; }
 
+Reservation reserve(const ResourceBudget& budget, std::vector<RunningTask> running, const PluginTask& task) {
+    std::stable_sort(running.begin(), running.end(),
+                     [](const RunningTask& a, const RunningTask& b) { return a.expected_end < b.expected_end; });
+    Reservation reservation = {0.0, budget};
+    for (const auto& r : running) {
+        if (reservation.after.can_dispatch(task)) break;
+        reservation.after.release(*r.task);
+        reservation.start = r.expected_end;
+    }
+    if (reservation.after.can_dispatch(task)) reservation.after.acquire(task);
+    else reservation.start = std::numeric_limits<double>::infinity();
+    return reservation;
+}
+
+bool may_backfill(Reservation& reservation, const PluginTask& task, double now) {
+    // An unknown start (a running task with no estimate must end first) is
+    // no deadline to finish by: such a task could still hold its share then.
+    if (task.expected_seconds > 0 && std::isfinite(reservation.start) &&
+        now + task.expected_seconds <= reservation.start) return true;
+    if (!reservation.after.can_dispatch(task)) return false;
+    reservation.after.acquire(task);
+    return true;
+}
+
 } // namespace parallel
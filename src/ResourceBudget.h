@@ -4,9 +4,18 @@
 #include "ParallelTypes.h"
 
 #include <cstddef>
+#include <vector>
 
 namespace parallel {
 
+int detect_cpu_count();
+size_t detect_total_memory();
+int detect_gpu_count();
+
+// Replaces the "0 = system default" option values with concrete limits:
+// nproc / 2 workers, 80% of physical RAM and every visible GPU.
+ParallelBlockOptions resolve_defaults(const ParallelBlockOptions& opts);
+
 class ResourceBudget {
 public:
     ResourceBudget(const ParallelBlockOptions& opts);
@@ -33,6 +42,31 @@ private:
     int active_workers_ = 0;
 };
 
+// A running task as seen when planning a reservation: expected_end is when
+// it should release its resources, on the caller's clock; infinity when its
+// runtime is unknown.
+struct RunningTask {
+    const PluginTask* task;
+    double expected_end;
+};
+
+// Room kept for a task that does not fit yet, so that tasks started ahead
+// of it (backfilled) cannot starve it. The task is expected to fit at
+// `start`, once the running tasks expected to end soonest have released
+// enough; `after` is the budget from then on, with the task admitted.
+struct Reservation {
+    double start;
+    ResourceBudget after;
+};
+
+Reservation reserve(const ResourceBudget& budget, std::vector<RunningTask> running, const PluginTask& task);
+
+// Whether a task that fits the budget now may start without delaying the
+// reservation: it is expected to end by reservation.start, when that is
+// known, or it also fits alongside the reserved task in reservation.after
+// (which then counts it).
+bool may_backfill(Reservation& reservation, const PluginTask& task, double now);
+
 } // namespace parallel
 
 #endif
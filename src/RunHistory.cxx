@@ -0,0 +1,130 @@
+#include "RunHistory.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace parallel {
+
+// Tabs and newlines separate fields and records.
+static std::string sanitize(const std::string& s) {
+    std::string out = s;
+    for (char& c : out) {
+        if (c == '\t' || c == '\n' || c == '\r') c = ' ';
+    }
+    return out;
+}
+
+std::string format_history_record(const HistoryRecord& r) {
+    std::ostringstream line;
+    line << "v1\t" << r.timestamp
+         << "\t" << sanitize(r.plugin)
+         << "\t" << sanitize(r.language)
+         << "\t" << r.input_bytes
+         << "\t" << r.input_seconds
+         << "\t" << r.run_seconds
+         << "\t" << r.output_seconds
+         << "\t" << r.total_seconds
+         << "\t" << r.exit_code
+         << "\t" << r.peak_rss
+         << "\t" << sanitize(r.host) << "\n";
+    return line.str();
+}
+
+bool parse_history_record(const std::string& line, HistoryRecord& r) {
+    std::vector<std::string> fields;
+    std::istringstream iss(line);
+    std::string field;
+    while (std::getline(iss, field, '\t')) fields.push_back(field);
+    if (line.size() > 0 && line.back() == '\t') fields.push_back("");
+    if (fields.size() != 12 || fields[0] != "v1") return false;
+    try {
+        r.timestamp = std::stol(fields[1]);
+        r.plugin = fields[2];
+        r.language = fields[3];
+        r.input_bytes = std::stoull(fields[4]);
+        r.input_seconds = std::stod(fields[5]);
+        r.run_seconds = std::stod(fields[6]);
+        r.output_seconds = std::stod(fields[7]);
+        r.total_seconds = std::stod(fields[8]);
+        r.exit_code = std::stoi(fields[9]);
+        r.peak_rss = std::stoull(fields[10]);
+        r.host = fields[11];
+    } catch (...) {
+        return false;
+    }
+    return !r.plugin.empty();
+}
+
+RunHistory::RunHistory(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+}
+
+RunHistory::~RunHistory() {
+    if (fd_ >= 0) close(fd_);
+}
+
+bool RunHistory::append(const HistoryRecord& record) {
+    if (fd_ < 0) return false;
+    std::string s = format_history_record(record);
+    return write(fd_, s.data(), s.size()) == static_cast<ssize_t>(s.size());
+}
+
+std::vector<HistoryRecord> RunHistory::load(const std::string& path) {
+    std::vector<HistoryRecord> records;
+    std::ifstream in(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // As with the journal, a torn final line is ignored.
+    size_t pos = 0, eol;
+    while ((eol = contents.find('\n', pos)) != std::string::npos) {
+        HistoryRecord record;
+        if (parse_history_record(contents.substr(pos, eol - pos), record)) records.push_back(record);
+        pos = eol + 1;
+    }
+    return records;
+}
+
+std::string RunHistory::default_path() {
+    const char* env = getenv("PLUMA_HISTORY");
+    if (env && *env) return env;
+    const char* home = getenv("HOME");
+    return std::string(home && *home ? home : ".") + "/.pluma/history";
+}
+
+void reset_peak_rss() {
+    // Writing 5 to clear_refs resets VmHWM to the current RSS (Linux 4.0+).
+    int fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ssize_t rc = write(fd, "5", 1);
+    (void) rc;
+    close(fd);
+}
+
+size_t peak_rss() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") != 0) continue;
+        try {
+            return static_cast<size_t>(std::stoull(line.substr(6))) * 1024;
+        } catch (...) {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+std::string host_name() {
+    char buf[256] = {0};
+    if (gethostname(buf, sizeof(buf) - 1) != 0) return "";
+    return buf;
+}
+
+} // namespace parallel
@@ -0,0 +1,65 @@
+#ifndef RUN_HISTORY_H
+#define RUN_HISTORY_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+// One execution of a plugin.
+struct HistoryRecord {
+    long timestamp = 0;          // seconds since the epoch, at completion
+    std::string plugin;
+    std::string language;
+    size_t input_bytes = 0;
+    double input_seconds = 0.0;  // time in input(), run() and output()
+    double run_seconds = 0.0;
+    double output_seconds = 0.0;
+    double total_seconds = 0.0;  // wall time, including loading the plugin
+    int exit_code = 0;
+    size_t peak_rss = 0;         // bytes; 0 = not measured
+    std::string host;
+};
+
+// Append-only log of plugin executions shared by every run on the machine,
+// one tab-separated line per execution. Like the run journal, records are
+// single write()s to an O_APPEND descriptor, so forked scheduler workers
+// and concurrent pluma processes can append without coordinating.
+class RunHistory {
+public:
+    // Opens (creating, with its directory) the history at path.
+    explicit RunHistory(const std::string& path);
+    ~RunHistory();
+
+    RunHistory(const RunHistory&) = delete;
+    RunHistory& operator=(const RunHistory&) = delete;
+
+    bool is_open() const { return fd_ >= 0; }
+    bool append(const HistoryRecord& record);
+
+    // Every well-formed record in the file, oldest first.
+    static std::vector<HistoryRecord> load(const std::string& path);
+
+    // $PLUMA_HISTORY, else ~/.pluma/history.
+    static std::string default_path();
+
+private:
+    int fd_ = -1;
+};
+
+std::string format_history_record(const HistoryRecord& record);
+bool parse_history_record(const std::string& line, HistoryRecord& record);
+
+// Starts a new peak-RSS measurement for the calling process, where the
+// kernel allows it; otherwise the peak stays the process lifetime's.
+void reset_peak_rss();
+
+// Peak resident set size of the calling process in bytes; 0 if unknown.
+size_t peak_rss();
+
+std::string host_name();
+
+} // namespace parallel
+
+#endif
@@ -0,0 +1,172 @@
+#include "RunJournal.h"
+#include "Fingerprint.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+
+namespace parallel {
+
+// Tabs and newlines separate fields and records, so keep them out of ids.
+static std::string sanitize(const std::string& s) {
+    std::string out = s;
+    for (char& c : out) {
+        if (c == '\t' || c == '\n' || c == '\r') c = ' ';
+    }
+    return out;
+}
+
+static bool parse_record(const std::string& line, JournalEntry& entry) {
+    std::vector<std::string> fields;
+    std::istringstream iss(line);
+    std::string field;
+    while (std::getline(iss, field, '\t')) fields.push_back(field);
+    if (fields.size() != 6 || fields[0] != "step") return false;
+    entry.step_id = fields[1];
+    entry.input_fingerprint = fields[2];
+    entry.output_fingerprint = fields[3];
+    try {
+        entry.exit_code = std::stoi(fields[4]);
+        entry.elapsed_seconds = std::stod(fields[5]);
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+// collected <path> <fingerprint> [<reader id> <reader output>]...
+static bool parse_collected(const std::string& line, std::string& path, std::string& fingerprint,
+                            std::vector<std::pair<std::string, std::string>>& readers) {
+    std::vector<std::string> fields;
+    std::istringstream iss(line);
+    std::string field;
+    while (std::getline(iss, field, '\t')) fields.push_back(field);
+    if (!line.empty() && line.back() == '\t') fields.push_back("");   // a reader without an output
+    if (fields.size() < 3 || fields.size() % 2 == 0 || fields[0] != "collected") return false;
+    path = fields[1];
+    fingerprint = fields[2];
+    for (size_t i = 3; i + 1 < fields.size(); i += 2) readers.push_back({fields[i], fields[i + 1]});
+    return true;
+}
+
+// A record is only complete once its newline is on disk; a torn final line
+// from a crash mid-write is left out.
+static std::vector<std::string> read_records(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<std::string> records;
+    size_t pos = 0, eol;
+    while ((eol = contents.find('\n', pos)) != std::string::npos) {
+        records.push_back(contents.substr(pos, eol - pos));
+        pos = eol + 1;
+    }
+    return records;
+}
+
+std::vector<JournalEntry> RunJournal::load(const std::string& path) {
+    std::vector<JournalEntry> entries;
+    for (const std::string& line : read_records(path)) {
+        JournalEntry entry;
+        if (parse_record(line, entry)) entries.push_back(entry);
+    }
+    return entries;
+}
+
+RunJournal::RunJournal(const std::string& path, bool resume) {
+    if (resume) {
+        for (const std::string& line : read_records(path)) {
+            JournalEntry entry;
+            Collected collected;
+            std::string collected_path;
+            if (parse_record(line, entry)) {
+                if (entry.exit_code == 0) done_[entry.step_id] = entry;
+            } else if (parse_collected(line, collected_path, collected.fingerprint, collected.readers)) {
+                collected_[collected_path] = collected;
+            }
+        }
+    }
+    int flags = O_WRONLY | O_CREAT | O_APPEND | (resume ? 0 : O_TRUNC);
+    fd_ = open(path.c_str(), flags, 0644);
+
+    // Terminate a torn final record so the next one starts on its own line.
+    if (fd_ >= 0 && resume) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        std::streamoff size = in.tellg();
+        if (size > 0) {
+            in.seekg(size - 1);
+            if (in.get() != '\n') {
+                ssize_t rc = write(fd_, "\n", 1);
+                (void) rc;
+            }
+        }
+    }
+}
+
+RunJournal::~RunJournal() {
+    if (fd_ >= 0) close(fd_);
+}
+
+std::string RunJournal::assign_id(const PluginTask& task) {
+    std::string base = sanitize(task.name + "|" + task.inputfile + "|" + task.outputfile);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return base + "#" + std::to_string(ordinals_[base]++);
+}
+
+void RunJournal::restart_ids() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ordinals_.clear();
+}
+
+bool RunJournal::collected_as(const std::string& path, const std::string& fingerprint) const {
+    auto it = collected_.find(sanitize(path));
+    return it != collected_.end() && it->second.fingerprint == fingerprint && fingerprint_path(path).empty();
+}
+
+bool RunJournal::output_done(const std::string& step_id, const std::string& output, size_t depth) const {
+    auto it = done_.find(step_id);
+    if (it == done_.end()) return false;
+    if (it->second.output_fingerprint == fingerprint_path(output)) return true;
+    // Collected: it is needed again only if one of its readers is re-run.
+    // Readers come after their producer, so depth only guards a journal
+    // that several configs appended to.
+    if (depth > collected_.size() || !collected_as(output, it->second.output_fingerprint)) return false;
+    for (const auto& reader : collected_.at(sanitize(output)).readers) {
+        if (!output_done(reader.first, reader.second, depth + 1)) return false;
+    }
+    return true;
+}
+
+bool RunJournal::completed(const PluginTask& task) const {
+    auto it = done_.find(task.journal_id);
+    if (it == done_.end()) return false;
+    if (it->second.input_fingerprint != fingerprint_path(task.inputfile) &&
+        !collected_as(task.inputfile, it->second.input_fingerprint)) return false;
+    return output_done(task.journal_id, task.outputfile, 0);
+}
+
+bool RunJournal::record(const PluginTask& task, const PluginResult& result) {
+    if (fd_ < 0 || task.journal_id.empty()) return false;
+    std::ostringstream line;
+    line << "step\t" << task.journal_id
+         << "\t" << fingerprint_path(task.inputfile)
+         << "\t" << fingerprint_path(task.outputfile)
+         << "\t" << result.exit_code
+         << "\t" << result.elapsed_seconds << "\n";
+    std::string s = line.str();
+    if (write(fd_, s.data(), s.size()) != static_cast<ssize_t>(s.size())) return false;
+    return fsync(fd_) == 0;
+}
+
+bool RunJournal::record_collected(const std::string& path, const std::vector<PluginTask>& readers) {
+    if (fd_ < 0) return false;
+    std::ostringstream line;
+    line << "collected\t" << sanitize(path) << "\t" << fingerprint_path(path);
+    for (const PluginTask& reader : readers) line << "\t" << sanitize(reader.journal_id) << "\t" << sanitize(reader.outputfile);
+    line << "\n";
+    std::string s = line.str();
+    if (write(fd_, s.data(), s.size()) != static_cast<ssize_t>(s.size())) return false;
+    return fsync(fd_) == 0;
+}
+
+} // namespace parallel
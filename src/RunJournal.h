@@ -0,0 +1,86 @@
+#ifndef RUN_JOURNAL_H
+#define RUN_JOURNAL_H
+
+#include "ParallelTypes.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace parallel {
+
+struct JournalEntry {
+    std::string step_id;
+    std::string input_fingerprint;
+    std::string output_fingerprint;
+    int exit_code = 0;
+    double elapsed_seconds = 0.0;
+};
+
+// Append-only record of completed plugin steps, one line per step, fsync'd
+// as each step finishes so it survives a crash or an OOM kill. Records are
+// single write()s to an O_APPEND descriptor, so forked scheduler workers can
+// append to the journal they inherited without coordinating. Intermediate
+// outputs collected once read are recorded too, so that their producers and
+// readers still count as completed when the files are gone.
+class RunJournal {
+public:
+    // Opens (creating) the journal at path. With resume the existing records
+    // are loaded and kept; otherwise the journal is started afresh.
+    RunJournal(const std::string& path, bool resume);
+    ~RunJournal();
+
+    RunJournal(const RunJournal&) = delete;
+    RunJournal& operator=(const RunJournal&) = delete;
+
+    bool is_open() const { return fd_ >= 0; }
+
+    // Stable identity of a step: name, resolved input and output, and how
+    // many identical steps were assigned an id before it in this run.
+    std::string assign_id(const PluginTask& task);
+
+    // Hands out ids from the start again, for a config that is read again.
+    void restart_ids();
+
+    // True if task.journal_id was recorded as completed and its input and
+    // output still have the recorded fingerprints, or were collected with
+    // them: a collected output also needs every reader that read it to be
+    // completed in the same sense, or it would have to be made again.
+    bool completed(const PluginTask& task) const;
+
+    // Appends a completed step and flushes it to disk.
+    bool record(const PluginTask& task, const PluginResult& result);
+
+    // Appends that the intermediate at path, as it is now, is about to be
+    // collected, having been read by readers (with their journal ids).
+    bool record_collected(const std::string& path, const std::vector<PluginTask>& readers);
+
+    size_t loaded_count() const { return done_.size(); }
+
+    static std::vector<JournalEntry> load(const std::string& path);
+
+private:
+    struct Collected {
+        std::string fingerprint;
+        std::vector<std::pair<std::string, std::string>> readers;   // journal id, output
+    };
+
+    // Whether path is missing, having been collected with fingerprint.
+    bool collected_as(const std::string& path, const std::string& fingerprint) const;
+
+    // Whether step_id is recorded as completed and its output is as it
+    // left it, or collected with every reader of it still completed.
+    bool output_done(const std::string& step_id, const std::string& output, size_t depth) const;
+
+    int fd_ = -1;
+    std::map<std::string, JournalEntry> done_;
+    std::map<std::string, Collected> collected_;   // by path
+    std::map<std::string, size_t> ordinals_;
+    std::mutex mutex_;
+};
+
+} // namespace parallel
+
+#endif
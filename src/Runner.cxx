@@ -0,0 +1,1343 @@
+/********************************************************************************\
+
+                   Plugin-based Microbiome Analysis (PluMA)
+
+        Copyright (C) 2016, 2018 Bioinformatics Research Group (BioRG)
+                       Florida International University
+
+
+     Permission is hereby granted, free of charge, to any person obtaining
+          a copy of this software and associated documentation files
+        (the "Software"), to deal in the Software without restriction,
+      including without limitation the rights to use, copy, modify, merge,
+      publish, distribute, sublicense, and/or sell copies of the Software,
+       and to permit persons to whom the Software is furnished to do so,
+                    subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included
+            in all copies or substantial portions of the Software.
+
+        THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+      EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+     IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+     CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+      TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+           SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+       For information regarding this software, please contact lead architect
+                    Trevor Cickovski at tcickovs@fiu.edu
+
+\********************************************************************************/
+
+#include "Runner.h"
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "Plugin.h"
+#include "PluginProxy.h"
+#include "ConfigParser.h"
+#include "ParallelScheduler.h"
+#include "DependencyGraph.h"
+#include "PluginCache.h"
+#include "PluginCatalog.h"
+#include "StaticPlugins.h"
+#include "RunJournal.h"
+#include "Planner.h"
+#include "SampleSweep.h"
+#include "Scatter.h"
+#include "Inbox.h"
+#include "Watch.h"
+#include "IntermediateCollector.h"
+#include "Daemon.h"
+#include "Estimator.h"
+#include "RunHistory.h"
+#include <algorithm>
+#include <string>
+#include <map>
+#include <set>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <ctime>
+#include <memory>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+
+#if !PLUMA_PLATFORM_WINDOWS
+    #include <pthread.h>
+#endif
+
+using std::vector;
+
+//////////////////////////////////////////
+// Helper Function: Convert int to string
+std::string toString(int val) {
+   std::string retval;
+   std::stringstream ss;
+   ss << val;
+   ss >> retval;
+   return retval;
+}
+//////////////////////////////////////////
+struct args {
+   char* myFile;
+   char* myPrefix;
+   bool* myDoRestart;
+   char* myRestartPoint;
+};
+
+//////////////////////////////////////////
+// Memoization cache, enabled with --cache[=DIR]
+parallel::PluginCache* pluginCache = NULL;
+
+//////////////////////////////////////////
+// Context for one plugin: the running pipeline's, under the task's prefix and resource hints.
+ExecutionContext taskContext(const parallel::PluginTask& task) {
+    ExecutionContext context = PluginManager::context().withPrefix(task.prefix);
+    ResourceAllotment allotment = context.allotment();
+    if (task.memory_hint > 0) allotment.memory = task.memory_hint;
+    if (task.gpu_hint > 0) allotment.gpu = task.gpu_hint;
+    context.setAllotment(allotment);
+    return context;
+}
+
+//////////////////////////////////////////
+// Progress events for whoever started the run, if anyone (see Runner.h).
+int progressFd = -1;
+
+void reportProgress(const char* event, const std::string& plugin) {
+    if (progressFd < 0) return;
+    std::string line = std::string(event)+"\t"+plugin+"\n";
+    if (write(progressFd, line.data(), line.size()) < 0) {}
+}
+
+//////////////////////////////////////////
+// Per-plugin runtime history shared by every run, off with --no-history
+parallel::RunHistory* runHistory = NULL;
+
+void recordHistory(const parallel::PluginTask& task, const ExecutionContext& context,
+                   double seconds, int exitCode, size_t peakRss) {
+    if (!runHistory) return;
+    parallel::HistoryRecord record;
+    record.timestamp = time(0);
+    record.plugin = task.name;
+    record.language = PluginManager::getInstance().pluginLanguages[task.name+"Plugin"];
+    record.input_bytes = parallel::input_size(task.inputfile);
+    record.input_seconds = context.phaseTimes().input;
+    record.run_seconds = context.phaseTimes().run;
+    record.output_seconds = context.phaseTimes().output;
+    record.total_seconds = seconds;
+    record.exit_code = exitCode;
+    record.peak_rss = peakRss;
+    record.host = parallel::host_name();
+    if (!runHistory->append(record))
+        PluginManager::getInstance().log("Warning: could not record the history of plugin "+task.name+".");
+}
+
+// Predicts how long scheduled tasks will take, so the longest start first
+parallel::CostModel* runtimeModel = NULL;
+
+std::set<std::string> addHistorySamples(parallel::CostModel& model, std::string history);
+
+// A time= hint wins; otherwise the prediction from earlier runs of the plugin.
+void expectRuntime(parallel::PluginTask& task) {
+    if (task.expected_seconds > 0 || !runtimeModel) return;
+    task.expected_seconds = runtimeModel->predict(task.name, parallel::input_size(task.inputfile)).seconds;
+}
+
+// A Kitty is expected to take as long as its pipeline is estimated to.
+void expectKittyRuntime(parallel::PluginTask& kitty) {
+    if (kitty.expected_seconds > 0 || !runtimeModel) return;
+    kitty.expected_seconds = parallel::estimate_plan(parallel::build_plan(kitty.inputfile, kitty.prefix), *runtimeModel).makespan;
+}
+
+// A scheduler worker that died before it could record itself (killed, or
+// out of memory): record it from what wait4 reported.
+void recordLostWorker(const parallel::PluginTask& task, const parallel::PluginResult& result) {
+    if (result.exit_code != -1) return;
+    reportProgress("fail", task.name);
+    if (result.peak_rss == 0) return;
+    recordHistory(task, ExecutionContext(), result.elapsed_seconds, -1, result.peak_rss);
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// In a run a daemon started, each plugin waits for its tenant's share of
+// the daemon's budget, quoting the session the daemon gave the run.
+std::string leaseSocket;
+std::string leaseSession;
+
+//////////////////////////////////////////
+// Run all three steps of a plugin in its language, or restore its outputs from the cache.
+// Returns false if no supported language claims the plugin; plugin errors propagate as exceptions.
+bool executePlugin(const parallel::PluginTask& task, ExecutionContext& context) {
+    std::string name = task.name;
+    for (size_t i = 0; i < PluginManager::supported.size(); i++) {
+        if (PluginManager::getInstance().pluginLanguages[name+"Plugin"] == PluginManager::supported[i]->lang()) {
+            std::string key;
+            if (pluginCache && task.cacheable) {
+                key = pluginCache->key(PluginManager::supported[i]->pluginFile(name), task);
+                if (pluginCache->restore(key, task.outputfile)) {
+                    std::cout << "[PluMA] Cached Plugin: " << name << std::endl;
+                    PluginManager::getInstance().log("Restored outputs of "+name+" from cache entry "+key);
+                    return true;
+                }
+            }
+            std::unique_ptr<DaemonLease> lease;
+            if (!leaseSocket.empty()) {
+                parallel::PluginTask leased = task;
+                expectRuntime(leased);
+                lease.reset(new DaemonLease(leaseSocket, leaseSession, leased));
+                if (!lease->error().empty()) {
+                    std::cout << "[PluMA] Error: " << lease->error() << std::endl;
+                    PluginManager::getInstance().log("Error: "+lease->error()+".");
+                    throw std::runtime_error(lease->error());
+                }
+            }
+            std::cout << "[PluMA] Running Plugin: " << name << std::endl;
+            reportProgress("start", name);
+            PluginManager::awaitLanguage(PluginManager::supported[i]->lang());
+            parallel::PluginCache::Clock::time_point start = parallel::PluginCache::Clock::now();
+            parallel::reset_peak_rss();
+            try {
+                PluginManager::supported[i]->executePlugin(name, task.inputfile, task.outputfile, context);
+            }
+            catch (...) {
+                context.endPhase();
+                recordHistory(task, context, std::chrono::duration<double>(parallel::PluginCache::Clock::now() - start).count(), 1, parallel::peak_rss());
+                throw;
+            }
+            recordHistory(task, context, std::chrono::duration<double>(parallel::PluginCache::Clock::now() - start).count(), 0, parallel::peak_rss());
+            if (!key.empty() && !pluginCache->store(key, task.outputfile, start))
+                PluginManager::getInstance().log("Warning: could not cache the outputs of "+name);
+            return true;
+        }
+    }
+    return false;
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// Durable record of completed steps, read back by --resume
+parallel::RunJournal* runJournal = NULL;
+bool resuming = false;
+
+void stepCompleted(const parallel::PluginTask& task);
+
+// Give a task its journal identity; true if a resumed run already completed it.
+bool alreadyCompleted(parallel::PluginTask& task) {
+    if (!runJournal) return false;
+    task.journal_id = runJournal->assign_id(task);
+    if (!resuming || !runJournal->completed(task)) return false;
+    std::cout << "[PluMA] Skipping Completed Plugin: " << task.name << std::endl;
+    PluginManager::getInstance().log("Skipping plugin "+task.name+", completed in a previous run.");
+    reportProgress("done", task.name);
+    stepCompleted(task);
+    return true;
+}
+
+void journalStep(const parallel::PluginTask& task, std::chrono::steady_clock::time_point start) {
+    reportProgress("done", task.name);
+    if (!runJournal) return;
+    parallel::PluginResult result;
+    result.name = task.name;
+    result.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!runJournal->record(task, result))
+        PluginManager::getInstance().log("Warning: could not journal plugin "+task.name+".");
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// Outputs marked intermediate=yes, collected once their last reader has
+// run; off with --keep-intermediates
+parallel::IntermediateCollector* intermediates = NULL;
+
+// A journaled producer need not run again: the collection is journaled, and
+// --resume counts it as completed with the file gone as long as none of the
+// readers that read it has to run again. A cached one restores it.
+bool regenerable(const parallel::PluginTask& producer) {
+    if (runJournal && runJournal->is_open() && !producer.journal_id.empty()) return true;
+    if (!pluginCache || !producer.cacheable) return false;
+    for (size_t i = 0; i < PluginManager::supported.size(); i++) {
+        if (PluginManager::getInstance().pluginLanguages[producer.name+"Plugin"] == PluginManager::supported[i]->lang())
+            return pluginCache->contains(pluginCache->key(PluginManager::supported[i]->pluginFile(producer.name), producer));
+    }
+    return false;
+}
+
+// In the pluma process (never a scheduler worker), once a step has completed.
+void stepCompleted(const parallel::PluginTask& task) {
+    if (!intermediates) return;
+    std::vector<std::string> collected = intermediates->completed(task);
+    for (size_t i = 0; i < collected.size(); i++) {
+        std::string where = intermediates->moved_path(collected[i]);
+        if (intermediates->moves()) {
+            std::cout << "[PluMA] Moved Intermediate: " << collected[i] << " -> " << where << std::endl;
+            PluginManager::getInstance().log("Moved intermediate "+collected[i]+" to "+where+", its last reader "+task.name+" has completed.");
+        }
+        else {
+            std::cout << "[PluMA] Removed Intermediate: " << collected[i] << std::endl;
+            PluginManager::getInstance().log("Removed intermediate "+collected[i]+", its last reader "+task.name+" has completed.");
+        }
+    }
+    if (intermediates->error() != "")
+        PluginManager::getInstance().log("Warning: "+intermediates->error()+".");
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// Worker run by the scheduler in a forked child: 0 on success, 1 on failure.
+int runTask(const parallel::PluginTask& task) {
+    ExecutionContext context = taskContext(task);
+    ExecutionContext::Scope scope(context);
+    PluginManager::getInstance().log("Creating plugin "+task.name);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    try {
+        if (!executePlugin(task, context)) {
+            PluginManager::getInstance().log("Error, no suitable language for plugin: "+task.name+".");
+            reportProgress("fail", task.name);
+            return 1;
+        }
+        journalStep(task, start);
+    }
+    catch (...) {
+        reportProgress("fail", task.name);
+        return 1;
+    }
+    return 0;
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// Log what the scheduler did; failures are handled as in the sequential case:
+// they are logged and their output files are removed.
+void reportResult(const std::vector<parallel::PluginTask>& tasks, const parallel::SchedulerResult& result, parallel::FailMode failMode, bool kitties = false) {
+    std::string kind = kitties ? "Kitty" : "Plugin";
+    for (size_t i = 0; i < result.completed.size(); i++) {
+        std::stringstream ss;
+        ss << result.completed[i].elapsed_seconds;
+        PluginManager::getInstance().log(kind+" "+result.completed[i].name+" completed in "+ss.str()+"s.");
+        if (!kitties) stepCompleted(tasks[result.completed[i].task_index]);
+    }
+    for (size_t i = 0; i < result.failed.size(); i++) {
+        const parallel::PluginTask& task = tasks[result.failed[i].task_index];
+        PluginManager::getInstance().log(std::string(kitties ? "ERROR IN KITTY: " : "ERROR IN PLUGIN: ")+task.name+".");
+        if (!kitties) recordLostWorker(task, result.failed[i]);
+        if (pluma::platform::fileExists(task.outputfile)) {
+            PluginManager::getInstance().log("REMOVING OUTPUT FILE: "+task.outputfile+".");
+            pluma::platform::removeFile(task.outputfile);
+        }
+    }
+    for (size_t i = 0; i < result.skipped.size(); i++)
+        PluginManager::getInstance().log("SKIPPING PLUGIN: "+result.skipped[i].name+", a dependency failed.");
+    if (!result.failed.empty() && failMode == parallel::FailMode::Fast) {
+        std::cout << "[PluMA] Plugin failure, exiting." << std::endl;
+        exit(1);
+    }
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// Fork the plugins of a Parallel block through the scheduler. Returns false
+// if any plugin failed.
+bool runParallelBlock(const parallel::ParallelBlock& block, bool doRestart, bool& restartFlag, std::string restartPoint) {
+    parallel::ParallelBlock toRun;
+    toRun.options = block.options;
+    toRun.source_line = block.source_line;
+    for (size_t i = 0; i < block.tasks.size(); i++) {
+        if (doRestart && !restartFlag) {
+            if (block.tasks[i].name != restartPoint) continue;
+            restartFlag = true;
+        }
+        parallel::PluginTask task = block.tasks[i];
+        if (alreadyCompleted(task)) continue;
+        expectRuntime(task);
+        toRun.tasks.push_back(task);
+    }
+    if (toRun.tasks.empty()) return true;
+
+    std::vector<std::string> warnings = parallel::validate_parallel_block(toRun);
+    for (size_t i = 0; i < warnings.size(); i++)
+        PluginManager::getInstance().log("Warning: "+warnings[i]);
+
+    std::cout << "[PluMA] Running Parallel Block: " << toRun.tasks.size() << " plugins" << std::endl;
+    PluginManager::getInstance().log("Starting parallel block ("+toString(toRun.tasks.size())+" plugins)");
+    parallel::ParallelScheduler scheduler;
+    parallel::SchedulerResult result = scheduler.run(toRun, runTask);
+    reportResult(toRun.tasks, result, toRun.options.fail_mode);
+    return result.failed.empty();
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// Sweep blocks: one Plugin line over every sample, generated lazily and
+// forked through the scheduler, so only the running samples are in memory.
+class ResumedSweep : public parallel::TaskSource {
+public:
+    ResumedSweep(parallel::TaskSource& samples) : mySamples(samples) {}
+    bool next(parallel::PluginTask& task) {
+        while (mySamples.next(task))
+            if (!alreadyCompleted(task)) return true;
+        return false;
+    }
+private:
+    parallel::TaskSource& mySamples;
+};
+
+bool runSweep(const parallel::SweepBlock& sweep, bool doRestart, bool& restartFlag, std::string restartPoint) {
+    std::string name = parallel::parse_plugin_task(sweep.plugin_line, sweep.prefix).name;
+    if (doRestart && !restartFlag) {
+        if (name != restartPoint) return true;
+        restartFlag = true;
+    }
+
+    parallel::SweepSource samples(sweep);
+    if (samples.error() != "") {
+        std::cout << "[PluMA] Error: " << samples.error() << std::endl;
+        PluginManager::getInstance().log("Error: "+samples.error());
+        return false;
+    }
+    std::cout << "[PluMA] Running Sweep: " << name << " over " << samples.describe() << std::endl;
+    PluginManager::getInstance().log("Starting sweep of "+name+" over "+samples.describe());
+
+    size_t completed = 0;
+    ResumedSweep source(samples);
+    parallel::ParallelScheduler scheduler;
+    parallel::SchedulerResult result = scheduler.run_stream(source, sweep.options, runTask,
+        [&completed](const parallel::PluginTask& task, const parallel::PluginResult& pr) {
+            if (pr.exit_code == 0) {
+                std::stringstream ss;
+                ss << pr.elapsed_seconds;
+                PluginManager::getInstance().log("Plugin "+task.name+" on "+task.inputfile+" completed in "+ss.str()+"s.");
+                stepCompleted(task);
+                completed++;
+                return;
+            }
+            PluginManager::getInstance().log("ERROR IN PLUGIN: "+task.name+" on "+task.inputfile+".");
+            recordLostWorker(task, pr);
+            if (pluma::platform::fileExists(task.outputfile)) {
+                PluginManager::getInstance().log("REMOVING OUTPUT FILE: "+task.outputfile+".");
+                pluma::platform::removeFile(task.outputfile);
+            }
+        });
+
+    std::cout << "[PluMA] Sweep " << name << ": " << completed << " completed, " << result.failed.size() << " failed, "
+              << samples.produced() - completed - result.failed.size() << " skipped" << std::endl;
+    if (!result.failed.empty() && sweep.options.fail_mode == parallel::FailMode::Fast) {
+        std::cout << "[PluMA] Plugin failure, exiting." << std::endl;
+        exit(1);
+    }
+    return result.failed.empty();
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// Scatter blocks: split the input into shards, fork the plugin on each one
+// through the scheduler, then gather the shard outputs into its outputfile.
+bool runScatter(const parallel::ScatterBlock& scatter, bool doRestart, bool& restartFlag, std::string restartPoint) {
+    parallel::PluginTask task = parallel::parse_plugin_task(scatter.plugin_line, scatter.prefix);
+    task.source_line = scatter.plugin_source_line;
+    if (doRestart && !restartFlag) {
+        if (task.name != restartPoint) return true;
+        restartFlag = true;
+    }
+    if (alreadyCompleted(task)) return true;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string dir = parallel::shard_directory(task);
+    std::string error;
+    std::vector<std::string> shards = parallel::split_input(task.inputfile, dir, scatter, error);
+    if (error != "") {
+        std::cout << "[PluMA] Error: " << error << std::endl;
+        PluginManager::getInstance().log("Error: "+error);
+        return false;
+    }
+    std::cout << "[PluMA] Running Scatter: " << task.name << " over " << shards.size() << " shards of " << task.inputfile << std::endl;
+    PluginManager::getInstance().log("Starting scatter of "+task.name+" over "+toString(shards.size())+" shards of "+task.inputfile);
+
+    // Shards a resumed run already finished are not run again. Progress is
+    // reported for the step, not for each of its shards.
+    std::vector<parallel::PluginTask> shardTasks = parallel::shard_tasks(task, shards);
+    std::vector<std::string> parts;
+    parallel::ParallelBlock block;
+    block.options = scatter.options;
+    block.source_line = scatter.source_line;
+    int progress = progressFd;
+    progressFd = -1;
+    for (size_t i = 0; i < shardTasks.size(); i++) {
+        parts.push_back(shardTasks[i].outputfile);
+        expectRuntime(shardTasks[i]);
+        if (!alreadyCompleted(shardTasks[i])) block.tasks.push_back(shardTasks[i]);
+    }
+    if (!block.tasks.empty()) {
+        reportProgress("start", task.name);
+        parallel::ParallelScheduler scheduler;
+        parallel::SchedulerResult result = scheduler.run(block, runTask);
+        progressFd = progress;
+        reportResult(block.tasks, result, scatter.options.fail_mode);
+        if (!result.failed.empty()) {
+            reportProgress("fail", task.name);
+            return false;
+        }
+    }
+    progressFd = progress;
+
+    bool gathered;
+    if (scatter.gather == "concat") {
+        gathered = parallel::concat_shards(parts, task.outputfile, scatter.header_lines, error);
+    }
+    else {
+        // The merge plugin reads the list of shard outputs, which says
+        // nothing about their contents, so it is never served from the cache.
+        parallel::PluginTask merge;
+        merge.name = scatter.gather;
+        merge.inputfile = dir + "/shards.txt";
+        merge.outputfile = task.outputfile;
+        merge.prefix = task.prefix;
+        merge.cacheable = false;
+        gathered = parallel::write_shard_list(parts, merge.inputfile, error);
+        ExecutionContext context = taskContext(merge);
+        try {
+            if (gathered && !executePlugin(merge, context)) {
+                error = "no suitable language for gather plugin "+merge.name;
+                gathered = false;
+            }
+        }
+        catch (...) {
+            error = "gather plugin "+merge.name+" failed";
+            gathered = false;
+        }
+    }
+    if (!gathered) {
+        std::cout << "[PluMA] Error: " << error << std::endl;
+        PluginManager::getInstance().log("ERROR IN PLUGIN: "+task.name+": "+error+".");
+        reportProgress("fail", task.name);
+        if (pluma::platform::fileExists(task.outputfile)) {
+            PluginManager::getInstance().log("REMOVING OUTPUT FILE: "+task.outputfile+".");
+            pluma::platform::removeFile(task.outputfile);
+        }
+        return false;
+    }
+    journalStep(task, start);
+    stepCompleted(task);
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return true;
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// Runs a dependency graph under one budget. A failure under fail=fast ends
+// the process unless exitOnFailure is false, when it is only logged.
+parallel::SchedulerResult scheduleGraph(const parallel::TaskGraph& graph, const parallel::ParallelBlockOptions& options, bool exitOnFailure = true) {
+    size_t edges = 0;
+    for (size_t i = 0; i < graph.dependencies.size(); i++) edges += graph.dependencies[i].size();
+    std::cout << "[PluMA] Running Dependency Graph: " << graph.tasks.size() << " plugins, " << edges << " dependencies" << std::endl;
+    PluginManager::getInstance().log("Starting dependency graph ("+toString(graph.tasks.size())+" plugins, "+toString(edges)+" dependencies)");
+
+    parallel::ParallelScheduler scheduler;
+    parallel::SchedulerResult result = scheduler.run_graph(graph, options, runTask);
+    reportResult(graph.tasks, result, exitOnFailure ? options.fail_mode : parallel::FailMode::Continue);
+    return result;
+}
+
+// Runs tasks as the dependency graph their files imply.
+parallel::SchedulerResult runTaskGraph(const std::vector<parallel::PluginTask>& tasks, const parallel::ParallelBlockOptions& options) {
+    return scheduleGraph(parallel::build_task_graph(tasks), options);
+}
+
+// --dag mode: flatten the whole config (Pipeline includes too), infer the
+// dependencies from inputfile/outputfile and run every plugin as soon as its
+// producers have finished, under a single resource budget.
+void runDependencyGraph(std::string inputfile, const parallel::ParallelBlockOptions& options, bool doRestart, std::string restartPoint) {
+    parallel::FlattenResult flat = parallel::flatten_config(inputfile);
+    if (!flat.errors.empty()) {
+        for (size_t i = 0; i < flat.errors.size(); i++) {
+            std::cout << "[PluMA] Error: " << flat.errors[i] << std::endl;
+            PluginManager::getInstance().log("Error: "+flat.errors[i]);
+        }
+        exit(1);
+    }
+
+    std::vector<parallel::PluginTask> tasks;
+    bool restartFlag = !doRestart;
+    for (size_t i = 0; i < flat.tasks.size(); i++) {
+        if (!restartFlag && flat.tasks[i].name == restartPoint) restartFlag = true;
+        if (restartFlag && !alreadyCompleted(flat.tasks[i])) {
+            expectRuntime(flat.tasks[i]);
+            tasks.push_back(flat.tasks[i]);
+        }
+    }
+
+    if (!runTaskGraph(tasks, options).failed.empty()) exit(1);
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// --watch mode: run the config as --dag does, then keep its steps in memory
+// and, whenever one of its inputs or parameter files or the config itself
+// changes, run only the steps affected and those downstream of them again.
+// Steps that did not complete are retried with the next change.
+void watchFiles(parallel::FileWatcher& watcher, const std::string& config, const std::vector<parallel::PluginTask>& steps) {
+    watcher.watch(config);
+    std::vector<std::string> sources = parallel::source_inputs(steps);
+    for (size_t i = 0; i < sources.size(); i++) watcher.watch(sources[i]);
+    if (watcher.error() != "") {
+        std::cout << "[PluMA] Warning: " << watcher.error() << std::endl;
+        PluginManager::getInstance().log("Warning: "+watcher.error()+".");
+    }
+}
+
+void runWatch(const std::string& config, const parallel::ParallelBlockOptions& options) {
+    parallel::FlattenResult flat = parallel::flatten_config(config);
+    if (!flat.errors.empty()) {
+        for (size_t i = 0; i < flat.errors.size(); i++) std::cout << "[PluMA] Error: " << flat.errors[i] << std::endl;
+        exit(1);
+    }
+    std::vector<parallel::PluginTask> steps = flat.tasks;
+    std::unique_ptr<parallel::FileWatcher> watcher(new parallel::FileWatcher());
+    watchFiles(*watcher, config, steps);
+
+    std::set<size_t> dirty;   // steps to run: not yet completed
+    for (size_t i = 0; i < steps.size(); i++)
+        if (!alreadyCompleted(steps[i])) dirty.insert(i);
+    std::set<std::string> changed;
+    for (;;) {
+        std::vector<size_t> affected = parallel::affected_steps(steps, changed, dirty);
+        if (!affected.empty()) {
+            std::cout << "[PluMA] Watch: running " << affected.size() << " of " << steps.size() << " steps" << std::endl;
+            std::vector<parallel::PluginTask> tasks;
+            for (size_t i = 0; i < affected.size(); i++) {
+                tasks.push_back(steps[affected[i]]);
+                expectRuntime(tasks.back());
+            }
+            parallel::SchedulerResult result = runTaskGraph(tasks, options);
+            dirty = std::set<size_t>(affected.begin(), affected.end());
+            for (size_t i = 0; i < result.completed.size(); i++) dirty.erase(affected[result.completed[i].task_index]);
+        }
+
+        std::cout << "[PluMA] Watching " << watcher->watched() << " files for changes" << std::endl;
+        changed = watcher->wait(-1);
+        for (std::set<std::string>::iterator it = changed.begin(); it != changed.end(); it++)
+            std::cout << "[PluMA] Changed: " << *it << std::endl;
+        if (!changed.count(std::filesystem::path(config).lexically_normal().string())) continue;
+
+        // The config itself: its new and edited lines run, as do the steps
+        // that had not completed under the old one.
+        flat = parallel::flatten_config(config);
+        if (!flat.errors.empty()) {
+            for (size_t i = 0; i < flat.errors.size(); i++) std::cout << "[PluMA] Error: " << flat.errors[i] << std::endl;
+            std::cout << "[PluMA] Keeping the previous config until this one is fixed" << std::endl;
+            continue;
+        }
+        std::vector<parallel::PluginTask> completed;
+        for (size_t i = 0; i < steps.size(); i++)
+            if (!dirty.count(i)) completed.push_back(steps[i]);
+        dirty = parallel::changed_steps(completed, flat.tasks);
+        steps = flat.tasks;
+        if (runJournal) {
+            runJournal->restart_ids();
+            for (size_t i = 0; i < steps.size(); i++) steps[i].journal_id = runJournal->assign_id(steps[i]);
+        }
+        watcher.reset(new parallel::FileWatcher());
+        watchFiles(*watcher, config, steps);
+    }
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// --inbox mode: the config is the pipeline of one sample, run as a batch of
+// its own on every sample that arrives in the inbox. Batches share one
+// budget and overlap, one sample in its third step while the next is in its
+// first. Samples the journal shows completed are not run again.
+class InboxBatches : public parallel::BatchSource {
+public:
+    InboxBatches(parallel::InboxWatcher& inbox, const std::vector<parallel::PluginTask>& steps)
+        : myInbox(inbox), mySteps(steps), myAdmitted(0), myFailed(0) {}
+
+    Status next(parallel::TaskGraph& batch, int timeout_ms) {
+        std::string path;
+        Status status = myInbox.next(path, timeout_ms);
+        if (status != Ready) return status;
+
+        std::vector<parallel::PluginTask> tasks = parallel::sample_tasks(mySteps, path);
+        if (intermediates) intermediates->add_steps(tasks);
+        std::vector<parallel::PluginTask> pending;
+        for (size_t i = 0; i < tasks.size(); i++) {
+            if (alreadyCompleted(tasks[i])) continue;
+            expectRuntime(tasks[i]);
+            pending.push_back(tasks[i]);
+        }
+        batch = parallel::build_task_graph(pending);
+
+        std::string name = parallel::sample_name(path);
+        std::cout << "[PluMA] Inbox: sample " << name << " arrived, " << pending.size() << " of " << tasks.size() << " steps to run" << std::endl;
+        PluginManager::getInstance().log("Inbox sample "+path+" arrived ("+toString(pending.size())+" steps to run)");
+        if (!pending.empty())
+            mySamples[myAdmitted] = SampleProgress{name, tasks, pending.size(), std::chrono::steady_clock::now(), false};
+        else if (intermediates)
+            intermediates->forget(tasks);
+        myAdmitted += pending.size();
+        return Ready;
+    }
+
+    void finished(const parallel::PluginTask& task, const parallel::PluginResult& pr) {
+        std::map<size_t, SampleProgress>::iterator it = mySamples.upper_bound(pr.task_index);
+        if (it == mySamples.begin()) return;
+        --it;
+        SampleProgress& sample = it->second;
+        if (pr.skipped) {
+            PluginManager::getInstance().log("SKIPPING PLUGIN: "+task.name+" on "+task.inputfile+", a dependency failed.");
+        }
+        else if (pr.exit_code != 0) {
+            PluginManager::getInstance().log("ERROR IN PLUGIN: "+task.name+" on "+task.inputfile+".");
+            recordLostWorker(task, pr);
+            if (pluma::platform::fileExists(task.outputfile)) {
+                PluginManager::getInstance().log("REMOVING OUTPUT FILE: "+task.outputfile+".");
+                pluma::platform::removeFile(task.outputfile);
+            }
+            if (!sample.failed) {
+                std::cout << "[PluMA] Inbox: sample " << sample.name << " failed in plugin " << task.name << std::endl;
+                myFailed++;
+            }
+            sample.failed = true;
+        }
+        else {
+            std::stringstream ss;
+            ss << pr.elapsed_seconds;
+            PluginManager::getInstance().log("Plugin "+task.name+" on "+task.inputfile+" completed in "+ss.str()+"s.");
+            stepCompleted(task);
+        }
+        if (--sample.remaining > 0) return;
+        if (!sample.failed) {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - sample.start).count();
+            std::cout << "[PluMA] Inbox: sample " << sample.name << " done in " << parallel::format_seconds(seconds) << std::endl;
+            PluginManager::getInstance().log("Inbox sample "+sample.name+" done.");
+        }
+        // Nothing more of the sample will complete
+        if (intermediates) intermediates->forget(sample.steps);
+        mySamples.erase(it);
+    }
+
+    size_t failed() const { return myFailed; }
+
+private:
+    struct SampleProgress {
+        std::string name;
+        std::vector<parallel::PluginTask> steps;
+        size_t remaining;      // steps not yet ended, skipped ones included
+        std::chrono::steady_clock::time_point start;
+        bool failed;
+    };
+    parallel::InboxWatcher& myInbox;
+    std::vector<parallel::PluginTask> mySteps;
+    std::map<size_t, SampleProgress> mySamples;   // by the scheduler index of their first step
+    size_t myAdmitted;
+    size_t myFailed;
+};
+
+bool runInbox(std::string inputfile, const std::string& dir, double idleSeconds, const parallel::ParallelBlockOptions& options) {
+    parallel::FlattenResult flat = parallel::flatten_config(inputfile);
+    std::vector<std::string> errors = flat.errors;
+    if (errors.empty()) errors = parallel::inbox_step_errors(flat.tasks);
+    parallel::InboxWatcher inbox(dir, idleSeconds);
+    if (errors.empty() && inbox.error() != "") errors.push_back(inbox.error());
+    if (!errors.empty()) {
+        for (size_t i = 0; i < errors.size(); i++) {
+            std::cout << "[PluMA] Error: " << errors[i] << std::endl;
+            PluginManager::getInstance().log("Error: "+errors[i]);
+        }
+        return false;
+    }
+
+    std::cout << "[PluMA] Watching Inbox: " << dir << " (" << flat.tasks.size() << " steps per sample)" << std::endl;
+    PluginManager::getInstance().log("Watching inbox "+dir+" ("+toString(flat.tasks.size())+" steps per sample)");
+    InboxBatches batches(inbox, flat.tasks);
+    parallel::ParallelScheduler scheduler;
+    parallel::SchedulerResult result = scheduler.run_batches(batches, options, runTask,
+        [&batches](const parallel::PluginTask& task, const parallel::PluginResult& pr) { batches.finished(task, pr); });
+
+    std::cout << "[PluMA] Inbox " << dir << ": " << inbox.produced() << " samples, " << batches.failed() << " failed" << std::endl;
+    return result.failed.empty();
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// Planning pass: expand the whole config and report anything that would stop
+// it part way (syntax errors, include cycles, unknown plugins, missing inputs)
+// before the first plugin runs. With print, the plan itself is listed too.
+// With languages, also gives the languages of the plugins it runs.
+bool checkPlan(std::string inputfile, bool print, std::vector<std::string>* languages = NULL) {
+    parallel::Plan plan = parallel::build_plan(inputfile);
+    if (languages) *languages = parallel::plan_languages(plan, PluginManager::getInstance().pluginLanguages);
+    std::vector<std::string> problems = plan.errors;
+    std::vector<std::string> checks = parallel::check_plan(plan, PluginManager::getInstance().pluginLanguages);
+    problems.insert(problems.end(), checks.begin(), checks.end());
+
+    if (print) {
+        for (size_t i = 0; i < plan.steps.size(); i++) {
+            const parallel::PlanStep& step = plan.steps[i];
+            std::cout << "[PluMA] " << toString(i+1) << ". " << step.task.name << " " << step.task.inputfile << " -> " << step.task.outputfile;
+            if (step.sweep) std::cout << " (sweep over " << (step.sweep_block.samples != "" ? step.sweep_block.samples : step.sweep_block.pattern) << ")";
+            else if (step.scatter) std::cout << " (scatter into " << step.scatter_block.shards << " shards, gather " << step.scatter_block.gather << ")";
+            else if (step.parallel) std::cout << " (parallel)";
+            if (step.kitty != "") std::cout << " (kitty " << step.kitty << ")";
+            std::cout << "  [" << step.origin << "]" << std::endl;
+        }
+    }
+    for (size_t i = 0; i < problems.size(); i++) {
+        std::cout << "[PluMA] Error: " << problems[i] << std::endl;
+        PluginManager::getInstance().log("Error: "+problems[i]);
+    }
+    if (print)
+        std::cout << "[PluMA] Plan: " << plan.steps.size() << " plugins from " << plan.files.size() << " config files, " << problems.size() << " problems" << std::endl;
+    return problems.empty();
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// --estimate: predict makespan, critical path and peak memory from the plugin
+// runtime history (the run journal for plugins without any), scaled by input
+// size, without running.
+// Successful runs in the runtime history, as samples. Returns the plugins
+// that had any.
+std::set<std::string> addHistorySamples(parallel::CostModel& model, std::string history) {
+    std::set<std::string> recorded;
+    std::vector<parallel::HistoryRecord> records = parallel::RunHistory::load(history);
+    for (size_t i = 0; i < records.size(); i++) {
+        if (records[i].exit_code != 0) continue;
+        recorded.insert(records[i].plugin);
+        parallel::RunSample sample;
+        sample.plugin = records[i].plugin;
+        sample.input_bytes = records[i].input_bytes;
+        sample.seconds = records[i].total_seconds;
+        sample.peak_rss = records[i].peak_rss;
+        model.add(sample);
+    }
+    return recorded;
+}
+
+std::string pathSummary(const std::vector<std::string>& path) {
+    std::string out;
+    for (size_t i = 0; i < path.size(); i++) {
+        if (path.size() > 12 && i == 5) {
+            out += " -> ... ("+toString(path.size()-10)+" more)";
+            i = path.size() - 5;
+        }
+        out += (i == 0 ? "" : " -> ") + path[i];
+    }
+    return out;
+}
+
+bool estimateRun(std::string inputfile, std::string journal, std::string history) {
+    parallel::Plan plan = parallel::build_plan(inputfile);
+    for (size_t i = 0; i < plan.errors.size(); i++)
+        std::cout << "[PluMA] Error: " << plan.errors[i] << std::endl;
+    if (!plan.errors.empty()) return false;
+
+    parallel::CostModel model;
+    std::set<std::string> recorded = addHistorySamples(model, history);
+
+    // Journal step ids start with "name|inputfile|".
+    std::vector<parallel::JournalEntry> entries = parallel::RunJournal::load(journal);
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].exit_code != 0) continue;
+        std::string id = entries[i].step_id;
+        size_t bar = id.find('|'), bar2 = id.find('|', bar+1);
+        if (bar2 == std::string::npos) continue;
+        parallel::RunSample sample;
+        sample.plugin = id.substr(0, bar);
+        if (recorded.count(sample.plugin)) continue;
+        sample.input_bytes = parallel::input_size(id.substr(bar+1, bar2-bar-1));
+        sample.seconds = entries[i].elapsed_seconds;
+        model.add(sample);
+    }
+
+    parallel::RunEstimate estimate = parallel::estimate_plan(plan, model);
+    for (size_t i = 0; i < estimate.stages.size(); i++) {
+        const parallel::StageEstimate& stage = estimate.stages[i];
+        std::cout << "[PluMA] " << stage.label << " [" << stage.origin << "]: " << parallel::format_seconds(stage.makespan)
+                  << ", peak memory " << parallel::format_bytes(stage.peak_memory);
+        if (stage.unknown > 0) std::cout << " (" << stage.unknown << " without history)";
+        std::cout << std::endl;
+        if (stage.tasks > 1) std::cout << "[PluMA]     critical path: " << pathSummary(stage.critical_path) << std::endl;
+        for (size_t j = 0; j < stage.never_fit.size(); j++)
+            std::cout << "[PluMA]     never fits the budget: " << stage.never_fit[j] << std::endl;
+    }
+    std::cout << "[PluMA] Whole run: makespan " << parallel::format_seconds(estimate.makespan)
+              << ", peak memory " << parallel::format_bytes(estimate.peak_memory) << std::endl;
+    std::cout << "[PluMA] Critical path: " << pathSummary(estimate.critical_path) << std::endl;
+    if (estimate.unknown > 0)
+        std::cout << "[PluMA] " << estimate.unknown << " plugin runs have no recorded history and count as 0s" << std::endl;
+    return true;
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// pluma history [plugin]: a summary per plugin, or one plugin's latest runs.
+void showHistory(std::string path, std::string plugin, size_t limit) {
+    std::vector<parallel::HistoryRecord> records = parallel::RunHistory::load(path);
+    if (records.empty()) {
+        std::cout << "[PluMA] No runtime history in " << path << std::endl;
+        return;
+    }
+    char line[512];
+    if (plugin == "") {
+        struct Summary { size_t runs, failures; double total, longest; size_t rss; long last; };
+        std::map<std::string, Summary> summaries;
+        for (size_t i = 0; i < records.size(); i++) {
+            Summary& s = summaries.insert(std::make_pair(records[i].plugin, Summary())).first->second;
+            s.runs++;
+            if (records[i].exit_code != 0) s.failures++;
+            s.total += records[i].total_seconds;
+            s.longest = std::max(s.longest, records[i].total_seconds);
+            s.rss = std::max(s.rss, records[i].peak_rss);
+            s.last = std::max(s.last, records[i].timestamp);
+        }
+        std::cout << "[PluMA] Runtime history in " << path << std::endl;
+        snprintf(line, sizeof(line), "%-30s %6s %6s %10s %10s %10s  %s", "Plugin", "Runs", "Failed", "Mean", "Longest", "Peak RSS", "Last run");
+        std::cout << line << std::endl;
+        for (std::map<std::string, Summary>::iterator it = summaries.begin(); it != summaries.end(); it++) {
+            char when[32];
+            time_t last = it->second.last;
+            strftime(when, sizeof(when), "%Y-%m-%d %H:%M", localtime(&last));
+            snprintf(line, sizeof(line), "%-30s %6zu %6zu %10s %10s %10s  %s", it->first.c_str(), it->second.runs, it->second.failures,
+                     parallel::format_seconds(it->second.total / it->second.runs).c_str(),
+                     parallel::format_seconds(it->second.longest).c_str(),
+                     parallel::format_bytes(it->second.rss).c_str(), when);
+            std::cout << line << std::endl;
+        }
+        return;
+    }
+
+    std::vector<parallel::HistoryRecord> runs;
+    for (size_t i = 0; i < records.size(); i++)
+        if (records[i].plugin == plugin) runs.push_back(records[i]);
+    if (runs.empty()) {
+        std::cout << "[PluMA] No recorded runs of " << plugin << " in " << path << std::endl;
+        return;
+    }
+    std::cout << "[PluMA] Latest " << std::min(limit, runs.size()) << " of " << runs.size() << " runs of " << plugin << " (" << runs[0].language << ")" << std::endl;
+    snprintf(line, sizeof(line), "%-16s %10s %9s %9s %9s %9s %5s %10s  %s", "When", "Input", "input()", "run()", "output()", "Total", "Exit", "Peak RSS", "Host");
+    std::cout << line << std::endl;
+    for (size_t i = runs.size() > limit ? runs.size() - limit : 0; i < runs.size(); i++) {
+        char when[32];
+        time_t at = runs[i].timestamp;
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M", localtime(&at));
+        snprintf(line, sizeof(line), "%-16s %10s %9s %9s %9s %9s %5d %10s  %s", when,
+                 parallel::format_bytes(runs[i].input_bytes).c_str(),
+                 parallel::format_seconds(runs[i].input_seconds).c_str(),
+                 parallel::format_seconds(runs[i].run_seconds).c_str(),
+                 parallel::format_seconds(runs[i].output_seconds).c_str(),
+                 parallel::format_seconds(runs[i].total_seconds).c_str(),
+                 runs[i].exit_code, parallel::format_bytes(runs[i].peak_rss).c_str(), runs[i].host.c_str());
+        std::cout << line << std::endl;
+    }
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// Kitty pipelines between LitterLaunch and LitterGather are forked through the
+// scheduler, bounded by the LitterLaunch options (same syntax as Parallel).
+bool readConfig(std::string inputfile, std::string prefix, bool doRestart, std::string restartPoint);
+
+int runKitty(const parallel::PluginTask& kitty) {
+    ExecutionContext context = taskContext(kitty);
+    context.setLabel(kitty.name);
+    ExecutionContext::Scope scope(context);
+    return readConfig(kitty.inputfile, kitty.prefix, false, "") ? 0 : 1;
+}
+
+bool runLitter(parallel::ParallelBlock& litter) {
+    for (size_t i = 0; i < litter.tasks.size(); i++) expectKittyRuntime(litter.tasks[i]);
+    std::cout << "[PluMA] Launching Litter: " << litter.tasks.size() << " kitties" << std::endl;
+    PluginManager::getInstance().log("Launching litter ("+toString(litter.tasks.size())+" kitties)");
+    // A kitty's own [PluMA] lines and errors are all it reports.
+    parallel::ParallelScheduler scheduler(parallel::ParallelScheduler::WorkerOutput::Inherit);
+    parallel::SchedulerResult result = scheduler.run(litter, runKitty);
+    for (size_t i = 0; i < result.completed.size(); i++)
+        std::cout << "[PluMA] Gathered Kitty: " << result.completed[i].name << std::endl;
+    reportResult(litter.tasks, result, litter.options.fail_mode, true);
+    return result.failed.empty();
+}
+//////////////////////////////////////////
+
+// Returns false if any plugin failed.
+bool readConfig(std::string inputfile, std::string prefix, bool doRestart, std::string restartPoint) {
+    std::ifstream infile(inputfile.c_str(), std::ios::in);
+    parallel::ParseResult parsed = parallel::parse_config(infile, prefix);
+    if (!parsed.errors.empty()) {
+        for (size_t i = 0; i < parsed.errors.size(); i++) {
+            std::string msg = inputfile+":"+toString(parsed.errors[i].line)+": "+parsed.errors[i].message;
+            std::cout << "[PluMA] Error: " << msg << std::endl;
+            PluginManager::getInstance().log("Error: "+msg);
+        }
+        exit(1);
+    }
+
+    // Everything this config runs and logs happens in its own context
+    ExecutionContext context = PluginManager::context().withPrefix(prefix);
+    ExecutionContext::Scope scope(context);
+
+    bool restartFlag = false;
+    std::string oldprefix = prefix;
+    bool parallelflag = false, kittyflag = false;
+    bool ok = true;
+    std::string kittyname;
+    parallel::ParallelBlock litter;
+    for (size_t s = 0; s < parsed.steps.size(); s++) {
+        if (parsed.steps[s].kind == parallel::ConfigStepKind::Parallel) {
+            ok = runParallelBlock(parsed.steps[s].parallel, doRestart, restartFlag, restartPoint) && ok;
+            continue;
+        }
+        if (parsed.steps[s].kind == parallel::ConfigStepKind::Sweep) {
+            ok = runSweep(parsed.steps[s].sweep, doRestart, restartFlag, restartPoint) && ok;
+            continue;
+        }
+        if (parsed.steps[s].kind == parallel::ConfigStepKind::Scatter) {
+            ok = runScatter(parsed.steps[s].scatter, doRestart, restartFlag, restartPoint) && ok;
+            continue;
+        }
+
+        std::string junk, pipeline, kitty;
+        std::istringstream line(parsed.steps[s].sequential.raw_line);
+        line >> junk;
+        if (junk == "Prefix") {
+            // the line is a prefix
+            line >> prefix;
+            prefix += "/";
+            context.setPrefix(prefix);
+            oldprefix = prefix;
+            continue;
+        } else if (junk == "Pipeline") {
+            line >> pipeline;
+            if (parallelflag && kittyflag) { // Kitty runs alongside its litter
+                litter.tasks.push_back(parallel::parse_kitty_task(parsed.steps[s].sequential.raw_line, kittyname, prefix));
+            }
+            else {
+                ok = readConfig(pipeline, prefix, false, "") && ok;
+            }
+            continue;
+        } else if (junk == "Kitty") {
+            line >> kitty;
+            kittyname = kitty;
+            if (oldprefix != "") {
+                prefix = oldprefix;
+            }
+            prefix += "/"+kitty+"/";
+            context.setPrefix(prefix);
+            kittyflag = true;
+            continue;
+        } else if (junk == "LitterLaunch") {
+            parallelflag = true;
+            litter = parallel::ParallelBlock();
+            litter.options = parallel::parse_parallel_options(parsed.steps[s].sequential.raw_line);
+            continue;
+        } else if (junk == "LitterGather") {
+            if (!litter.tasks.empty()) ok = runLitter(litter) && ok;
+            litter.tasks.clear();
+            parallelflag = false;
+            kittyflag = false;
+            continue;
+        }
+
+        /**
+        * Plugin (Name) inputfile (input file) outputfile (output file)
+        */
+        parallel::PluginTask task = parallel::parse_plugin_task(parsed.steps[s].sequential.raw_line, prefix);
+        std::string name = task.name;
+        std::string outputname = task.outputfile;
+        //////////////////////////////////////////////////////
+
+        ////////////////////////////////////////////////////////////////////////////
+        // If we are restarting and have not hit that point yet, skip this plugin
+        if (doRestart && !restartFlag) {
+            if (name == restartPoint) {
+                restartFlag = true;
+            } else {
+                continue;
+            }
+        }
+        /////////////////////////////////////////////////////////////////////
+
+        /////////////////////////////////////////////////////////////////////
+        // If a resumed run's journal shows this step completed, skip it
+        if (alreadyCompleted(task)) continue;
+        /////////////////////////////////////////////////////////////////////
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Try to create and run all three steps of the plugin in the appropriate language
+        PluginManager::getInstance().log("Creating plugin "+name);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ExecutionContext pluginContext = taskContext(task);
+        try {
+            ///////////////////////////////////////////////////////////////////////////////////////////////////////
+            // In this case we found the plugin, but the language is not PluginManager::supported.
+            if (!executePlugin(task, pluginContext)) {
+                if (name != "") {
+                    ok = false;
+                    PluginManager::getInstance().log("Error, no suitable language for plugin: "+name+".");
+                    reportProgress("fail", name);
+                }
+            }
+            else {
+                journalStep(task, start);
+                stepCompleted(task);
+            }
+            ///////////////////////////////////////////////////////////////////////////////////////////////////////
+        }
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////
+        // This hits if the plugin errored while running it
+        // Message(s) will be output to the logfile, and output files will be removed.
+        catch (...) {
+            ok = false;
+            PluginManager::getInstance().log("ERROR IN PLUGIN: "+name+".");;
+            reportProgress("fail", name);
+            if (pluma::platform::fileExists(outputname)) {
+                PluginManager::getInstance().log("REMOVING OUTPUT FILE: "+outputname+".");
+                pluma::platform::removeFile(outputname);
+                exit(1);
+            }
+        }
+        ////////////////////////////////////////////////////////////////////////////////////////////////////////
+    }
+    // A litter without LitterGather is gathered at the end of its config
+    if (!litter.tasks.empty()) ok = runLitter(litter) && ok;
+    return ok;
+}
+
+
+//////////////////////////////////////////
+// The resource budget of --dag, --inbox and --watch, from options that use
+// the same syntax as a Parallel line.
+parallel::ParallelBlockOptions budgetOptions(std::map<std::string, std::string>& flags) {
+    std::string budget = "Parallel";
+    const char* keys[] = {"workers", "memory", "gpu", "fail", "order", "backfill"};
+    for (size_t i = 0; i < 6; i++)
+        if (flags.count(keys[i])) budget += std::string(" ")+keys[i]+"="+flags[keys[i]];
+    return parallel::parse_parallel_options(budget);
+}
+
+//////////////////////////////////////////
+// Get the current time, and setup the initial log file
+void startLog() {
+    time_t t = time(0);
+    struct tm* now = localtime( &t );
+    std::string currentTime = toString(now->tm_year + 1900) + "-" + toString(now->tm_mon + 1) + "-" + toString(now->tm_mday) + "@" + toString(now->tm_hour) + ":" + toString(now->tm_min) + ":" + toString(now->tm_sec);
+    std::string mylog = "logs/"+currentTime+".log.txt";
+    PluginManager::getInstance().setLogFile(mylog);
+}
+
+// Runtime predictions from the history, and (with record) the history that
+// this run's plugins are added to.
+void openHistory(std::string history, bool record) {
+    runtimeModel = new parallel::CostModel();
+    addHistorySamples(*runtimeModel, history);
+    if (record) {
+        runHistory = new parallel::RunHistory(history);
+        if (!runHistory->is_open())
+            PluginManager::getInstance().log("Warning: cannot open runtime history "+history+".");
+    }
+}
+
+//////////////////////////////////////////
+// Everything a run does once the plugins are loaded: log, cache, planning
+// pass, journal, then the config itself. Also what a daemon runs for each
+// submission, so it must not depend on state left by an earlier run.
+int runConfig(const std::vector<std::string>& args, std::map<std::string, std::string> flags) {
+    ///////////////////////////////////////////////
+    // Check for a restart point
+    bool doRestart = false;
+    std::string restartPoint = "";
+    if (args.size() == 2) {
+        doRestart = true;
+        restartPoint = args[1];
+    }
+    //////////////////////////////////////////////
+
+    startLog();
+
+    if (flags.count("cache") || flags.count("cache-store"))
+        pluginCache = new parallel::PluginCache(flags["cache"].empty() ? ".pluma-cache" : flags["cache"]);
+    if (flags.count("cache-store")) {
+        std::string store = flags["cache-store"];
+        if (store.compare(0, 7, "http://") == 0)
+            pluginCache->add_remote(std::unique_ptr<parallel::CacheStore>(new parallel::HttpStore(store)));
+        else
+            pluginCache->add_remote(std::unique_ptr<parallel::CacheStore>(new parallel::DirectoryStore(store)));
+        PluginManager::getInstance().log("Using shared cache store "+store);
+    }
+
+    std::string history = flags["history"].empty() ? parallel::RunHistory::default_path() : flags["history"];
+    if (flags.count("plan"))
+        exit(checkPlan(args[0], true) ? 0 : 1);
+    if (flags.count("estimate"))
+        exit(estimateRun(args[0], flags["journal"].empty() ? args[0]+".journal" : flags["journal"], history) ? 0 : 1);
+    std::vector<std::string> languages;
+    if (!flags.count("no-plan") && !checkPlan(args[0], false, &languages)) {
+        std::cout << "[PluMA] Nothing was run; fix the errors above (or skip these checks with --no-plan)." << std::endl;
+        exit(1);
+    }
+    // The runtimes the config needs start while its first plugins run; the
+    // others never do. Without a plan, each starts when its first plugin runs.
+    PluginManager::startLanguages(languages);
+
+    if (!flags.count("no-journal")) {
+        // A restarted inbox or watch picks up where it stopped.
+        resuming = flags.count("resume") > 0 || flags.count("inbox") > 0 || flags.count("watch") > 0;
+        std::string journal = flags["journal"].empty() ? args[0]+".journal" : flags["journal"];
+        runJournal = new parallel::RunJournal(journal, resuming);
+        if (!runJournal->is_open())
+            PluginManager::getInstance().log("Warning: cannot open run journal "+journal+".");
+        else if (resuming)
+            PluginManager::getInstance().log("Resuming from "+journal+" ("+toString(runJournal->loaded_count())+" completed steps).");
+    }
+
+    // A watched run may need any output again, to re-run the steps after it.
+    if (!flags.count("keep-intermediates") && !flags.count("watch")) {
+        intermediates = new parallel::IntermediateCollector(regenerable, flags["intermediates"]);
+        if (runJournal && runJournal->is_open()) {
+            intermediates->on_collect([](const std::string& path, const std::vector<parallel::PluginTask>& readers) {
+                if (!runJournal->record_collected(path, readers))
+                    PluginManager::getInstance().log("Warning: could not journal the collection of "+path+".");
+            });
+        }
+        // An --inbox config is a template; each sample's steps are added as it arrives.
+        if (!flags.count("inbox")) intermediates->add_steps(parallel::flatten_config(args[0]).tasks);
+    }
+
+    openHistory(history, !flags.count("no-history"));
+
+    /////////////////////////////////////////////////////////////////////
+    // Read configuration file and make appropriate plugins
+    if (flags.count("inbox")) {
+        // One failed sample should not hold up the ones after it.
+        if (!flags.count("fail")) flags["fail"] = "continue";
+        double idle = flags["idle"].empty() ? 0.0 : parallel::parse_duration(flags["idle"]);
+        if (!runInbox(args[0], flags["inbox"].empty() ? "inbox" : flags["inbox"], idle, budgetOptions(flags))) exit(1);
+    }
+    else if (flags.count("watch")) {
+        if (!flags.count("fail")) flags["fail"] = "continue";
+        runWatch(args[0], budgetOptions(flags));
+    }
+    else if (flags.count("dag")) {
+        runDependencyGraph(args[0], budgetOptions(flags), doRestart, restartPoint);
+    }
+    else {
+        readConfig(args[0], "", doRestart, restartPoint);
+    }
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    return 0;
+}
+
+int runSubmission(const Submission& submission) {
+    if (submission.args.size() != 1 && submission.args.size() != 2) {
+        std::cout << "[PluMA] Error: a submission needs a config file and optionally a restart point" << std::endl;
+        return 1;
+    }
+    leaseSession = submission.flags.at("session");
+    return runConfig(submission.args, submission.flags);
+}
+
+// Logged and recorded in the runtime history like any run, without a
+// journal or a cache.
+int runBlock(const parallel::ParallelBlock& block) {
+    startLog();
+    openHistory(parallel::RunHistory::default_path(), true);
+    bool restartFlag = true;
+    return runParallelBlock(block, false, restartFlag, "") ? 0 : 1;
+}
+
+// The first graph run in a process starts its log and opens the history
+// for every later one.
+parallel::SchedulerResult runGraph(parallel::TaskGraph graph, const parallel::ParallelBlockOptions& options) {
+    if (!runtimeModel) {
+        startLog();
+        openHistory(parallel::RunHistory::default_path(), true);
+    }
+    for (size_t i = 0; i < graph.tasks.size(); i++) expectRuntime(graph.tasks[i]);
+    return scheduleGraph(graph, options, false);
+}
+//////////////////////////////////////////
+
+//////////////////////////////////////////
+// ./plugins, then $PLUMA_PLUGIN_PATH.
+std::string defaultPluginPath() {
+    std::string pluginpath = std::string(PLUMA_PATH_SEPARATOR) + "plugins" + std::string(PLUMA_PATH_SEPARATOR);
+    pluginpath = pluma::platform::getCurrentDirectory() + pluginpath;
+
+    std::string env_plugin_path = pluma::platform::getEnvVar("PLUMA_PLUGIN_PATH");
+    if (!env_plugin_path.empty()) {
+        pluginpath += PLUMA_PATH_LIST_SEPARATOR;
+        pluginpath += env_plugin_path;
+    }
+    pluginpath += PLUMA_PATH_LIST_SEPARATOR;
+    return pluginpath;
+}
+
+// For each PluginManager::supported language, register the plugins in every
+// directory of pluginpath; with list, only print them. What each plugin
+// directory holds comes from the plugin catalog, which scans only the
+// directories changed since the last run. Nothing is loaded here: compiled
+// plugins are opened when they first run.
+void loadPlugins(std::string pluginpath, bool list) {
+    std::string rules;
+    for (size_t i = 0; i < PluginManager::supported.size(); i++)
+        rules += (i > 0 ? " " : "")+PluginManager::supported[i]->lang()+":"+PluginManager::supported[i]->pre()+"*Plugin."+PluginManager::supported[i]->ext();
+    parallel::PluginCatalog catalog(parallel::PluginCatalog::default_path(), rules);
+    parallel::PluginCatalog::Scanner scanner = [](const std::string& dir) {
+        std::vector<parallel::CatalogEntry> found;
+        for (size_t i = 0; i < PluginManager::supported.size(); i++)
+            PluginManager::supported[i]->findPlugins(dir, found);
+        return found;
+    };
+
+    // Compiled into pluma: C++ plugins with no library to find or load. They
+    // run instead of any library of the same name on the plugin path.
+    size_t linkedCount;
+    const StaticPlugin* linked = staticPlugins(linkedCount);
+    for (size_t i = 0; i < PluginManager::supported.size() && linkedCount > 0; i++) {
+        if (!dynamic_cast<Compiled*>(PluginManager::supported[i])) continue;
+        if (list) std::cout << "[PluMA] Plugins compiled into pluma: " << std::endl;
+        for (size_t j = 0; j < linkedCount; j++) {
+            if (list)
+                std::cout << "Plugin: " << linked[j].name << " Language: " << PluginManager::supported[i]->lang() << " Source: " << linked[j].source << std::endl;
+            PluginManager::getInstance().pluginLanguages[std::string(linked[j].name)+"Plugin"] = PluginManager::supported[i]->lang();
+            PluginManager::getInstance().add(linked[j].name);
+        }
+        break;
+    }
+
+    std::string path = pluginpath.substr(0, pluginpath.find_first_of(PLUMA_PATH_LIST_SEPARATOR));
+    while (path.length() > 0) {
+        if (list) std::cout << "[PluMA] Current plugin list: " << std::endl;
+        std::vector<parallel::CatalogEntry> entries = catalog.scan(path, scanner);
+
+        // Language by language, as each once globbed its own plugins.
+        for (size_t i = 0; i < PluginManager::supported.size(); i++) {
+            Language* language = PluginManager::supported[i];
+            bool any = false;
+            for (size_t j = 0; j < entries.size(); j++) {
+                if (entries[j].language != language->lang()) continue;
+                any = true;
+                if (list)
+                    std::cout << "Plugin: " << entries[j].name.substr(0, entries[j].name.length()-6) << " Language: " << entries[j].language << " Path: " << entries[j].path << std::endl;
+                else
+                    language->registerPlugin(entries[j], &(PluginManager::getInstance().pluginLanguages));
+            }
+            if (!any) std::cout << "Found no " << language->lang() << " plugins" << std::endl;
+        }
+
+        std::map<std::string, std::string>::iterator itr;
+
+        for (itr = PluginManager::getInstance().pluginLanguages.begin(); itr != PluginManager::getInstance().pluginLanguages.end(); itr++)
+            PluginManager::getInstance().add(itr->first.substr(0, itr->first.length()-6));
+        pluginpath = pluginpath.substr(pluginpath.find_first_of(PLUMA_PATH_LIST_SEPARATOR)+1, pluginpath.length());
+        path = pluginpath.substr(0, pluginpath.find_first_of(PLUMA_PATH_LIST_SEPARATOR));
+    }
+    if (!catalog.save())
+        std::cout << "[PluMA] Warning: cannot save the plugin catalog " << parallel::PluginCatalog::default_path() << " (set PLUMA_CATALOG)" << std::endl;
+}
+//////////////////////////////////////////
@@ -0,0 +1,57 @@
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include "Daemon.h"
+#include "ParallelTypes.h"
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+// What pluma does once its plugins are loaded, shared by main() and by
+// libpluma's Engine. A run keeps its cache, journal and history in
+// globals, so each one runs in a process of its own: pluma itself, or a
+// child forked for it by a daemon or an Engine. Only runGraph() does not.
+
+// The plugin directories: ./plugins, then those in $PLUMA_PLUGIN_PATH,
+// separated by PLUMA_PATH_LIST_SEPARATOR.
+std::string defaultPluginPath();
+
+// For each supported language, loads the plugins in every directory of
+// pluginpath; with list, also prints them.
+void loadPlugins(std::string pluginpath, bool list);
+
+// A config file with its optional restart point, and the command line
+// options (without "--").
+int runConfig(const std::vector<std::string>& args, std::map<std::string, std::string> flags);
+
+// A daemon submission, in the child forked for it.
+int runSubmission(const Submission& submission);
+
+// A Parallel block given directly rather than in a config file.
+int runBlock(const parallel::ParallelBlock& block);
+
+// A task graph given directly, run in the calling process rather than in
+// one of its own, since it uses no journal or cache. Returns once every
+// task has ended; failures are in the result, and never end the process.
+parallel::SchedulerResult runGraph(parallel::TaskGraph graph, const parallel::ParallelBlockOptions& options);
+
+void showHistory(std::string path, std::string plugin, size_t limit);
+
+// The resource budget of --dag, --inbox and --watch, from options that use
+// the same syntax as a Parallel line.
+parallel::ParallelBlockOptions budgetOptions(std::map<std::string, std::string>& flags);
+
+// In a run a daemon started, the daemon's socket: each plugin waits for
+// its tenant's share of the daemon's budget.
+extern std::string leaseSocket;
+
+// Where a run reports its progress, one line per event, if not -1:
+// "start\tPLUGIN" when a plugin starts running, "done\tPLUGIN" when a
+// step completes or is skipped as completed before, "fail\tPLUGIN" when
+// one fails. Every line is a single write(), so the worker processes of
+// the run can report to the same pipe.
+extern int progressFd;
+
+#endif
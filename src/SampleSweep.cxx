@@ -0,0 +1,81 @@
+#include "SampleSweep.h"
+#include "ConfigParser.h"
+
+#include <glob.h>
+#include <filesystem>
+
+namespace parallel {
+
+namespace fs = std::filesystem;
+
+static void replace_all(std::string& s, const std::string& from, const std::string& to) {
+    for (size_t pos = s.find(from); pos != std::string::npos; pos = s.find(from, pos + to.size())) {
+        s.replace(pos, from.size(), to);
+    }
+}
+
+std::string expand_sweep_line(const std::string& line, const std::string& sample, const std::string& path) {
+    std::string out = line;
+    replace_all(out, "{sample}", sample);
+    replace_all(out, "{path}", path);
+    return out;
+}
+
+std::string sample_name(const std::string& path) {
+    return fs::path(path).stem().string();
+}
+
+SweepSource::SweepSource(const SweepBlock& sweep) : sweep_(sweep) {
+    if (!sweep_.samples.empty()) {
+        list_.open(sweep_.samples);
+        if (!list_) error_ = "cannot open sample list " + sweep_.samples;
+        return;
+    }
+
+    glob_t g;
+    int rc = glob(sweep_.pattern.c_str(), 0, NULL, &g);
+    if (rc == 0) {
+        matches_.assign(g.gl_pathv, g.gl_pathv + g.gl_pathc);
+    } else if (rc != GLOB_NOMATCH) {
+        error_ = "cannot expand glob " + sweep_.pattern;
+    }
+    globfree(&g);
+}
+
+bool SweepSource::next_sample(std::string& sample, std::string& path) {
+    if (list_.is_open()) {
+        std::string line;
+        while (std::getline(list_, line)) {
+            auto start = line.find_first_not_of(" \t\r");
+            if (start == std::string::npos || line[start] == '#') continue;
+            auto end = line.find_last_not_of(" \t\r");
+            sample = path = line.substr(start, end - start + 1);
+            return true;
+        }
+        return false;
+    }
+
+    if (match_ >= matches_.size()) return false;
+    path = matches_[match_++];
+    // The Plugin line is prefixed again when parsed, so hand out the match
+    // relative to the Prefix the pattern was resolved against.
+    const std::string& prefix = sweep_.prefix;
+    if (!prefix.empty() && path.compare(0, prefix.size(), prefix) == 0) path = path.substr(prefix.size());
+    sample = sample_name(path);
+    return true;
+}
+
+bool SweepSource::next(PluginTask& task) {
+    std::string sample, path;
+    if (!next_sample(sample, path)) return false;
+    task = parse_plugin_task(expand_sweep_line(sweep_.plugin_line, sample, path), sweep_.prefix);
+    task.source_line = sweep_.plugin_source_line;
+    produced_++;
+    return true;
+}
+
+std::string SweepSource::describe() const {
+    return sweep_.samples.empty() ? sweep_.pattern : sweep_.samples;
+}
+
+} // namespace parallel
@@ -0,0 +1,64 @@
+#ifndef SAMPLE_SWEEP_H
+#define SAMPLE_SWEEP_H
+
+#include "ParallelScheduler.h"
+#include "ParallelTypes.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+// Replaces every {sample} and {path} in line.
+std::string expand_sweep_line(const std::string& line, const std::string& sample, const std::string& path);
+
+// Sample name of a matched path: its file name without the last extension
+// (data/s1.fastq -> s1).
+std::string sample_name(const std::string& path);
+
+// The tasks of a Sweep block, generated one at a time as the scheduler asks
+// for them:
+//
+//   Sweep samples=samples.txt workers=8 memory=64G fail=continue
+//   Plugin Align inputfile {sample}/reads.fq outputfile {sample}/aligned.bam memory=4G
+//   EndSweep
+//
+// With samples=, every non-blank line of the list that does not start with
+// '#' is a sample, and {sample} and {path} are both that line. With glob=,
+// every matching path (in sorted order) is a sample: {path} is the match
+// relative to the Prefix and {sample} its sample_name. The list is read
+// incrementally and only the matched paths of a glob are held, so a sweep
+// over tens of thousands of samples costs no more than the tasks running.
+class SweepSource : public TaskSource {
+public:
+    explicit SweepSource(const SweepBlock& sweep);
+
+    SweepSource(const SweepSource&) = delete;
+    SweepSource& operator=(const SweepSource&) = delete;
+
+    bool next(PluginTask& task) override;
+
+    // Why no samples could be read (missing list, glob failure); empty if fine.
+    const std::string& error() const { return error_; }
+
+    // Tasks handed out so far.
+    size_t produced() const { return produced_; }
+
+    // What the sweep ranges over, for messages: the list or the pattern.
+    std::string describe() const;
+
+private:
+    bool next_sample(std::string& sample, std::string& path);
+
+    SweepBlock sweep_;
+    std::ifstream list_;
+    std::vector<std::string> matches_;
+    size_t match_ = 0;
+    size_t produced_ = 0;
+    std::string error_;
+};
+
+} // namespace parallel
+
+#endif
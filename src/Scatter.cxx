@@ -0,0 +1,154 @@
+#include "Scatter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace parallel {
+
+namespace fs = std::filesystem;
+
+// dir/stem-00003.ext
+static std::string numbered(const std::string& dir, const std::string& stem, size_t i, const std::string& ext) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "-%05zu", i);
+    return (fs::path(dir) / (stem + buf + ext)).string();
+}
+
+static bool copy_stream(std::istream& in, std::ostream& out, size_t limit) {
+    char buf[1 << 16];
+    while (limit > 0 && in) {
+        in.read(buf, static_cast<std::streamsize>(std::min(limit, sizeof(buf))));
+        std::streamsize n = in.gcount();
+        if (n <= 0) break;
+        out.write(buf, n);
+        limit -= static_cast<size_t>(n);
+    }
+    return static_cast<bool>(out);
+}
+
+std::string shard_directory(const PluginTask& task) {
+    return task.outputfile + ".shards";
+}
+
+std::vector<std::string> split_input(const std::string& input, const std::string& dir,
+                                     const ScatterBlock& scatter, std::string& error) {
+    std::vector<std::string> paths;
+    std::error_code ec;
+    if (!fs::is_regular_file(input, ec)) {
+        error = "Scatter input " + input + " is not a readable file";
+        return paths;
+    }
+    size_t size = fs::file_size(input, ec);
+    fs::create_directories(dir, ec);
+    std::ifstream in(input, std::ios::binary);
+    if (ec || !in) {
+        error = "cannot prepare shards of " + input + " in " + dir;
+        return paths;
+    }
+    // Shards of an earlier split that this one may not overwrite.
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().filename().string().compare(0, 3, "in-") == 0) fs::remove(it->path(), ec);
+    }
+
+    const size_t shards = static_cast<size_t>(std::max(scatter.shards, 1));
+    const std::string ext = fs::path(input).extension().string();
+    std::string header, line;
+    for (int i = 0; i < scatter.header_lines && std::getline(in, line); i++) {
+        header += line;
+        if (!in.eof()) header += '\n';
+    }
+    // Shard k starts at the first allowed cut at or past k/shards of the
+    // body, so rounding does not pile up in the last shard.
+    const size_t body = size - std::min(size, header.size());
+    auto boundary = [&](size_t k) { return static_cast<size_t>(static_cast<double>(body) * k / shards); };
+
+    std::ofstream out;
+    size_t consumed = 0, started = 0;
+    auto open_next = [&]() {
+        out.close();
+        paths.push_back(numbered(dir, "in", paths.size(), ext));
+        out.open(paths.back(), std::ios::binary | std::ios::trunc);
+        out << header;
+        started = consumed;
+    };
+
+    open_next();
+    if (scatter.unit == ShardUnit::Bytes) {
+        while (in.peek() != std::char_traits<char>::eof()) {
+            if (consumed > 0 && paths.size() < shards) open_next();
+            size_t limit = static_cast<size_t>(-1);
+            if (paths.size() < shards) limit = std::max(boundary(paths.size()), consumed + 1) - consumed;
+            if (!copy_stream(in, out, limit)) break;
+            consumed += limit;
+        }
+    } else {
+        const size_t per = scatter.unit == ShardUnit::Records ? static_cast<size_t>(scatter.record_lines) : 1;
+        size_t lines = 0;
+        while (std::getline(in, line)) {
+            bool newline = !in.eof();
+            if (lines % per == 0 && paths.size() < shards && consumed > started &&
+                consumed >= boundary(paths.size())) {
+                open_next();
+            }
+            out << line;
+            if (newline) out << '\n';
+            consumed += line.size() + (newline ? 1 : 0);
+            lines++;
+        }
+    }
+    out.close();
+    if (!out || in.bad()) {
+        error = "cannot write the shards of " + input + " to " + dir;
+        paths.clear();
+    }
+    return paths;
+}
+
+std::vector<PluginTask> shard_tasks(const PluginTask& task, const std::vector<std::string>& shards) {
+    std::vector<PluginTask> tasks;
+    std::string dir = shard_directory(task);
+    std::string ext = fs::path(task.outputfile).extension().string();
+    for (size_t i = 0; i < shards.size(); i++) {
+        PluginTask shard = task;
+        shard.inputfile = shards[i];
+        shard.outputfile = numbered(dir, "part", i, ext);
+        shard.journal_id.clear();
+        if (task.expected_seconds > 0) shard.expected_seconds = task.expected_seconds / shards.size();
+        tasks.push_back(shard);
+    }
+    return tasks;
+}
+
+bool concat_shards(const std::vector<std::string>& parts, const std::string& output,
+                   int header_lines, std::string& error) {
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "cannot write " + output;
+        return false;
+    }
+    for (size_t i = 0; i < parts.size(); i++) {
+        std::ifstream in(parts[i], std::ios::binary);
+        if (!in) {
+            error = "shard output " + parts[i] + " is missing";
+            return false;
+        }
+        std::string skipped;
+        for (int h = 0; i > 0 && h < header_lines && std::getline(in, skipped); h++) {}
+        if (!copy_stream(in, out, static_cast<size_t>(-1))) {
+            error = "cannot write " + output;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool write_shard_list(const std::vector<std::string>& parts, const std::string& path, std::string& error) {
+    std::ofstream out(path, std::ios::trunc);
+    for (const auto& part : parts) out << part << "\n";
+    if (!out) error = "cannot write " + path;
+    return static_cast<bool>(out);
+}
+
+} // namespace parallel
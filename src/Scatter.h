@@ -0,0 +1,50 @@
+#ifndef SCATTER_H
+#define SCATTER_H
+
+#include "ParallelTypes.h"
+
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+// A Scatter block runs its one Plugin line on shards of the input, as
+// separate tasks, then gathers the shard outputs into the line's outputfile:
+//
+//   Scatter shards=16 by=records record=4 workers=16 gather=concat
+//   Plugin QualityFilter inputfile reads.fastq outputfile filtered.fastq
+//   EndScatter
+//
+// by=lines (the default) cuts after any line, by=records after every
+// record= lines and by=bytes anywhere; header=N repeats the first N lines
+// at the top of every shard and keeps only the first shard's copy when
+// concatenating. gather=PLUGIN instead runs that plugin with a file listing
+// the shard outputs, one per line, as its inputfile. The plugin must treat
+// rows (records) independently for the result to equal an unsharded run.
+
+// Where the shards of a scattered task are written: "<outputfile>.shards".
+std::string shard_directory(const PluginTask& task);
+
+// Splits `input` into at most scatter.shards files of about equal size in
+// `dir` (created), cut only where scatter.unit allows, and returns their
+// paths in order. An input too small to fill every shard yields fewer. On
+// failure returns nothing and sets `error`.
+std::vector<std::string> split_input(const std::string& input, const std::string& dir,
+                                     const ScatterBlock& scatter, std::string& error);
+
+// The Plugin line's task run on each shard: same plugin and hints, the
+// shard as inputfile and a part file in the shard directory as outputfile.
+// Both keep the extension of the path they stand in for.
+std::vector<PluginTask> shard_tasks(const PluginTask& task, const std::vector<std::string>& shards);
+
+// Concatenates the shard outputs into `output`, skipping the first
+// header_lines lines of every part but the first.
+bool concat_shards(const std::vector<std::string>& parts, const std::string& output,
+                   int header_lines, std::string& error);
+
+// The input of a gather=PLUGIN merge: the shard outputs, one per line.
+bool write_shard_list(const std::vector<std::string>& parts, const std::string& path, std::string& error);
+
+} // namespace parallel
+
+#endif
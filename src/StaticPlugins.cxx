@@ -0,0 +1,42 @@
+#include "StaticPlugins.h"
+
+#include <cstring>
+
+// Built with PLUMA_STATIC_TABLE only for the pluma executable, with the
+// StaticPlugins.def SConstruct writes: a PLUMA_STATIC_PLUGIN(Name, "directory")
+// line per plugin, in name order. libpluma gets the empty table.
+#ifdef PLUMA_STATIC_TABLE
+#include "PluginProxy.h"
+
+#define PLUMA_STATIC_PLUGIN(name, source) class name##Plugin;
+#include "StaticPlugins.def"
+#undef PLUMA_STATIC_PLUGIN
+#endif
+
+static const StaticPlugin table[] = {
+#ifdef PLUMA_STATIC_TABLE
+#define PLUMA_STATIC_PLUGIN(name, source) {#name, &PluginProxy<name##Plugin>::create, source},
+#include "StaticPlugins.def"
+#undef PLUMA_STATIC_PLUGIN
+#endif
+    {NULL, NULL, NULL}
+};
+
+static const size_t tableSize = sizeof(table) / sizeof(table[0]) - 1;
+
+const StaticPlugin* findStaticPlugin(const std::string& name) {
+    size_t low = 0, high = tableSize;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        int order = std::strcmp(table[mid].name, name.c_str());
+        if (order == 0) return &table[mid];
+        if (order < 0) low = mid + 1;
+        else high = mid;
+    }
+    return NULL;
+}
+
+const StaticPlugin* staticPlugins(size_t& count) {
+    count = tableSize;
+    return table;
+}
@@ -0,0 +1,25 @@
+#ifndef STATICPLUGINS_H
+#define STATICPLUGINS_H
+
+#include <cstddef>
+#include <string>
+
+class Plugin;
+
+// A C++ plugin compiled into pluma (SConstruct --static-plugins) rather than
+// loaded from its lib<Name>Plugin.so.
+struct StaticPlugin {
+    const char* name;       // as in Plugin lines ("Trim")
+    Plugin* (*create)();
+    const char* source;     // its plugin directory when pluma was built
+};
+
+// The plugin compiled in under name, or NULL. The table is sorted when pluma
+// is built, so this is a binary search, with nothing registered at startup.
+const StaticPlugin* findStaticPlugin(const std::string& name);
+
+// All of them in name order, count set to how many; none unless pluma was
+// built with --static-plugins.
+const StaticPlugin* staticPlugins(size_t& count);
+
+#endif
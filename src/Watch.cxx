@@ -0,0 +1,157 @@
+#include "Watch.h"
+#include "DependencyGraph.h"
+#include "Fingerprint.h"
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+namespace parallel {
+
+namespace fs = std::filesystem;
+
+std::vector<std::string> source_inputs(const std::vector<PluginTask>& tasks) {
+    std::vector<std::string> sources;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        const std::string& input = tasks[i].inputfile;
+        if (input.empty() || std::find(sources.begin(), sources.end(), input) != sources.end()) continue;
+        bool produced = false;
+        for (size_t j = 0; j < tasks.size() && !produced; j++) produced = paths_overlap(input, tasks[j].outputfile);
+        if (!produced) sources.push_back(input);
+    }
+    return sources;
+}
+
+// Everything on a Plugin line that changes what the step does.
+static std::string step_key(const PluginTask& task) {
+    std::ostringstream key;
+    key << task.name << '\n' << task.inputfile << '\n' << task.outputfile << '\n'
+        << task.memory_hint << '\n' << task.gpu_hint << '\n' << task.cacheable << '\n'
+        << task.intermediate << '\n' << task.prefix;
+    return key.str();
+}
+
+std::set<size_t> changed_steps(const std::vector<PluginTask>& before, const std::vector<PluginTask>& now) {
+    std::map<std::string, int> old;
+    for (const auto& task : before) old[step_key(task)]++;
+    std::set<size_t> changed;
+    for (size_t i = 0; i < now.size(); i++) {
+        int& count = old[step_key(now[i])];
+        if (count > 0) count--;
+        else changed.insert(i);
+    }
+    return changed;
+}
+
+std::vector<size_t> affected_steps(const std::vector<PluginTask>& tasks, const std::set<std::string>& changed,
+                                   const std::set<size_t>& dirty) {
+    std::vector<size_t> affected;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        bool hit = dirty.count(i) > 0;
+        for (auto it = changed.begin(); !hit && it != changed.end(); ++it)
+            hit = paths_overlap(tasks[i].inputfile, *it);
+        // Downstream of a step that runs again, or a later writer of its
+        // output, which must run again to have the last word.
+        for (size_t k = 0; !hit && k < affected.size(); k++) {
+            const PluginTask& earlier = tasks[affected[k]];
+            hit = paths_overlap(tasks[i].inputfile, earlier.outputfile) ||
+                  paths_overlap(tasks[i].outputfile, earlier.outputfile);
+        }
+        if (hit) affected.push_back(i);
+    }
+    return affected;
+}
+
+static std::string normal(const std::string& path) {
+    std::string s = fs::path(path).lexically_normal().string();
+    while (s.size() > 1 && s.back() == '/') s.pop_back();
+    return s;
+}
+
+FileWatcher::FileWatcher(int settle_ms) : settle_ms_(settle_ms) {
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) error_ = std::string("cannot start inotify: ") + strerror(errno);
+}
+
+FileWatcher::~FileWatcher() {
+    if (fd_ >= 0) close(fd_);
+}
+
+bool FileWatcher::watch(const std::string& path) {
+    if (fd_ < 0) return false;
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ONLYDIR;
+    std::string parent = fs::path(normal(path)).parent_path().string();
+    std::vector<std::string> dirs = {parent.empty() ? "." : parent};
+    std::error_code ec;
+    if (fs::is_directory(path, ec)) dirs.push_back(normal(path));
+    for (const auto& dir : dirs) {
+        int wd = inotify_add_watch(fd_, dir.c_str(), mask);
+        if (wd < 0) {
+            error_ = "cannot watch " + dir + ": " + strerror(errno);
+            return false;
+        }
+        dirs_[wd] = dir;
+    }
+    fingerprints_[normal(path)] = fingerprint_path(path);
+    return true;
+}
+
+bool FileWatcher::read_events(int timeout_ms, std::set<std::string>& touched) {
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) <= 0) return false;
+
+    alignas(struct inotify_event) char buf[16 * (sizeof(struct inotify_event) + 256)];
+    ssize_t n;
+    while ((n = read(fd_, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + n;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+            auto dir = dirs_.find(event->wd);
+            if (dir == dirs_.end() || event->len == 0) continue;
+            std::string changed = normal((fs::path(dir->second) / event->name).string());
+            // The path itself, or a file in a watched directory.
+            if (fingerprints_.count(changed)) touched.insert(changed);
+            if (fingerprints_.count(dir->second) && dir->second != ".") touched.insert(dir->second);
+        }
+    }
+    return true;
+}
+
+std::set<std::string> FileWatcher::wait(int timeout_ms) {
+    std::set<std::string> changed;
+    if (fd_ < 0) return changed;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (;;) {
+        std::set<std::string> touched;
+        int wait = timeout_ms < 0 ? -1 : static_cast<int>(std::max<long long>(0,
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count()));
+        if (!read_events(wait, touched)) return changed;
+        if (touched.empty()) continue;
+        // Let a burst of writes finish: settle_ms without one to a watched path.
+        auto quiet = std::chrono::steady_clock::now() + std::chrono::milliseconds(settle_ms_);
+        for (;;) {
+            long long left = std::chrono::duration_cast<std::chrono::milliseconds>(quiet - std::chrono::steady_clock::now()).count();
+            std::set<std::string> more;
+            if (left <= 0 || !read_events(static_cast<int>(left), more)) break;
+            if (more.empty()) continue;
+            touched.insert(more.begin(), more.end());
+            quiet = std::chrono::steady_clock::now() + std::chrono::milliseconds(settle_ms_);
+        }
+
+        for (const auto& path : touched) {
+            std::string now = fingerprint_path(path);
+            if (now == fingerprints_[path]) continue;
+            fingerprints_[path] = now;
+            changed.insert(path);
+        }
+        if (!changed.empty()) return changed;
+    }
+}
+
+} // namespace parallel
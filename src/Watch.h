@@ -0,0 +1,75 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "ParallelTypes.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace parallel {
+
+// With --watch a config is run once as a dependency graph and then kept in
+// memory: when one of its inputs or parameter files changes, only the
+// steps that read it and the steps downstream of those run again, the
+// outputs of every other step being reused.
+
+// Paths the steps read that no step writes: the config's inputs and
+// parameter files, in order of first use. A file some step overwrites is
+// left out, or every run would cause another.
+std::vector<std::string> source_inputs(const std::vector<PluginTask>& tasks);
+
+// Steps of `now` that `before` has no identical line for (same plugin,
+// paths and hints): the new and edited lines of a config read again.
+std::set<size_t> changed_steps(const std::vector<PluginTask>& before, const std::vector<PluginTask>& now);
+
+// The steps to run again, in config order: those in `dirty`, those whose
+// inputfile overlaps a changed path, and every step that reads, directly or
+// through others, the outputfile of one of them.
+std::vector<size_t> affected_steps(const std::vector<PluginTask>& tasks, const std::set<std::string>& changed,
+                                   const std::set<size_t>& dirty = std::set<size_t>());
+
+// Watches files and directories for changes to their contents with
+// inotify. Each path's parent directory is watched rather than the path,
+// so editors that save by writing a new file and renaming it over the old
+// one are seen, and so is a path created after the watch started. A
+// directory is also watched itself, for files written into it (not into
+// its subdirectories).
+class FileWatcher {
+public:
+    // settle_ms: how long after a change to wait for more before reporting,
+    // so that saving several files causes one re-run.
+    explicit FileWatcher(int settle_ms = 300);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Starts watching path; its contents now are what later changes are
+    // measured against.
+    bool watch(const std::string& path);
+
+    // Waits up to timeout_ms (-1: as long as it takes) for watched paths to
+    // change and returns those whose contents differ from when they were
+    // last reported (or watched). A file saved unchanged is not reported.
+    std::set<std::string> wait(int timeout_ms);
+
+    size_t watched() const { return fingerprints_.size(); }
+
+    // Why a path cannot be watched; empty if fine.
+    const std::string& error() const { return error_; }
+
+private:
+    bool read_events(int timeout_ms, std::set<std::string>& touched);
+
+    int fd_ = -1;
+    int settle_ms_;
+    std::map<int, std::string> dirs_;                  // watch descriptor -> directory
+    std::map<std::string, std::string> fingerprints_;  // watched path -> contents last reported
+    std::string error_;
+};
+
+} // namespace parallel
+
+#endif
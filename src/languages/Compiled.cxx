@@ -32,9 +32,10 @@
 
 #include "Compiled.h"
 #include "../PluginManager.h"
+#include "../StaticPlugins.h"
 #include "../platform.h"
 #include <iostream>
-#include <fstream>
+#include <stdexcept>
 
 Compiled::Compiled(
     std::string lang,
@@ -43,39 +44,53 @@ Compiled::Compiled(
     std::string pre
 ) : Language(lang, ext, pp, pre) {}
 
+std::string Compiled::pluginFile(std::string pluginname) {
+    const StaticPlugin* linked = findStaticPlugin(pluginname);
+    if (linked) return linked->source;
+    return Language::pluginFile(pluginname);
+}
+
+Plugin* Compiled::create(const std::string& pluginname) {
+    const StaticPlugin* linked = findStaticPlugin(pluginname);
+    if (linked) return linked->create();
+
+    std::lock_guard<std::mutex> lock(handlesMutex);
+    std::map<std::string, pluma::platform::LibraryHandle>::const_iterator loaded = handles.find(pluginname);
+    if (loaded == handles.end()) {
+        // Dynamic load takes place here, once; a library that failed to load is not tried again
+        std::string filename = pluginFile(pluginname);
+        pluma::platform::LibraryHandle handle = NULL;
+        if (!filename.empty()) handle = pluma::platform::loadLibrary(filename);
+        if (!handle) {
+            std::cout << "Warning: Null Handle" << std::endl;
+            if (!filename.empty()) std::cout << pluma::platform::getLibraryError() << std::endl;
+        }
+        loaded = handles.insert(std::make_pair(pluginname, handle)).first;
+    }
+    if (!loaded->second || PluginManager::getInstance().makers.count(pluginname) == 0) return NULL;
+    return PluginManager::getInstance().create(pluginname);
+}
+
 void Compiled::executePlugin(
     std::string pluginname,
     std::string inputname,
-    std::string outputname)
+    std::string outputname,
+    ExecutionContext& context)
 {
-    std::string tmppath = pluginpath;
-    std::string path = tmppath.substr(0, pluginpath.find_first_of(PLUMA_PATH_LIST_SEPARATOR));
-    std::ifstream* infile = NULL;
-    std::string filename;
-    do {
-        if (infile) delete infile;
-        filename = path + PLUMA_PATH_SEPARATOR + pluginname + PLUMA_PATH_SEPARATOR + 
-                   PLUMA_SHARED_LIB_PREFIX + pluginname + "Plugin" + PLUMA_SHARED_LIB_EXT;
-        infile = new std::ifstream(filename.c_str(), std::ios::in);
-        tmppath = tmppath.substr(tmppath.find_first_of(PLUMA_PATH_LIST_SEPARATOR)+1, tmppath.length());
-        path = tmppath.substr(0, tmppath.find_first_of(PLUMA_PATH_LIST_SEPARATOR));
-    } while (!(*infile) && path.length() > 0);
-    
-    delete infile;
-    
-    // Dynamic load takes place here
-    pluma::platform::LibraryHandle handle = pluma::platform::loadLibrary(filename);
-    if (!handle) {
-        std::cout << "Warning: Null Handle" << std::endl;
-        std::cout << pluma::platform::getLibraryError() << std::endl;
-    }
-    Plugin* plugin = PluginManager::getInstance().create(pluginname);
+    ExecutionContext::Scope scope(context);
+    Plugin* plugin = create(pluginname);
+    if (!plugin)
+        throw std::runtime_error("C++/CUDA Plugin " + pluginname + " could not be loaded");
 
     PluginManager::getInstance().log("Executing input() For C++/CUDA Plugin "+pluginname);
+    context.beginPhase(ExecutionContext::Input);
     plugin->input(inputname);
     PluginManager::getInstance().log("Executing run() For C++/CUDA Plugin "+pluginname);
+    context.beginPhase(ExecutionContext::Run);
     plugin->run();
     PluginManager::getInstance().log("Executing output() For C++/CUDA Plugin "+pluginname);
+    context.beginPhase(ExecutionContext::Output);
     plugin->output(outputname);
+    context.endPhase();
     PluginManager::getInstance().log("C++/CUDA Plugin "+pluginname+" completed successfully.");
 }
@@ -36,15 +36,30 @@
 #include "Language.h"
 #include <string>
 #include <map>
+#include <mutex>
+
+class Plugin;
 
 class Compiled : public Language
 {
 public:
     Compiled(std::string language, std::string ext, std::string pp, std::string pre);
     //void loadPlugin(std::string path, glob_t* globbuf, std::map<std::string, std::string>* pluginLanguages);
-    virtual void executePlugin(std::string pluginname, std::string inputfile, std::string outputfile);//=0;
+    virtual void executePlugin(std::string pluginname, std::string inputfile, std::string outputfile, ExecutionContext& context);//=0;
     virtual void unload(){}
     virtual void load(){}
+    // For a plugin compiled into pluma, its source directory
+    virtual std::string pluginFile(std::string pluginname);
+
+private:
+    // A new instance of the plugin, or NULL if it cannot be loaded. Unless
+    // it is compiled into pluma, its library is opened the first time the
+    // plugin runs in this process, and its static PluginProxy registers the
+    // maker then.
+    Plugin* create(const std::string& pluginname);
+
+    std::map<std::string, pluma::platform::LibraryHandle> handles;
+    std::mutex handlesMutex;
 };
 
 #endif
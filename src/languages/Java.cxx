@@ -28,8 +28,10 @@ Java::~Java()
 void Java::executePlugin(
     std::string pluginname,
     std::string inputname,
-    std::string outputname
+    std::string outputname,
+    ExecutionContext& context
 ) {
+    ExecutionContext::Scope scope(context);
 #ifdef HAVE_JAVA
     if (!jvm) load();
     if (!env) {
@@ -113,6 +115,7 @@ void Java::executePlugin(
     };
 
     PluginManager::getInstance().log("Executing input() For Java Plugin " + pluginname);
+    context.beginPhase(ExecutionContext::Input);
     if (!callPhaseWithString("input", inputname, "input")) {
         env->DeleteLocalRef(pluginInstance);
         env->DeleteLocalRef(pluginClass);
@@ -120,6 +123,7 @@ void Java::executePlugin(
     }
 
     PluginManager::getInstance().log("Executing run() For Java Plugin " + pluginname);
+    context.beginPhase(ExecutionContext::Run);
     if (!callPhaseNoArgs("run", "run")) {
         env->DeleteLocalRef(pluginInstance);
         env->DeleteLocalRef(pluginClass);
@@ -127,12 +131,14 @@ void Java::executePlugin(
     }
 
     PluginManager::getInstance().log("Executing output() For Java Plugin " + pluginname);
+    context.beginPhase(ExecutionContext::Output);
     if (!callPhaseWithString("output", outputname, "output")) {
         env->DeleteLocalRef(pluginInstance);
         env->DeleteLocalRef(pluginClass);
         return;
     }
 
+    context.endPhase();
     PluginManager::getInstance().log("Java Plugin " + pluginname + " completed successfully.");
     env->DeleteLocalRef(pluginInstance);
     env->DeleteLocalRef(pluginClass);
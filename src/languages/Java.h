@@ -13,7 +13,7 @@ class Java : public Language {
 public:
     Java(std::string language, std::string ext, std::string pp);
     ~Java();
-    void executePlugin(std::string pluginname, std::string inputname, std::string outputname);
+    void executePlugin(std::string pluginname, std::string inputname, std::string outputname, ExecutionContext& context);
     void load();
     void unload();
 
@@ -25,8 +25,10 @@ Julia::~Julia()
 void Julia::executePlugin(
     std::string pluginname,
     std::string inputname,
-    std::string outputname
+    std::string outputname,
+    ExecutionContext& context
 ) {
+    ExecutionContext::Scope scope(context);
 #ifdef HAVE_JULIA
     if (!initialized) load();
     if (!initialized) {
@@ -61,22 +63,26 @@ void Julia::executePlugin(
 
     // Execute input phase
     PluginManager::getInstance().log("Executing input() For Julia Plugin " + pluginname);
+    context.beginPhase(ExecutionContext::Input);
     if (!callPluginFunction(moduleName, "input", inputname)) {
         return;
     }
 
     // Execute run phase
     PluginManager::getInstance().log("Executing run() For Julia Plugin " + pluginname);
+    context.beginPhase(ExecutionContext::Run);
     if (!callPluginFunctionNoArgs(moduleName, "run")) {
         return;
     }
 
     // Execute output phase
     PluginManager::getInstance().log("Executing output() For Julia Plugin " + pluginname);
+    context.beginPhase(ExecutionContext::Output);
     if (!callPluginFunction(moduleName, "output", outputname)) {
         return;
     }
 
+    context.endPhase();
     PluginManager::getInstance().log("Julia Plugin " + pluginname + " completed successfully.");
 #else
     PluginManager::getInstance().log("Julia support is not enabled in this build; skipping " + pluginname + ".");
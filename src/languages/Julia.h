@@ -13,7 +13,7 @@ class Julia : public Language {
 public:
     Julia(std::string language, std::string ext, std::string pp);
     ~Julia();
-    void executePlugin(std::string pluginname, std::string inputname, std::string outputname);
+    void executePlugin(std::string pluginname, std::string inputname, std::string outputname, ExecutionContext& context);
     void load();
     void unload();
 
@@ -32,53 +32,62 @@
 
 #include "Language.h"
 #include "../platform.h"
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 
-#if PLUMA_PLATFORM_WINDOWS
-    using pluma::platform::glob;
-    using pluma::platform::glob_t;
-#endif
+void Language::findPlugins(const std::string& dir, std::vector<parallel::CatalogEntry>& found) {
+    std::string suffix = "Plugin." + extension;
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string file = it->path().filename().string();
+        if (file[0] != '.' && file.length() >= prefix.length() + suffix.length() &&
+            file.compare(file.length() - suffix.length(), suffix.length(), suffix) == 0)
+            files.push_back(file);
+    }
+    std::sort(files.begin(), files.end());
+    for (size_t i = 0; i < files.size(); i++) {
+        std::string name = files[i].substr(prefix.length(), files[i].length() - prefix.length() - extension.length() - 1);
+        if (name == "__init__") continue;
+        found.push_back({name, language, dir + "/" + files[i]});
+    }
+}
+
+bool Language::registerPlugin(const parallel::CatalogEntry& entry, std::map<std::string, std::string>* pluginLanguages) {
+    {
+        // Roots are registered in plugin path order, and the first one wins
+        std::lock_guard<std::mutex> lock(artifactsMutex);
+        artifacts.insert(std::make_pair(entry.name, entry.path));
+    }
+    (*pluginLanguages)[entry.name] = language;
+    return true;
+}
+
+std::string Language::pluginFile(std::string pluginname) {
+    return resolve(pluginname + "Plugin", pluginname + "/" + prefix + pluginname + "Plugin." + extension);
+}
+
+std::string Language::resolve(const std::string& name, const std::string& relative) {
+    std::lock_guard<std::mutex> lock(artifactsMutex);
+    std::map<std::string, std::string>::const_iterator known = artifacts.find(name);
+    if (known != artifacts.end()) return known->second;
+    std::string filename = findOnPluginPath(relative);
+    if (!filename.empty()) artifacts[name] = filename;
+    return filename;
+}
 
-void Language::loadPlugin(
-    std::string path,
-    glob_t* globbuf,
-    std::map<std::string, std::string>* pluginLanguages,
-    bool list
-) {
-    std::string pathGlob = path + "/" + "*/*" + "Plugin." + extension;
-    int ext_len = extension.length()+2;
-    if (glob(pathGlob.c_str(), 0, NULL, &(*globbuf)) == 0) {
-        for (unsigned int i = 0; i < globbuf->gl_pathc; i++) {
-            std::string filename = globbuf->gl_pathv[i];
-            std::string name;
-            std::string::size_type pos = filename.find_last_of("/\\");
-            if (pos != std::string::npos) {
-                name = filename.substr(pos + prefix.length()+1, filename.length()-pos-prefix.length()-ext_len);
-            } else {
-                name = filename.substr(prefix.length(), filename.length()-pos-ext_len);
-            }
-            if (name == "__init__") continue;
-            if (!list) {
-#if PLUMA_PLATFORM_WINDOWS
-                // On Windows, check for .dll extension
-                if (extension == "dll") {
-#else
-                // On Unix, check for .so extension
-                if (extension == "so") {
-#endif
-                    pluma::platform::LibraryHandle handle = pluma::platform::loadLibrary(filename);
-                    if (!handle) {
-                        std::cout << "Warning: Null Handle" << std::endl;
-                        std::cout << pluma::platform::getLibraryError() << std::endl;
-                    } else {
-                        (*pluginLanguages)[name] = language;
-                    }
-                } else {
-                    (*pluginLanguages)[name] = language;
-                }
-            }
+std::string Language::findOnPluginPath(std::string relative) {
+    std::string paths = pluginpath;
+    while (paths.length() > 0) {
+        std::string::size_type sep = paths.find_first_of(PLUMA_PATH_LIST_SEPARATOR);
+        std::string root = paths.substr(0, sep);
+        if (root.length() > 0) {
+            std::string filename = root + "/" + relative;
+            if (pluma::platform::fileExists(filename)) return filename;
         }
-    } else {
-        std::cout << "Found no " << language << " plugins" << std::endl;
+        if (sep == std::string::npos) break;
+        paths = paths.substr(sep+1);
     }
+    return "";
 }
@@ -35,31 +35,51 @@
 
 #include <string>
 #include <map>
+#include <mutex>
+#include <vector>
 #include "../platform.h"
-
-#if PLUMA_PLATFORM_WINDOWS
-    // Use platform.h glob_t emulation
-    using pluma::platform::glob_t;
-#else
-    #include <glob.h>
-#endif
+#include "../ExecutionContext.h"
+#include "../PluginCatalog.h"
 
 class Language {
 public:
     Language(std::string lang, std::string ext, std::string pp, std::string pre="") {language = lang; extension = ext; pluginpath = pp; prefix = pre;}
-    virtual void loadPlugin(std::string path, glob_t* globbuf, std::map<std::string, std::string>* pluginLanguages, bool list);
-    virtual void executePlugin(std::string pluginname, std::string inputfile, std::string outputfile)=0;
+    // Adds the plugins of this language in one plugin directory to found:
+    // files named <prefix>NAMEPlugin.<ext>. Must be safe to call from
+    // several threads; the plugin catalog scans directories in parallel.
+    virtual void findPlugins(const std::string& dir, std::vector<parallel::CatalogEntry>& found);
+    // Makes a plugin the catalog found runnable: true if registered in
+    // pluginLanguages. Only records where it is; nothing is loaded until it runs.
+    virtual bool registerPlugin(const parallel::CatalogEntry& entry, std::map<std::string, std::string>* pluginLanguages);
+    // Runs input(), run() and output() with context installed as the current one
+    virtual void executePlugin(std::string pluginname, std::string inputfile, std::string outputfile, ExecutionContext& context)=0;
     virtual void unload()=0;
     virtual std::string ext() {return extension;}
     virtual std::string lang() {return language;}
     virtual std::string pre() {return prefix;}
+    // Path of the file that implements a plugin, or "" if none is on the plugin path.
+    virtual std::string pluginFile(std::string pluginname);
     virtual void load()=0;
+    // Whether load() may run on a thread of its own while other plugins run.
+    // Not for a runtime bound to the thread that started it.
+    virtual bool loadsInBackground() {return false;}
 
 protected:
+    // First root on the plugin path that contains relative, or "".
+    std::string findOnPluginPath(std::string relative);
+    // Artifact of the plugin registered as name ("CopyPlugin"), looking for
+    // relative on the plugin path only the first time a plugin that was not
+    // registered is asked for.
+    std::string resolve(const std::string& name, const std::string& relative);
+
     std::string language;
     std::string extension;
     std::string prefix;
     std::string pluginpath;
+
+private:
+    std::map<std::string, std::string> artifacts;
+    std::mutex artifactsMutex;
 };
 
 #endif
@@ -66,27 +66,37 @@ Perl::Perl(
 {
     argc2 = 2;
     argv2 = new char*[2];
+    started = false;
+    //my_perl = perl_alloc();
+    //perl_construct(my_perl);
+}
+
+void Perl::load()
+{
+    if (started) return;
 #ifdef HAVE_PERL
     PERL_SYS_INIT3(&argc2, &argv2, &env);
 #endif
-    //my_perl = perl_alloc();
-    //perl_construct(my_perl);
+    started = true;
 }
 
 Perl::~Perl()
 {
     if (argv2) delete[] argv2;
 #ifdef HAVE_PERL
-    PERL_SYS_TERM();
+    if (started) PERL_SYS_TERM();
 #endif
 }
 
 void Perl::executePlugin(
     std::string pluginname,
     std::string inputname,
-    std::string outputname
+    std::string outputname,
+    ExecutionContext& context
 ) {
+    ExecutionContext::Scope scope(context);
 #ifdef HAVE_PERL
+    load();
     //PerlInterpreter *my_perl;
     PluginManager::getInstance().log("Trying to run Perl plugin: "+pluginname+".");
     //char** env;
@@ -122,11 +132,15 @@ void Perl::executePlugin(
     //eval_pv("use lib \'.\';", TRUE);
     /*** skipping perl_run() ***/
     PluginManager::getInstance().log("Executing input() For Perl Plugin "+pluginname);
+    context.beginPhase(ExecutionContext::Input);
     call_argv("input", G_DISCARD, args_input);
     PluginManager::getInstance().log("Executing run() For Perl Plugin "+pluginname);
+    context.beginPhase(ExecutionContext::Run);
     call_argv("run", G_DISCARD | G_NOARGS, args_run);
     PluginManager::getInstance().log("Executing output() For Perl Plugin "+pluginname);
+    context.beginPhase(ExecutionContext::Output);
     call_argv("output", G_DISCARD, args_output);
+    context.endPhase();
     perl_destruct(my_perl);
     perl_free(my_perl);
     //PERL_SYS_TERM();
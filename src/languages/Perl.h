@@ -39,11 +39,14 @@ class Perl : public Language {
 public:
     Perl(std::string language, std::string ext, std::string pp);
     ~Perl();
-    void executePlugin(std::string pluginname, std::string inputname, std::string outputname);
-    void load() {} // Empty
+    void executePlugin(std::string pluginname, std::string inputname, std::string outputname, ExecutionContext& context);
+    // Initializes the Perl library if it is not yet; each plugin runs in an interpreter of its own
+    void load();
     void unload() {} // Empty
+    bool loadsInBackground() {return true;}
 
 private:
+    bool started;
     char** env;
     int argc2;
     char** argv2;
@@ -68,8 +68,10 @@ static void activateVenv(const std::string& cwd) {
 void Py::executePlugin(
     std::string pluginname,
     std::string inputname,
-    std::string outputname
+    std::string outputname,
+    ExecutionContext& context
 ) {
+    ExecutionContext::Scope scope(context);
 #ifdef HAVE_PYTHON
     char* buffer = new char[100];
     std::string cwd = getcwd(buffer, 100);
@@ -93,11 +95,15 @@ void Py::executePlugin(
     PyRun_SimpleString(("import "+pluginname+"Plugin").c_str());
     PyRun_SimpleString(("plugin = "+pluginname+"Plugin."+pluginname+"Plugin()").c_str());
     PluginManager::getInstance().log("[PluMA] Executing input() For Python Plugin "+pluginname);
+    context.beginPhase(ExecutionContext::Input);
     PyRun_SimpleString(("plugin.input(\""+inputname+"\")").c_str());
     PluginManager::getInstance().log("[PluMA] Executing run() For Python Plugin "+pluginname);
+    context.beginPhase(ExecutionContext::Run);
     PyRun_SimpleString("plugin.run()");
     PluginManager::getInstance().log("[PluMA] Executing output() For Python Plugin "+pluginname);
+    context.beginPhase(ExecutionContext::Output);
     PyRun_SimpleString(("plugin.output(\""+outputname+"\")").c_str());
+    context.endPhase();
     //Py_Finalize();
     PluginManager::getInstance().log("[PluMA] Python Plugin "+pluginname+" complted successfully.");
     delete buffer;
@@ -40,7 +40,7 @@
 class Py : public Language {
 public:
     Py(std::string language, std::string ext, std::string pp);
-    void executePlugin(std::string pluginname, std::string inputname, std::string outputname);
+    void executePlugin(std::string pluginname, std::string inputname, std::string outputname, ExecutionContext& context);
     void unload();
     void load() {} // Empty
 };
@@ -33,6 +33,7 @@
 #ifdef HAVE_R
 #include "R.h"
 #include "RInside.h"
+#define CSTACK_DEFNS
 #include "Rinterface.h"
 #endif
 #include "../PluginManager.h"
@@ -49,13 +50,17 @@ R::R(
     this->argc = argc;
     this->argv = argv;
 #ifdef HAVE_R
-    myR = new RInside(argc, argv);
+    myR = NULL;
 #endif
 }
 
 void R::load() {
 #ifdef HAVE_R
+    if (myR) return;
     myR = new RInside(argc, argv);
+    // R measures its C stack from the thread that started it, which may not
+    // be the one that runs the plugins.
+    R_CStackLimit = (uintptr_t) -1;
 #endif
 }
 
@@ -63,9 +68,12 @@ void R::load() {
 void R::executePlugin(
     std::string pluginname,
     std::string inputname,
-    std::string outputname)
+    std::string outputname,
+    ExecutionContext& context)
 {
+    ExecutionContext::Scope scope(context);
 #ifdef HAVE_R
+    load();
     std::string tmppath = pluginpath;
     std::string path = tmppath.substr(0, pluginpath.find_first_of(":"));
     std::ifstream* infile = NULL;
@@ -88,7 +96,9 @@ void R::executePlugin(
     txt += "input(\"" + inputname + "\");\n";
     txt += "run();";
     txt += "output(\"" + outputname + "\");\n";
+    context.beginPhase(ExecutionContext::Run);
     myR->parseEvalQ(txt);
+    context.endPhase();
     PluginManager::getInstance().log("R Plugin "+pluginname+" completed successfully.");
     //unload();
 #endif
@@ -98,8 +108,10 @@ void R::executePlugin(
 void R::unload()
 {
 #ifdef HAVE_R
+    if (!myR) return;
     //delete myR->instancePtr();
     delete myR;
+    myR = NULL;
 
      //R_dot_Last();
      //R_RunExitFinalizers();
@@ -47,9 +47,11 @@ namespace MiAMi {
 class R : public Language {
 public:
     R(std::string language, std::string ext, std::string pp, int argc, char** argv);
-    void executePlugin(std::string pluginname, std::string inputname, std::string outputname);
+    void executePlugin(std::string pluginname, std::string inputname, std::string outputname, ExecutionContext& context);
     void unload();
+    // Starts R if it is not running
     void load();
+    bool loadsInBackground() {return true;}
 
 private:
 #ifdef HAVE_R
@@ -33,7 +33,6 @@
 #include "Rust.h"
 #include "../PluginManager.h"
 #include <iostream>
-#include <fstream>
 
 #ifdef HAVE_RUST
 #include <dlfcn.h>
@@ -45,46 +44,20 @@ Rust::Rust(
     std::string pp
 ) : Language(language, ext, pp, "lib") {}
 
-void Rust::loadPlugin(
-    std::string path,
-    glob_t* globbuf,
-    std::map<std::string, std::string>* pluginLanguages,
-    bool list
-) {
+void Rust::findPlugins(const std::string& dir, std::vector<parallel::CatalogEntry>& found) {
 #ifdef HAVE_RUST
     // Rust plugins are identified by the presence of Cargo.toml
     // and a compiled .so file (lib*Plugin.so)
-    std::string pathGlob = path + "/*/Cargo.toml";
-
-    if (glob(pathGlob.c_str(), 0, NULL, globbuf) == 0) {
-        for (unsigned int i = 0; i < globbuf->gl_pathc; i++) {
-            std::string cargoPath = globbuf->gl_pathv[i];
-
-            // Extract plugin directory and name
-            std::string pluginDir = cargoPath.substr(0, cargoPath.find_last_of("/"));
-            std::string pluginName = pluginDir.substr(pluginDir.find_last_of("/") + 1);
-
-            // Check if compiled .so exists
-            std::string soPath = pluginDir + "/lib" + pluginName + "Plugin.so";
-            std::ifstream soFile(soPath.c_str());
-
-            if (soFile.good()) {
-                // Register this as a Rust plugin
-                std::string keyName = pluginName + "Plugin";
-                (*pluginLanguages)[keyName] = language;
-
-                if (list) {
-                    std::cout << "Plugin: " << pluginName << " Language: " << language << " Path: " << pluginDir << std::endl;
-                }
-            } else {
-                std::cout << "Warning: Rust plugin " << pluginName << " found but not compiled (missing " << soPath << ")" << std::endl;
-            }
-        }
+    if (!pluma::platform::fileExists(dir + "/Cargo.toml")) return;
+    std::string pluginName = dir.substr(dir.find_last_of("/") + 1);
+
+    // Check if compiled .so exists
+    std::string soPath = dir + "/lib" + pluginName + "Plugin.so";
+    if (pluma::platform::fileExists(soPath)) {
+        found.push_back({pluginName + "Plugin", language, soPath});
     } else {
-        std::cout << "Found no " << language << " plugins" << std::endl;
+        std::cout << "Warning: Rust plugin " << pluginName << " found but not compiled (missing " << soPath << ")" << std::endl;
     }
-#else
-    std::cout << "Found no " << language << " plugins (Rust support not compiled)" << std::endl;
 #endif
 }
 
@@ -92,7 +65,11 @@ void Rust::loadPlugin(
 RustPluginVTable Rust::loadRustPlugin(const std::string& path, const std::string& pluginname) {
     RustPluginVTable vtable = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
 
-    // Open the shared library
+    // Open the shared library; dlopen("") would return the program itself
+    if (path.empty()) {
+        std::cerr << "[PluMA] Error loading Rust plugin " << pluginname << ": not found in plugin path" << std::endl;
+        return vtable;
+    }
     void* handle = dlopen(path.c_str(), RTLD_LAZY | RTLD_GLOBAL);
     if (!handle) {
         std::cerr << "[PluMA] Error loading Rust plugin " << pluginname << ": " << dlerror() << std::endl;
@@ -143,34 +120,33 @@ RustPluginVTable Rust::loadRustPlugin(const std::string& path, const std::string
 
     return vtable;
 }
+
+RustPluginVTable Rust::library(const std::string& pluginname) {
+    std::lock_guard<std::mutex> lock(loadedMutex);
+    std::map<std::string, RustPluginVTable>::const_iterator loaded = loadedPlugins.find(pluginname);
+    if (loaded != loadedPlugins.end()) return loaded->second;
+    // Kept even if incomplete, so a broken library is not opened again
+    RustPluginVTable vtable = loadRustPlugin(pluginFile(pluginname), pluginname);
+    loadedPlugins[pluginname] = vtable;
+    return vtable;
+}
 #endif
 
+std::string Rust::pluginFile(std::string pluginname) {
+    // The artifact is the compiled library, not the crate sources
+    return resolve(pluginname + "Plugin", pluginname + "/lib" + pluginname + "Plugin.so");
+}
+
 void Rust::executePlugin(
     std::string pluginname,
     std::string inputname,
-    std::string outputname)
+    std::string outputname,
+    ExecutionContext& context)
 {
+    ExecutionContext::Scope scope(context);
 #ifdef HAVE_RUST
-    std::string tmppath = pluginpath;
-    std::string path = tmppath.substr(0, pluginpath.find_first_of(":"));
-    std::ifstream* infile = nullptr;
-    std::string filename;
-
-    // Search for the Rust plugin shared library in plugin paths
-    // Note: Rust plugins are compiled to .so files, not .rs
-    do {
-        if (infile) delete infile;
-        // Rust plugins are compiled to lib<PluginName>Plugin.so
-        filename = path + "/" + pluginname + "/lib" + pluginname + "Plugin.so";
-        infile = new std::ifstream(filename.c_str(), std::ios::in);
-        tmppath = tmppath.substr(tmppath.find_first_of(":") + 1, tmppath.length());
-        path = tmppath.substr(0, tmppath.find_first_of(":"));
-    } while (!(*infile) && path.length() > 0);
-
-    delete infile;
-
     // Load the Rust plugin
-    RustPluginVTable vtable = loadRustPlugin(filename, pluginname);
+    RustPluginVTable vtable = library(pluginname);
 
     if (!vtable.create || !vtable.input || !vtable.run || !vtable.output || !vtable.destroy) {
         PluginManager::getInstance().log("Error: Failed to load Rust plugin " + pluginname);
@@ -188,28 +164,30 @@ void Rust::executePlugin(
 
     // Execute plugin phases
     PluginManager::getInstance().log("Executing input() For Rust Plugin " + pluginname);
+    context.beginPhase(ExecutionContext::Input);
     vtable.input(plugin_instance, inputname.c_str());
 
     PluginManager::getInstance().log("Executing run() For Rust Plugin " + pluginname);
+    context.beginPhase(ExecutionContext::Run);
     vtable.run(plugin_instance);
 
     PluginManager::getInstance().log("Executing output() For Rust Plugin " + pluginname);
+    context.beginPhase(ExecutionContext::Output);
     vtable.output(plugin_instance, outputname.c_str());
+    context.endPhase();
 
     // Cleanup
     PluginManager::getInstance().log("Destroying Rust Plugin " + pluginname);
     vtable.destroy(plugin_instance);
 
     PluginManager::getInstance().log("Rust Plugin " + pluginname + " completed successfully.");
-
-    // Store vtable for potential cleanup
-    loadedPlugins[pluginname] = vtable;
 #endif
 }
 
 void Rust::unload() {
 #ifdef HAVE_RUST
     // Close all loaded plugin handles
+    std::lock_guard<std::mutex> lock(loadedMutex);
     for (auto& pair : loadedPlugins) {
         if (pair.second.handle) {
             dlclose(pair.second.handle);
@@ -35,6 +35,7 @@
 
 #include "Language.h"
 #include <map>
+#include <mutex>
 #include <string>
 
 #ifdef HAVE_RUST
@@ -62,15 +63,20 @@ struct RustPluginVTable {
 class Rust : public Language {
 public:
     Rust(std::string language, std::string ext, std::string pp);
-    void loadPlugin(std::string path, glob_t* globbuf, std::map<std::string, std::string>* pluginLanguages, bool list);
-    void executePlugin(std::string pluginname, std::string inputname, std::string outputname);
+    // A crate directory (Cargo.toml) with its compiled lib<Dir>Plugin.so.
+    void findPlugins(const std::string& dir, std::vector<parallel::CatalogEntry>& found);
+    void executePlugin(std::string pluginname, std::string inputname, std::string outputname, ExecutionContext& context);
     void unload();
     void load() {}
+    std::string pluginFile(std::string pluginname);
 
 private:
 #ifdef HAVE_RUST
+    // Each plugin's library, opened the first time it runs in this process
     std::map<std::string, RustPluginVTable> loadedPlugins;
+    std::mutex loadedMutex;
     RustPluginVTable loadRustPlugin(const std::string& path, const std::string& pluginname);
+    RustPluginVTable library(const std::string& pluginname);
 #endif
 };
 
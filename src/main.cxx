@@ -33,156 +33,16 @@
 #include "platform.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include "Plugin.h"
-#include "PluginProxy.h"
-#include <string>
+#include "PluginManager.h"
+#include "Runner.h"
+#include "Daemon.h"
+#include "Estimator.h"
+#include "FairShare.h"
+#include "RunHistory.h"
+#include <iostream>
 #include <map>
+#include <string>
 #include <vector>
-#include <fstream>
-#include <sstream>
-#include <ctime>
-#include <thread>
-
-#if PLUMA_PLATFORM_WINDOWS
-    using pluma::platform::glob_t;
-    using pluma::platform::glob;
-#else
-    #include <glob.h>
-    #include <pthread.h>
-#endif
-
-using std::thread;
-using std::vector;
-
-//////////////////////////////////////////
-// Helper Function: Convert int to string
-std::string toString(int val) {
-   std::string retval;
-   std::stringstream ss;
-   ss << val;
-   ss >> retval;
-   return retval;
-}
-//////////////////////////////////////////
-struct args {
-   char* myFile;
-   char* myPrefix;
-   bool* myDoRestart;
-   char* myRestartPoint;
-};
-
-void readConfig(std::string inputfile, std::string prefix, bool doRestart, std::string restartPoint) {
-    void* status;
-    std::ifstream infile(inputfile.c_str(), std::ios::in);
-    bool restartFlag = false;
-    std::string pipeline = "";
-    std::string oldprefix = prefix;
-    std::string kitty = "";
-    bool parallelflag, kittyflag;
-    vector<std::thread> threads;
-    while (!infile.eof()) {
-        std::string junk, name, inputname, outputname;
-        /**
-        * Read one line
-        * Plugin (Name) inputfile (input file) outputfile (output file)
-        */
-        infile >> junk;
-        if (junk[0] == '#') {
-            // the line is a comment
-            getline(infile, junk);
-            continue;
-        } else if (junk == "Prefix") {
-            // the line is a prefix
-            infile >> prefix;
-            prefix += "/";
-            PluginManager::myPrefix=prefix;
-            oldprefix = prefix;
-            continue;
-        } else if (junk == "Pipeline") {
-            infile >> pipeline;
-	    if (parallelflag && kittyflag) { // Kitty is multithreaded
-		threads.push_back(std::thread(readConfig, pipeline, prefix, false, ""));
-	    }
-	    else {
-            readConfig(pipeline, prefix, false, "");
-	    }
-        } else if (junk == "Kitty") {
-            infile >> kitty;
-            if (oldprefix != "") {
-                prefix = oldprefix;
-            }
-            prefix += "/"+kitty+"/";
-            PluginManager::myPrefix=prefix;
-	    kittyflag = true;
-            continue;
-	}
-	else if (junk == "LitterLaunch") {
-            parallelflag = true;
-	}
-	else if (junk == "LitterGather") {
-	    for (size_t i = 0; i < threads.size(); i++){
-	       std::cout << "[PluMA] Gathering Kitty " << i << std::endl;
-	       threads[i].join();
-	    }
-	    parallelflag = false;
-	    kittyflag = false;
-        } else {
-            infile >> name >> junk >> inputname >> junk >> outputname;
-        }
-
-        if (inputname.length() > 0 && inputname[0] != '/' && inputname[0] != '\\') {
-            inputname = prefix + inputname;
-        }
-
-        if (outputname.length() > 0 && outputname[0] != '/' && outputname[0] != '\\') {
-            outputname = prefix + outputname;
-        }
-        //////////////////////////////////////////////////////
-
-        ////////////////////////////////////////////////////////////////////////////
-        // If we are restarting and have not hit that point yet, skip this plugin
-        if (doRestart && !restartFlag) {
-            if (name == restartPoint) {
-                restartFlag = true;
-            } else {
-                continue;
-            }
-        }
-        /////////////////////////////////////////////////////////////////////
-
-        ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-        // Try to create and run all three steps of the plugin in the appropriate language
-        PluginManager::getInstance().log("Creating plugin "+name);
-        try {
-            bool executed = false;
-            for (size_t i = 0; i < PluginManager::supported.size() && !executed; i++) {
-                if (PluginManager::getInstance().pluginLanguages[name+"Plugin"] == PluginManager::supported[i]->lang()) {
-                    std::cout << "[PluMA] Running Plugin: " << name << std::endl;
-                    PluginManager::supported[i]->executePlugin(name, inputname, outputname);
-                    executed = true;
-                }
-            }
-            ///////////////////////////////////////////////////////////////////////////////////////////////////////
-            // In this case we found the plugin, but the language is not PluginManager::supported.
-            if (!executed && name != "") {
-                PluginManager::getInstance().log("Error, no suitable language for plugin: "+name+".");
-            }
-            ///////////////////////////////////////////////////////////////////////////////////////////////////////
-        }
-        ///////////////////////////////////////////////////////////////////////////////////////////////////////
-        // This hits if the plugin errored while running it
-        // Message(s) will be output to the logfile, and output files will be removed.
-        catch (...) {
-            PluginManager::getInstance().log("ERROR IN PLUGIN: "+name+".");;
-            if (pluma::platform::fileExists(outputname)) {
-                PluginManager::getInstance().log("REMOVING OUTPUT FILE: "+outputname+".");
-                pluma::platform::removeFile(outputname);
-                exit(1);
-            }
-        }
-        ////////////////////////////////////////////////////////////////////////////////////////////////////////
-    }
-}
 
 
 int main(int argc, char** argv)
@@ -215,15 +75,7 @@ int main(int argc, char** argv)
     std::cout << "***********************************************************************************" << std::endl;
     ///////////////////////////////////////////////////////////////////////////////////////////////
     // Setup plugin path.
-    std::string pluginpath = std::string(PLUMA_PATH_SEPARATOR) + "plugins" + std::string(PLUMA_PATH_SEPARATOR);
-    pluginpath = pluma::platform::getCurrentDirectory() + pluginpath;
-    
-    std::string env_plugin_path = pluma::platform::getEnvVar("PLUMA_PLUGIN_PATH");
-    if (!env_plugin_path.empty()) {
-        pluginpath += PLUMA_PATH_LIST_SEPARATOR;
-        pluginpath += env_plugin_path;
-    }
-    pluginpath += PLUMA_PATH_LIST_SEPARATOR;
+    std::string pluginpath = defaultPluginPath();
     ///////////////////////////////////////////////////////////////////////////////////////////////
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -232,72 +84,128 @@ int main(int argc, char** argv)
 
     ///////////////////////////////////////////////////////////////////////////////////////////////
     // Command line arguments
-    if ((argc != 2 && argc != 3) || std::string(argv[1]) == "usage") { // Usage
-        std::cout << "[PluMA] Usage: ./pluma (config file) (optional restart point)" << std::endl;
+    // Options are --name or --name=value and may appear anywhere.
+    std::map<std::string, std::string> flags;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") == 0) {
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos) flags[arg.substr(2)] = "";
+            else flags[arg.substr(2, eq-2)] = arg.substr(eq+1);
+        }
+        else {
+            args.push_back(arg);
+        }
+    }
+    if ((args.size() != 1 && args.size() != 2) || args[0] == "usage") { // Usage
+        std::cout << "[PluMA] Usage: ./pluma [options] (config file) (optional restart point)" << std::endl;
         std::cout << "Arguments: help: display this message" << std::endl;
         std::cout << "           version: display release information" << std::endl;
         std::cout << "           plugins: list your installed plugins and location" << std::endl;
+        std::cout << "           daemon: keep plugins and language runtimes loaded and run configs sent with --submit" << std::endl;
+        std::cout << "           tenants: show each tenant's share and usage of a running daemon's budget" << std::endl;
+        std::cout << "           history (optional plugin): summarize recorded plugin runs, or list one plugin's latest (--limit=N, default 20)" << std::endl;
+        std::cout << "Options:   --dag: run the whole config as a dependency graph inferred from inputfile/outputfile" << std::endl;
+        std::cout << "           --inbox[=DIR]: run the config, a pipeline for one {sample} or {path}, on every file that arrives in DIR (default inbox), samples overlapping" << std::endl;
+        std::cout << "           --idle=TIME: with --inbox, stop watching once no sample has arrived for TIME (90s, 45m, 3h)" << std::endl;
+        std::cout << "           --watch: run the config as --dag does, then re-run just the steps affected, and those downstream, whenever an input, parameter file or the config changes" << std::endl;
+        std::cout << "           --workers=N --memory=SIZE --gpu=N --fail=fast|continue --order=longest|config --backfill=yes|no: resource budget and dispatch policy for --dag, --inbox and --watch" << std::endl;
+        std::cout << "           --cache[=DIR]: reuse outputs of plugins whose code and input are unchanged (default .pluma-cache)" << std::endl;
+        std::cout << "           --plan: list what the config would run and check it without running anything" << std::endl;
+        std::cout << "           --no-plan: start without checking plugins and inputs first" << std::endl;
+        std::cout << "           --estimate: predict makespan, critical path and peak memory from recorded runs, without running anything" << std::endl;
+        std::cout << "           --resume: skip the steps that the run journal shows completed with unchanged input and output" << std::endl;
+        std::cout << "           --journal=FILE: run journal location (default: config file + .journal); --no-journal disables it" << std::endl;
+        std::cout << "           --cache-store=DIR|http://HOST[:PORT]/PATH: also share cache entries through a directory or HTTP server" << std::endl;
+        std::cout << "           --submit: run the config in a running daemon, with these options, and print its progress" << std::endl;
+        std::cout << "           --intermediates=DIR: move outputs marked intermediate=yes under DIR once their last reader has run, instead of removing them" << std::endl;
+        std::cout << "           --keep-intermediates: keep outputs marked intermediate=yes" << std::endl;
+        std::cout << "           --history=FILE: runtime history location (default: $PLUMA_HISTORY or ~/.pluma/history); --no-history disables it" << std::endl;
+        std::cout << "           --tenant=NAME: with --submit, label the run YOU/NAME within your share of the daemon's budget" << std::endl;
+        std::cout << "           --workers=N --memory=SIZE --gpu=N with daemon: the budget shared by every submitted run (default: as for a Parallel block)" << std::endl;
+        std::cout << "           --weights=USER:W,...: with daemon, give users more (W > 1) or less than an equal share" << std::endl;
+        std::cout << "           --shared: with daemon, let the users in your group submit too" << std::endl;
+        std::cout << "           --socket=PATH: daemon socket for daemon and --submit (default: $PLUMA_SOCKET or /tmp/pluma-UID.sock)" << std::endl;
         exit(0);
-    } else if (std::string(argv[1]) == "help") { // Help
-        std::cout << "[PluMA] Usage: ./pluma (config file) (optional restart point)" << std::endl;
+    } else if (args[0] == "help") { // Help
+        std::cout << "[PluMA] Usage: ./pluma [options] (config file) (optional restart point)" << std::endl;
         exit(0);
-    } else if (std::string(argv[1]) == "version") { // Version
+    } else if (args[0] == "version") { // Version
         std::cout << "[PluMA] Version 2.0" << std::endl;
         exit(0);
+    } else if (args[0] == "history") { // Runtime history, nothing to load
+        showHistory(flags["history"].empty() ? parallel::RunHistory::default_path() : flags["history"],
+                    args.size() == 2 ? args[1] : "", flags["limit"].empty() ? 20 : atoi(flags["limit"].c_str()));
+        exit(0);
     }
 
-    PluginManager::supportedLanguages(pluginpath, argc, argv);
-    //////////////////////////////////////////////////////////////////////////////////////////
-    // For each PluginManager::supported language, load the appropriate plugins
-    std::string path = pluginpath.substr(0, pluginpath.find_first_of(PLUMA_PATH_LIST_SEPARATOR));
-    bool list = false;
-    while (path.length() > 0) {
-        glob_t globbuf;
-        if (std::string(argv[1]) == "plugins") {
-            std::cout << "[PluMA] Current plugin list: " << std::endl;
-            list = true;
+    else if (args[0] == "tenants") { // Per-tenant usage, from a running daemon
+        std::string socket = flags["socket"].empty() ? Daemon::defaultSocket() : flags["socket"];
+        if (!requestTenantUsage(socket, std::cout)) {
+            std::cout << "[PluMA] Error: no daemon is listening on " << socket << std::endl;
+            exit(1);
         }
-
-        for (size_t i = 0; i < PluginManager::supported.size(); i++)
-            PluginManager::supported[i]->loadPlugin(path, &globbuf, &(PluginManager::getInstance().pluginLanguages), list);
-
-        std::map<std::string, std::string>::iterator itr;
-
-        for (itr = PluginManager::getInstance().pluginLanguages.begin(); itr != PluginManager::getInstance().pluginLanguages.end(); itr++)
-            PluginManager::getInstance().add(itr->first.substr(0, itr->first.length()-6));
-        pluginpath = pluginpath.substr(pluginpath.find_first_of(PLUMA_PATH_LIST_SEPARATOR)+1, pluginpath.length());
-        path = pluginpath.substr(0, pluginpath.find_first_of(PLUMA_PATH_LIST_SEPARATOR));
+        exit(0);
     }
-    if (list) exit(0);
-    //////////////////////////////////////////////////////////////////////////////////////////
 
-    ///////////////////////////////////////////////
-    // Check for a restart point
-    bool doRestart = false;
-    std::string restartPoint = "";
-    if (argc == 3) {
-        doRestart = true;
-        restartPoint = std::string(argv[2]);
+    ///////////////////////////////////////////////////////////////////////////////////////////////
+    // With --submit a running daemon does the work, so nothing is loaded here.
+    if (flags.count("submit") && args[0] != "plugins" && args[0] != "daemon") {
+        std::string socket = flags["socket"].empty() ? Daemon::defaultSocket() : flags["socket"];
+        Submission submission;
+        submission.cwd = pluma::platform::getCurrentDirectory();
+        submission.args = args;
+        submission.flags = flags;
+        submission.flags.erase("submit");
+        submission.flags.erase("socket");
+        int code = submitToDaemon(socket, submission, std::cout);
+        if (code < 0) {
+            std::cout << "[PluMA] Error: no daemon is listening on " << socket << " (start one with ./pluma daemon)" << std::endl;
+            exit(1);
+        }
+        exit(code);
     }
-    //////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////////////////////////////////////
 
-    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-    // Get the current time, and setup the initial log file
-    time_t t = time(0);
-    struct tm* now = localtime( &t );
-    std::string currentTime = toString(now->tm_year + 1900) + "-" + toString(now->tm_mon + 1) + "-" + toString(now->tm_mday) + "@" + toString(now->tm_hour) + ":" + toString(now->tm_min) + ":" + toString(now->tm_sec);
-    std::string mylog = "logs/"+currentTime+".log.txt";
-    PluginManager::getInstance().setLogFile(mylog);
+    PluginManager::supportedLanguages(pluginpath, argc, argv);
+    //////////////////////////////////////////////////////////////////////////////////////////
+    // For each PluginManager::supported language, load the appropriate plugins
+    loadPlugins(pluginpath, args[0] == "plugins");
+    if (args[0] == "plugins") exit(0);
+    //////////////////////////////////////////////////////////////////////////////////////////
 
-    /////////////////////////////////////////////////////////////////////
-    // Read configuration file and make appropriate plugins
-    readConfig(std::string(argv[1]), "", doRestart, restartPoint);
-    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    if (args[0] == "daemon") {
+        Daemon daemon(flags["socket"].empty() ? Daemon::defaultSocket() : flags["socket"]);
+        std::map<std::string, double> weights;
+        std::string error;
+        if (!parallel::parse_weights(flags["weights"], weights, error)) {
+            std::cout << "[PluMA] Error: " << error << std::endl;
+            exit(1);
+        }
+        parallel::ParallelBlockOptions budget = parallel::resolve_defaults(budgetOptions(flags));
+        daemon.setBudget(budget, weights);
+        if (!daemon.listen(flags.count("shared") > 0)) {
+            std::cout << "[PluMA] Error: " << daemon.error() << std::endl;
+            exit(1);
+        }
+        std::cout << "[PluMA] Daemon listening on " << daemon.socketPath() << " (" << budget.workers << " workers, "
+                  << parallel::format_bytes(budget.memory) << ", " << budget.gpu << " GPUs shared by every run)" << std::endl;
+        leaseSocket = daemon.socketPath();
+        // Started once for every run the daemon forks
+        PluginManager::startLanguages(PluginManager::getInstance().languages());
+        daemon.serve(runSubmission);
+    }
+    else {
+        runConfig(args, flags);
+    }
 
     /////////////////////////////////////////////////////////////////////
     // Cleanup.
-    for (size_t i = 0; i < PluginManager::supported.size(); i++)
+    for (size_t i = 0; i < PluginManager::supported.size(); i++) {
+        PluginManager::awaitLanguage(PluginManager::supported[i]->lang());
         PluginManager::supported[i]->unload();
+    }
     /////////////////////////////////////////////////////////////////////
 
     /////////////////////////////////////////////////////////////////////
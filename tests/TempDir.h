@@ -0,0 +1,43 @@
+#ifndef PLUMA_TESTS_TEMP_DIR_H
+#define PLUMA_TESTS_TEMP_DIR_H
+
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Scratch directory for a test, $TMPDIR/pluma_<prefix>_<pid>: emptied when
+// created and removed at scope exit. The pid keeps concurrent test
+// processes apart; the prefix, the tests of one process.
+struct TempDir {
+    std::filesystem::path path;
+
+    explicit TempDir(const std::string& prefix) {
+        path = std::filesystem::temp_directory_path() / ("pluma_" + prefix + "_" + std::to_string(getpid()));
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+    }
+    ~TempDir() { std::filesystem::remove_all(path); }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    std::string file(const std::string& name) const { return (path / name).string(); }
+
+    // Writes name, creating the directories above it; returns its path.
+    std::string write(const std::string& name, const std::string& contents = "data") const {
+        std::filesystem::create_directories((path / name).parent_path());
+        std::ofstream(path / name, std::ios::binary) << contents;
+        return file(name);
+    }
+
+    std::string read(const std::string& name) const {
+        std::ifstream in(path / name, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+};
+
+#endif
@@ -0,0 +1,20 @@
+// Test plugin: copies its input file to its output file.
+#include "Plugin.h"
+#include "PluginProxy.h"
+
+#include <fstream>
+
+class CopyPlugin : public Plugin {
+public:
+    void input(std::string file) {myInput = file;}
+    void output(std::string file) {
+        std::ifstream in(myInput, std::ios::binary);
+        std::ofstream out(file, std::ios::binary);
+        out << in.rdbuf();
+    }
+
+private:
+    std::string myInput;
+};
+
+PluginProxy<CopyPlugin> CopyPluginProxy = PluginProxy<CopyPlugin>("Copy", PluginManager::getInstance());
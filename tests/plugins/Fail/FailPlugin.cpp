@@ -0,0 +1,12 @@
+// Test plugin: fails in run().
+#include "Plugin.h"
+#include "PluginProxy.h"
+
+#include <stdexcept>
+
+class FailPlugin : public Plugin {
+public:
+    void run() {throw std::runtime_error("Fail always fails");}
+};
+
+PluginProxy<FailPlugin> FailPluginProxy = PluginProxy<FailPlugin>("Fail", PluginManager::getInstance());
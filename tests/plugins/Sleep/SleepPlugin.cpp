@@ -0,0 +1,12 @@
+// Test plugin: runs for a minute, so that a test can stop it.
+#include "Plugin.h"
+#include "PluginProxy.h"
+
+#include <unistd.h>
+
+class SleepPlugin : public Plugin {
+public:
+    void run() {sleep(60);}
+};
+
+PluginProxy<SleepPlugin> SleepPluginProxy = PluginProxy<SleepPlugin>("Sleep", PluginManager::getInstance());
@@ -0,0 +1,117 @@
+'''Stand-in for the SWIG module PyPluMAEngine (src/EngineWrapper.i), for
+testing PyPipeline.py where _PyPluMAEngine is not built.
+
+It has the names PyPipeline uses, and they behave as the native ones do
+for what it relies on: parse_plugin_task reads a Plugin line's paths and
+hints as ConfigParser does, build_task_graph orders tasks by the files
+they share, and Engine.run records the graph and options it is given
+rather than running anything.
+'''
+
+class IndexVector(list):
+    pass
+
+class DependencyVector(list):
+    pass
+
+class TaskVector(list):
+    pass
+
+class PluginTask(object):
+    def __init__(self):
+        self.name = ''
+        self.inputfile = ''
+        self.outputfile = ''
+        self.memory_hint = 0
+        self.gpu_hint = 0
+        self.prefix = ''
+        self.cacheable = True
+        self.expected_seconds = 0.0
+        self.intermediate = False
+
+class TaskGraph(object):
+    def __init__(self):
+        self.tasks = TaskVector()
+        self.dependencies = DependencyVector()
+
+class SchedulerResult(object):
+    def __init__(self):
+        self.completed = []
+        self.failed = []
+        self.skipped = []
+
+_SIZES = {'K': 1 << 10, 'M': 1 << 20, 'G': 1 << 30, 'T': 1 << 40}
+_SECONDS = {'s': 1, 'm': 60, 'h': 3600, 'd': 86400}
+
+def _size(value):
+    if value[-1:].upper() in _SIZES:
+        return int(value[:-1]) * _SIZES[value[-1].upper()]
+    return int(value)
+
+def _duration(value):
+    if value[-1:].lower() in _SECONDS:
+        return float(value[:-1]) * _SECONDS[value[-1].lower()]
+    return float(value)
+
+def parse_plugin_task(line, prefix):
+    task = PluginTask()
+    tokens = line.split()
+    if len(tokens) < 6:
+        return task
+    task.name = tokens[1]
+    task.prefix = prefix
+    paths = {}
+    for i in range(2, len(tokens) - 1):
+        if tokens[i] in ('inputfile', 'outputfile'):
+            paths[tokens[i]] = tokens[i + 1]
+    for key in ('inputfile', 'outputfile'):
+        path = paths.get(key, '')
+        setattr(task, key, path if path[:1] in ('/', '\\') else prefix + path)
+    for token in tokens[2:]:
+        key, eq, value = token.partition('=')
+        if not eq:
+            continue
+        try:
+            if key == 'memory':
+                task.memory_hint = _size(value)
+            elif key == 'gpu':
+                task.gpu_hint = int(value)
+            elif key == 'cache':
+                task.cacheable = value not in ('no', 'off', 'false')
+            elif key == 'time':
+                task.expected_seconds = _duration(value)
+            elif key == 'intermediate':
+                task.intermediate = value in ('yes', 'on', 'true')
+        except ValueError:
+            pass
+    return task
+
+def _overlaps(a, b):
+    '''Whether one path is the other or a directory above it'''
+    if not a or not b:
+        return False
+    a, b = a.rstrip('/'), b.rstrip('/')
+    return a == b or a.startswith(b + '/') or b.startswith(a + '/')
+
+def build_task_graph(tasks):
+    '''Each task waits for every earlier task that writes what it reads,
+    reads what it writes or writes where it does. The native graph keeps
+    fewer of these edges, but orders the tasks the same.'''
+    graph = TaskGraph()
+    graph.tasks = TaskVector(tasks)
+    for i, task in enumerate(tasks):
+        graph.dependencies.append(IndexVector(
+            j for j in range(i)
+            if _overlaps(task.inputfile, tasks[j].outputfile) or
+               _overlaps(task.outputfile, tasks[j].inputfile) or
+               _overlaps(task.outputfile, tasks[j].outputfile)))
+    return graph
+
+class Engine(object):
+    def __init__(self, pluginpath=''):
+        self.pluginpath = pluginpath
+        self.runs = []
+
+    def run(self, graph, options):
+        self.runs.append((graph, options))
+        return SchedulerResult()
@@ -0,0 +1,118 @@
+'''Tests of PyPipeline.py, against the PyPluMAEngine that scons builds into
+the repository root when it has been built, else against the stand-in
+beside this file.'''
+import os
+import sys
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.dirname(os.path.dirname(HERE)))
+try:
+    import PyPluMAEngine
+except ImportError:
+    sys.path.insert(1, HERE)
+    sys.modules.pop('PyPluMAEngine', None)
+    import PyPluMAEngine
+
+import PyPipeline
+from PyPipeline import Pipeline
+
+def dependencies(pipeline):
+    graph = pipeline.graph()
+    return [sorted(graph.dependencies[i]) for i in range(len(graph.tasks))]
+
+class RecordingEngine(object):
+    def __init__(self):
+        self.runs = []
+
+    def run(self, graph, options):
+        self.runs.append((graph, options))
+        return None
+
+class PipelineTest(unittest.TestCase):
+    def test_steps_wait_for_the_one_before(self):
+        pipeline = Pipeline()
+        pipeline.step('Trim', 'reads.fq', 'trimmed.fq')
+        pipeline.step('Align', 'align.params', 'aligned.bam')
+        pipeline.step('Stats', 'aligned.bam', 'stats.txt')
+        self.assertEqual(dependencies(pipeline), [[], [0], [1]])
+
+    def test_parallel_steps_wait_for_the_stage_before_not_each_other(self):
+        pipeline = Pipeline()
+        pipeline.step('Trim', 'reads.fq', 'trimmed.fq')
+        with pipeline.parallel():
+            pipeline.step('Stats', 'trimmed.fq', 'stats.txt')
+            pipeline.step('Plot', 'plot.params', 'plot.png')
+        pipeline.step('Report', 'report.params', 'report.html')
+        self.assertEqual(dependencies(pipeline), [[], [0], [0], [1, 2]])
+
+    def test_after_adds_steps_and_blocks(self):
+        pipeline = Pipeline()
+        trim = pipeline.step('Trim', 'reads.fq', 'trimmed.fq')
+        with pipeline.parallel() as block:
+            pipeline.step('Stats', 'trimmed.fq', 'stats.txt')
+            pipeline.step('Plot', 'plot.params', 'plot.png', after=trim)
+        pipeline.step('Index', 'index.params', 'index.txt')
+        pipeline.step('Report', 'report.params', 'report.html', after=[block, trim])
+        self.assertEqual(dependencies(pipeline), [[], [0], [0], [1, 2], [0, 1, 2, 3]])
+
+    def test_dag_orders_steps_by_their_files(self):
+        pipeline = Pipeline(dag=True)
+        trim = pipeline.step('Trim', 'reads.fq', 'trimmed.fq')
+        pipeline.step('Align', 'trimmed.fq', 'aligned.bam')
+        pipeline.step('Plot', 'plot.params', 'plot.png')
+        pipeline.step('Report', 'report.params', 'report.html', after=trim)
+        self.assertEqual(dependencies(pipeline), [[], [0], [], [0]])
+
+    def test_prefix_and_hints_are_those_of_a_plugin_line(self):
+        pipeline = Pipeline(prefix='data')
+        step = pipeline.step('Align', 'trimmed.fq', '/scratch/aligned.bam',
+                             memory='4G', gpu=1, time='30m', cache=False, intermediate=True)
+        self.assertEqual(step.task.name, 'Align')
+        self.assertEqual(step.task.inputfile, 'data/trimmed.fq')
+        self.assertEqual(step.task.outputfile, '/scratch/aligned.bam')
+        self.assertEqual(step.task.memory_hint, 4 << 30)
+        self.assertEqual(step.task.gpu_hint, 1)
+        self.assertEqual(step.task.expected_seconds, 1800.0)
+        self.assertFalse(step.task.cacheable)
+        self.assertTrue(step.task.intermediate)
+        self.assertEqual(repr(step), 'Step(0, Align)')
+
+    def test_parallel_blocks_do_not_nest(self):
+        pipeline = Pipeline()
+        with pipeline.parallel():
+            with self.assertRaisesRegex(ValueError, 'do not nest'):
+                with pipeline.parallel():
+                    pass
+        pipeline.step('Trim', 'reads.fq', 'trimmed.fq')
+        self.assertEqual(len(pipeline._stages), 2)
+
+    def test_after_rejects_a_step_of_another_pipeline(self):
+        other = Pipeline().step('Trim', 'reads.fq', 'trimmed.fq')
+        with self.assertRaisesRegex(ValueError, 'another pipeline'):
+            Pipeline().step('Align', 'trimmed.fq', 'aligned.bam', after=other)
+
+    def test_spaces_are_rejected(self):
+        pipeline = Pipeline()
+        with self.assertRaisesRegex(ValueError, 'cannot contain spaces'):
+            pipeline.step('Trim', 'my reads.fq', 'trimmed.fq')
+        with self.assertRaisesRegex(ValueError, 'cannot contain spaces'):
+            pipeline.step('Trim', 'reads.fq', 'trimmed.fq', memory='4 G')
+        self.assertEqual(pipeline.steps, [])
+
+    def test_run_passes_the_graph_and_merged_options(self):
+        recording = RecordingEngine()
+        saved, PyPipeline._engine = PyPipeline._engine, recording
+        try:
+            pipeline = Pipeline(workers=4, memory='16G', backfill=True)
+            pipeline.step('Trim', 'reads.fq', 'trimmed.fq')
+            pipeline.step('Align', 'trimmed.fq', 'aligned.bam')
+            pipeline.run(backfill=False, fail='continue')
+        finally:
+            PyPipeline._engine = saved
+        graph, options = recording.runs[0]
+        self.assertEqual([graph.tasks[i].name for i in range(len(graph.tasks))], ['Trim', 'Align'])
+        self.assertEqual(options, {'workers': '4', 'memory': '16G', 'backfill': 'no', 'fail': 'continue'})
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,219 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "CacheStore.h"
+#include "PluginCache.h"
+#include "TempDir.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace parallel;
+
+namespace fs = std::filesystem;
+
+// Stand-in cache server on 127.0.0.1: keeps PUT bodies in memory and serves
+// them back on GET, one HTTP/1.0 request per connection.
+class StandInServer {
+public:
+    StandInServer() {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+        listen(fd_, 8);
+        socklen_t len = sizeof(addr);
+        getsockname(fd_, reinterpret_cast<struct sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread([this] { serve(); });
+    }
+    ~StandInServer() {
+        stop_ = true;
+        shutdown(fd_, SHUT_RDWR);
+        close(fd_);
+        thread_.join();
+    }
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port_) + "/cache"; }
+    size_t puts() const { return puts_; }
+    size_t objects() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return objects_.size();
+    }
+
+private:
+    void serve() {
+        while (!stop_) {
+            int conn = accept(fd_, nullptr, nullptr);
+            if (conn < 0) continue;
+            handle(conn);
+            close(conn);
+        }
+    }
+
+    void handle(int conn) {
+        std::string raw;
+        char buf[4096];
+        size_t header_end;
+        while ((header_end = raw.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = recv(conn, buf, sizeof(buf), 0);
+            if (n <= 0) return;
+            raw.append(buf, static_cast<size_t>(n));
+        }
+        std::istringstream request_line(raw.substr(0, raw.find("\r\n")));
+        std::string method, path;
+        request_line >> method >> path;
+
+        size_t length = 0;
+        size_t cl = raw.find("Content-Length: ");
+        if (cl != std::string::npos && cl < header_end) length = std::stoul(raw.substr(cl + 16));
+        std::string body = raw.substr(header_end + 4);
+        while (body.size() < length) {
+            ssize_t n = recv(conn, buf, sizeof(buf), 0);
+            if (n <= 0) return;
+            body.append(buf, static_cast<size_t>(n));
+        }
+
+        std::string status = "404 Not Found", payload;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (method == "PUT") {
+                objects_[path] = body;
+                puts_++;
+                status = "201 Created";
+            } else if (method == "GET" && objects_.count(path)) {
+                status = "200 OK";
+                payload = objects_[path];
+            }
+        }
+        std::string response = "HTTP/1.0 " + status + "\r\nContent-Length: " +
+                                std::to_string(payload.size()) + "\r\n\r\n" + payload;
+        send(conn, response.data(), response.size(), MSG_NOSIGNAL);
+    }
+
+    int fd_;
+    int port_ = 0;
+    std::atomic<bool> stop_{false};
+    std::atomic<size_t> puts_{0};
+    std::mutex mutex_;
+    std::map<std::string, std::string> objects_;
+    std::thread thread_;
+};
+
+static const std::string KEY = "ab0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcd";
+
+// ---------------------------------------------------------------------------
+// Entry serialization
+// ---------------------------------------------------------------------------
+
+TEST_CASE("pack_entry/unpack_entry: round trip with nested files", "[cache][store]") {
+    TempDir tmp("store_pack");
+    tmp.write("src/out.csv", "a,b\n1,2\n");
+    tmp.write("src/out.d/part-0", std::string("\0bin\n", 5));
+
+    std::string packed = pack_entry((tmp.path / "src").string());
+    REQUIRE(unpack_entry(packed, (tmp.path / "dst").string()));
+    REQUIRE(tmp.read("dst/out.csv") == "a,b\n1,2\n");
+    REQUIRE(tmp.read("dst/out.d/part-0") == std::string("\0bin\n", 5));
+}
+
+TEST_CASE("unpack_entry: rejects malformed data and escaping paths", "[cache][store]") {
+    TempDir tmp("store_unpack");
+    std::string dst = (tmp.path / "dst").string();
+    REQUIRE_FALSE(unpack_entry("not an entry", dst));
+    REQUIRE_FALSE(unpack_entry("pluma-entry-v1\n3 ../evil\nabc", dst));
+    REQUIRE_FALSE(unpack_entry("pluma-entry-v1\n3 /evil\nabc", dst));
+    REQUIRE_FALSE(unpack_entry("pluma-entry-v1\n99 short\nabc", dst));
+    REQUIRE_FALSE(fs::exists(tmp.path / "evil"));
+}
+
+// ---------------------------------------------------------------------------
+// DirectoryStore
+// ---------------------------------------------------------------------------
+
+TEST_CASE("DirectoryStore: publish then fetch", "[cache][store]") {
+    TempDir tmp("store_dir");
+    DirectoryStore store((tmp.path / "shared").string());
+    tmp.write("entry/out.csv", "result");
+
+    REQUIRE_FALSE(store.fetch(KEY, (tmp.path / "miss").string()));
+    REQUIRE(store.publish(KEY, (tmp.path / "entry").string()));
+    REQUIRE(store.contains(KEY));
+    REQUIRE(store.fetch(KEY, (tmp.path / "got").string()));
+    REQUIRE(tmp.read("got/out.csv") == "result");
+}
+
+TEST_CASE("DirectoryStore: losing a publish race keeps the first entry", "[cache][store]") {
+    TempDir tmp("store_race");
+    DirectoryStore store((tmp.path / "shared").string());
+
+    std::string first = store.make_staging();
+    std::string second = store.make_staging();
+    REQUIRE(first != second);
+    std::ofstream(fs::path(first) / "out.csv") << "first";
+    std::ofstream(fs::path(second) / "out.csv") << "second";
+
+    REQUIRE(store.commit(KEY, first));
+    REQUIRE(store.commit(KEY, second));
+    REQUIRE_FALSE(fs::exists(second));
+    REQUIRE(tmp.read("shared/ab/" + KEY + "/out.csv") == "first");
+}
+
+// ---------------------------------------------------------------------------
+// HttpStore
+// ---------------------------------------------------------------------------
+
+TEST_CASE("HttpStore: publish then fetch against a stand-in server", "[cache][store][http]") {
+    TempDir tmp("store_http");
+    StandInServer server;
+    HttpStore store(server.url(), 5);
+    tmp.write("entry/out.csv", "result");
+
+    REQUIRE_FALSE(store.fetch(KEY, (tmp.path / "miss").string()));
+    REQUIRE(store.publish(KEY, (tmp.path / "entry").string()));
+    REQUIRE(server.objects() == 1);
+    REQUIRE(store.fetch(KEY, (tmp.path / "got").string()));
+    REQUIRE(tmp.read("got/out.csv") == "result");
+}
+
+TEST_CASE("HttpStore: unreachable server is a miss", "[cache][store][http]") {
+    TempDir tmp("store_down");
+    HttpStore store("http://127.0.0.1:1/cache", 1);
+    tmp.write("entry/out.csv", "result");
+    REQUIRE_FALSE(store.fetch(KEY, (tmp.path / "got").string()));
+    REQUIRE_FALSE(store.publish(KEY, (tmp.path / "entry").string()));
+}
+
+// ---------------------------------------------------------------------------
+// PluginCache with a remote store
+// ---------------------------------------------------------------------------
+
+TEST_CASE("PluginCache: entries computed on one host are reused by another", "[cache][store][http]") {
+    TempDir tmp("store_hosts");
+    StandInServer server;
+    std::string out = (tmp.path / "run" / "out.csv").string();
+
+    PluginCache producer((tmp.path / "host1").string());
+    producer.add_remote(std::unique_ptr<CacheStore>(new HttpStore(server.url(), 5)));
+    auto start = PluginCache::Clock::now();
+    tmp.write("run/out.csv", "computed once");
+    REQUIRE(producer.store(KEY, out, start));
+    REQUIRE(server.puts() == 1);
+
+    fs::remove_all(tmp.path / "run");
+    PluginCache consumer((tmp.path / "host2").string());
+    consumer.add_remote(std::unique_ptr<CacheStore>(new HttpStore(server.url(), 5)));
+    REQUIRE_FALSE(consumer.contains(KEY));
+    REQUIRE(consumer.restore(KEY, out));
+    REQUIRE(tmp.read("run/out.csv") == "computed once");
+    REQUIRE(consumer.contains(KEY));
+}
@@ -45,6 +45,22 @@ TEST_CASE("parse_size: invalid input throws", "[config][size]") {
     REQUIRE_THROWS(parse_size("-1G"));
 }
 
+TEST_CASE("parse_duration: seconds, minutes, hours and days", "[config][duration]") {
+    REQUIRE(parse_duration("90")   == 90.0);
+    REQUIRE(parse_duration("90s")  == 90.0);
+    REQUIRE(parse_duration("45m")  == 2700.0);
+    REQUIRE(parse_duration("3H")   == 10800.0);
+    REQUIRE(parse_duration("1.5d") == 129600.0);
+}
+
+TEST_CASE("parse_duration: invalid input throws", "[config][duration]") {
+    REQUIRE_THROWS(parse_duration(""));
+    REQUIRE_THROWS(parse_duration("h"));
+    REQUIRE_THROWS(parse_duration("3x"));
+    REQUIRE_THROWS(parse_duration("-1h"));
+    REQUIRE_THROWS(parse_duration("1h30m"));
+}
+
 // ---------------------------------------------------------------------------
 // parse_parallel_options
 // ---------------------------------------------------------------------------
@@ -84,6 +100,12 @@ TEST_CASE("parse_parallel_options: options in any order", "[config][options]") {
     REQUIRE(opts.gpu     == 1);
 }
 
+TEST_CASE("parse_parallel_options: dispatch order", "[config][options]") {
+    REQUIRE(parse_parallel_options("Parallel").order == DispatchOrder::Longest);
+    REQUIRE(parse_parallel_options("Parallel order=config").order == DispatchOrder::Config);
+    REQUIRE(parse_parallel_options("Parallel order=longest").order == DispatchOrder::Longest);
+}
+
 TEST_CASE("parse_parallel_options: unknown option is ignored", "[config][options]") {
     auto opts = parse_parallel_options("Parallel workers=2 color=blue");
     REQUIRE(opts.workers == 2);
@@ -125,6 +147,12 @@ TEST_CASE("parse_plugin_task: with memory and gpu hints", "[config][task]") {
     REQUIRE(task.gpu_hint    == 1);
 }
 
+TEST_CASE("parse_plugin_task: with a time hint", "[config][task]") {
+    auto task = parse_plugin_task("Plugin Assemble inputfile reads.fq outputfile contigs.fa time=3h", "");
+    REQUIRE(task.expected_seconds == 10800.0);
+    REQUIRE(parse_plugin_task("Plugin Quick inputfile a outputfile b", "").expected_seconds == 0.0);
+}
+
 TEST_CASE("parse_plugin_task: absolute paths bypass prefix", "[config][task]") {
     auto task = parse_plugin_task(
         "Plugin Abs inputfile /data/input.csv outputfile /data/output.csv",
@@ -143,6 +171,26 @@ TEST_CASE("parse_plugin_task: empty prefix on relative paths", "[config][task]")
     REQUIRE(task.outputfile == "out.csv");
 }
 
+TEST_CASE("parse_plugin_task: cache=no opts out of memoization", "[config][task]") {
+    REQUIRE(parse_plugin_task("Plugin Foo inputfile in.csv outputfile out.csv", "").cacheable);
+    REQUIRE_FALSE(parse_plugin_task("Plugin Foo inputfile in.csv outputfile out.csv cache=no", "").cacheable);
+}
+
+TEST_CASE("parse_plugin_task: intermediate=yes marks the output collectable", "[config][task]") {
+    REQUIRE_FALSE(parse_plugin_task("Plugin Foo inputfile in.csv outputfile out.csv", "").intermediate);
+    REQUIRE(parse_plugin_task("Plugin Foo inputfile in.csv outputfile out.csv intermediate=yes", "").intermediate);
+}
+
+TEST_CASE("parse_kitty_task: Pipeline line becomes a task named after the Kitty", "[config][task]") {
+    auto task = parse_kitty_task("Pipeline samples/sub.txt memory=2G", "s1", "run//s1/");
+
+    REQUIRE(task.name        == "s1");
+    REQUIRE(task.inputfile   == "samples/sub.txt");
+    REQUIRE(task.prefix      == "run//s1/");
+    REQUIRE(task.memory_hint == 2ULL * 1024 * 1024 * 1024);
+    REQUIRE(task.outputfile.empty());
+}
+
 // ---------------------------------------------------------------------------
 // parse_config: structural tests
 // ---------------------------------------------------------------------------
@@ -322,6 +370,34 @@ TEST_CASE("parse_config: Prefix before parallel block sets plugin paths", "[conf
     }
 }
 
+TEST_CASE("parse_config: inherited prefix applies to parallel tasks", "[config][parse]") {
+    std::istringstream input(
+        "Parallel\n"
+        "  Plugin A inputfile in.csv outputfile out.csv\n"
+        "EndParallel\n"
+    );
+    auto result = parse_config(input, "outer/");
+    REQUIRE(result.errors.empty());
+    REQUIRE(result.steps.size() == 1);
+    REQUIRE(result.steps[0].parallel.tasks[0].inputfile  == "outer/in.csv");
+    REQUIRE(result.steps[0].parallel.tasks[0].outputfile == "outer/out.csv");
+}
+
+TEST_CASE("parse_config: Kitty extends the last Prefix for later parallel tasks", "[config][parse]") {
+    std::istringstream input(
+        "Prefix run\n"
+        "Kitty s1\n"
+        "Kitty s2\n"
+        "Parallel\n"
+        "  Plugin A inputfile in.csv outputfile out.csv\n"
+        "EndParallel\n"
+    );
+    auto result = parse_config(input);
+    REQUIRE(result.errors.empty());
+    REQUIRE(result.steps.back().kind == ConfigStepKind::Parallel);
+    REQUIRE(result.steps.back().parallel.tasks[0].inputfile == "run//s2/in.csv");
+}
+
 // ---------------------------------------------------------------------------
 // parse_config: error cases
 // ---------------------------------------------------------------------------
@@ -395,6 +471,93 @@ TEST_CASE("parse_config: Pipeline inside Parallel is a parse error", "[config][e
     REQUIRE_THAT(result.errors[0].message, ContainsSubstring("Pipeline"));
 }
 
+TEST_CASE("parse_config: Sweep block keeps its Plugin line and options", "[config][parse][sweep]") {
+    std::istringstream input(
+        "Prefix data\n"
+        "Sweep samples=samples.txt workers=8 fail=continue\n"
+        "  Plugin Align inputfile {sample}/reads.fq outputfile {sample}/aligned.bam memory=4G\n"
+        "EndSweep\n"
+    );
+    auto result = parse_config(input);
+    REQUIRE(result.errors.empty());
+    REQUIRE(result.steps.size() == 2);
+    REQUIRE(result.steps[1].kind == ConfigStepKind::Sweep);
+    const SweepBlock& sweep = result.steps[1].sweep;
+    REQUIRE(sweep.samples == "data/samples.txt");
+    REQUIRE(sweep.pattern.empty());
+    REQUIRE(sweep.prefix == "data/");
+    REQUIRE(sweep.options.workers == 8);
+    REQUIRE(sweep.options.fail_mode == FailMode::Continue);
+    REQUIRE_THAT(sweep.plugin_line, ContainsSubstring("{sample}/reads.fq"));
+    REQUIRE(sweep.source_line == 2);
+    REQUIRE(sweep.plugin_source_line == 3);
+}
+
+TEST_CASE("parse_config: malformed Sweep blocks are parse errors", "[config][error][sweep]") {
+    auto first_error = [](const std::string& text) {
+        std::istringstream input(text);
+        auto result = parse_config(input);
+        return result.errors.empty() ? std::string() : result.errors[0].message;
+    };
+
+    REQUIRE_THAT(first_error("Sweep workers=2\nPlugin A inputfile {sample} outputfile o\nEndSweep\n"),
+                 ContainsSubstring("samples=FILE or glob=PATTERN"));
+    REQUIRE_THAT(first_error("Sweep samples=s.txt\nPlugin A inputfile a outputfile o\nEndSweep\n"),
+                 ContainsSubstring("neither {sample} nor {path}"));
+    REQUIRE_THAT(first_error("Sweep samples=s.txt\nPlugin A inputfile {sample} outputfile o\n"
+                             "Plugin B inputfile {sample} outputfile p\nEndSweep\n"),
+                 ContainsSubstring("only one Plugin"));
+    REQUIRE_THAT(first_error("Sweep glob=*.fq\nPrefix x\nEndSweep\n"), ContainsSubstring("Prefix"));
+    REQUIRE_THAT(first_error("Sweep glob=*.fq\nEndSweep\n"), ContainsSubstring("no Plugin"));
+    REQUIRE_THAT(first_error("Sweep glob=*.fq\nPlugin A inputfile {path} outputfile o\n"), ContainsSubstring("EndSweep"));
+    REQUIRE_THAT(first_error("EndSweep\n"), ContainsSubstring("EndSweep without"));
+    REQUIRE_THAT(first_error("Parallel\nSweep glob=*.fq\nEndParallel\n"), ContainsSubstring("Sweep"));
+}
+
+TEST_CASE("parse_config: Scatter block keeps its Plugin line and options", "[config][parse][scatter]") {
+    std::istringstream input(
+        "Prefix data\n"
+        "Scatter shards=16 by=records record=4 header=1 workers=8 gather=Merge\n"
+        "  Plugin Filter inputfile reads.fq outputfile filtered.fq\n"
+        "EndScatter\n"
+    );
+    auto result = parse_config(input);
+    REQUIRE(result.errors.empty());
+    REQUIRE(result.steps.size() == 2);
+    REQUIRE(result.steps[1].kind == ConfigStepKind::Scatter);
+    const ScatterBlock& scatter = result.steps[1].scatter;
+    REQUIRE(scatter.shards == 16);
+    REQUIRE(scatter.unit == ShardUnit::Records);
+    REQUIRE(scatter.record_lines == 4);
+    REQUIRE(scatter.header_lines == 1);
+    REQUIRE(scatter.gather == "Merge");
+    REQUIRE(scatter.options.workers == 8);
+    REQUIRE(scatter.prefix == "data/");
+    REQUIRE_THAT(scatter.plugin_line, ContainsSubstring("Plugin Filter"));
+    REQUIRE(scatter.source_line == 2);
+    REQUIRE(scatter.plugin_source_line == 3);
+}
+
+TEST_CASE("parse_config: malformed Scatter blocks are parse errors", "[config][error][scatter]") {
+    auto first_error = [](const std::string& text) {
+        std::istringstream input(text);
+        auto result = parse_config(input);
+        return result.errors.empty() ? std::string() : result.errors[0].message;
+    };
+    const std::string plugin = "Plugin A inputfile a outputfile o\n";
+
+    REQUIRE_THAT(first_error("Scatter\n" + plugin + "EndScatter\n"), ContainsSubstring("shards=N"));
+    REQUIRE_THAT(first_error("Scatter shards=2 by=words\n" + plugin + "EndScatter\n"), ContainsSubstring("by="));
+    REQUIRE_THAT(first_error("Scatter shards=two\n" + plugin + "EndScatter\n"), ContainsSubstring("shards=two"));
+    REQUIRE_THAT(first_error("Scatter shards=2 by=bytes header=1\n" + plugin + "EndScatter\n"), ContainsSubstring("header="));
+    REQUIRE_THAT(first_error("Scatter shards=2\n" + plugin + plugin + "EndScatter\n"), ContainsSubstring("only one Plugin"));
+    REQUIRE_THAT(first_error("Scatter shards=2\nPrefix x\nEndScatter\n"), ContainsSubstring("Prefix"));
+    REQUIRE_THAT(first_error("Scatter shards=2\nEndScatter\n"), ContainsSubstring("no Plugin"));
+    REQUIRE_THAT(first_error("Scatter shards=2\n" + plugin), ContainsSubstring("EndScatter"));
+    REQUIRE_THAT(first_error("EndScatter\n"), ContainsSubstring("EndScatter without"));
+    REQUIRE_THAT(first_error("Parallel\nScatter shards=2\nEndParallel\n"), ContainsSubstring("Scatter"));
+}
+
 // ---------------------------------------------------------------------------
 // validate_parallel_block: dependency / conflict detection
 // ---------------------------------------------------------------------------
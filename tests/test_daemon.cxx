@@ -0,0 +1,234 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include "Daemon.h"
+
+#include <pwd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+using Catch::Matchers::ContainsSubstring;
+
+static const pid_t test_pid = getpid();
+
+static std::string test_socket() {
+    return "/tmp/pluma_test_" + std::to_string(test_pid) + ".sock";
+}
+
+// Runs a daemon in a child process for the lifetime of the object.
+struct DaemonProcess {
+    pid_t pid = -1;
+    explicit DaemonProcess(Daemon::Runner run, int workers = 0) {
+        pid = fork();
+        if (pid == 0) {
+            Daemon daemon(test_socket());
+            if (workers > 0) {
+                parallel::ParallelBlockOptions budget;
+                budget.workers = workers;
+                budget.memory = 1ULL << 30;
+                daemon.setBudget(budget, {});
+            }
+            if (!daemon.listen()) _exit(2);
+            daemon.serve(run);
+            _exit(0);
+        }
+        // Wait for the socket to accept connections.
+        for (int i = 0; i < 200 && access(test_socket().c_str(), F_OK) != 0; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    int stop() {
+        kill(pid, SIGTERM);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        pid = -1;
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+    ~DaemonProcess() { if (pid > 0) stop(); }
+};
+
+static Submission make_submission(const std::string& config) {
+    Submission s;
+    s.cwd = "/tmp";
+    s.args.push_back(config);
+    return s;
+}
+
+TEST_CASE("Submission: survives encoding, including tabs and newlines", "[daemon]") {
+    Submission s = make_submission("conf ig.txt");
+    s.args.push_back("Restart\tPoint");
+    s.flags["cache"] = "";
+    s.flags["journal"] = "a\\b\nc";
+
+    Submission back;
+    REQUIRE(decodeSubmission(encodeSubmission(s), back));
+    REQUIRE(back.cwd == s.cwd);
+    REQUIRE(back.args == s.args);
+    REQUIRE(back.flags == s.flags);
+
+    REQUIRE_FALSE(decodeSubmission("cwd\t/tmp\n", back));          // no end line
+    REQUIRE_FALSE(decodeSubmission("bogus line\nend\n", back));
+}
+
+TEST_CASE("Daemon: streams a run's output and exit status", "[daemon]") {
+    DaemonProcess daemon([](const Submission& s) {
+        std::cout << "[PluMA] Running Plugin: " << s.args[0] << std::endl;
+        char cwd[4096];
+        std::cout << "[PluMA] In " << getcwd(cwd, sizeof(cwd)) << std::endl;
+        return s.args[0] == "bad.txt" ? 3 : 0;
+    });
+
+    std::ostringstream out;
+    REQUIRE(submitToDaemon(test_socket(), make_submission("good.txt"), out) == 0);
+    REQUIRE_THAT(out.str(), ContainsSubstring("[PluMA] Running Plugin: good.txt"));
+    REQUIRE_THAT(out.str(), ContainsSubstring("[PluMA] In /tmp"));
+    REQUIRE_THAT(out.str(), !ContainsSubstring("Exit:"));
+
+    std::ostringstream bad;
+    REQUIRE(submitToDaemon(test_socket(), make_submission("bad.txt"), bad) == 3);
+
+    REQUIRE(daemon.stop() == 0);
+    REQUIRE(access(test_socket().c_str(), F_OK) != 0);
+}
+
+TEST_CASE("Daemon: runs in separate processes, concurrently", "[daemon][timing]") {
+    static int counter = 0;
+    DaemonProcess daemon([](const Submission&) {
+        counter++;   // a previous run's globals are never seen
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        return counter;
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<int> codes(3, -1);
+    std::vector<std::thread> clients;
+    for (int i = 0; i < 3; i++) {
+        clients.emplace_back([i, &codes] {
+            std::ostringstream out;
+            codes[i] = submitToDaemon(test_socket(), make_submission("c.txt"), out);
+        });
+    }
+    for (auto& t : clients) t.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    REQUIRE(codes == std::vector<int>{1, 1, 1});
+    REQUIRE(elapsed < 0.8);
+}
+
+TEST_CASE("Daemon: a client slow to send its request holds up no other", "[daemon][timing]") {
+    DaemonProcess daemon([](const Submission&) { return 4; });
+
+    // Connects, sends half a submission, then nothing.
+    int slow = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, test_socket().c_str(), sizeof(addr.sun_path) - 1);
+    REQUIRE(connect(slow, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    REQUIRE(write(slow, "cwd\t/tmp\n", 9) == 9);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto start = std::chrono::steady_clock::now();
+    std::ostringstream out;
+    REQUIRE(submitToDaemon(test_socket(), make_submission("c.txt"), out) == 4);
+    std::ostringstream usage;
+    REQUIRE(requestTenantUsage(test_socket(), usage));
+    REQUIRE(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < 1.0);
+    close(slow);
+}
+
+TEST_CASE("Daemon: a second daemon and an absent daemon are reported", "[daemon]") {
+    std::ostringstream out;
+    REQUIRE(submitToDaemon(test_socket(), make_submission("x.txt"), out) == -1);
+
+    DaemonProcess first([](const Submission&) { return 0; });
+    Daemon second(test_socket());
+    REQUIRE_FALSE(second.listen());
+    REQUIRE_THAT(second.error(), ContainsSubstring("already listening"));
+}
+
+// The user these tests run as, and so the tenant of what they submit.
+static std::string test_user() {
+    struct passwd* pw = getpwuid(getuid());
+    return pw ? pw->pw_name : std::to_string(getuid());
+}
+
+// A run that takes one lease for Align, prints whether it was granted, and
+// holds it for the "hold" flag's milliseconds.
+static int lease_run(const Submission& s) {
+    parallel::PluginTask task;
+    task.name = "Align";
+    if (s.flags.count("big")) task.memory_hint = 2ULL << 30;
+    DaemonLease lease(test_socket(), s.flags.at("session"), task);
+    if (!lease.error().empty()) {
+        std::cout << lease.error() << std::endl;
+        return 3;
+    }
+    std::cout << "granted to " << s.flags.at("tenant") << std::endl;
+    if (s.flags.count("hold")) std::this_thread::sleep_for(std::chrono::milliseconds(atoi(s.flags.at("hold").c_str())));
+    return 0;
+}
+
+TEST_CASE("Daemon: leases share one budget among tenants", "[daemon][fairshare]") {
+    DaemonProcess daemon(lease_run, 1);
+
+    Submission cohort = make_submission("cohort.txt");
+    cohort.flags["tenant"] = "cohort";
+    cohort.flags["hold"] = "600";
+    std::ostringstream cohortOut;
+    int cohortCode = -1;
+    std::thread first([&] { cohortCode = submitToDaemon(test_socket(), cohort, cohortOut); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // The only worker is held, so the next lease waits until it is given back.
+    Submission alice = make_submission("alice.txt");
+    alice.flags["tenant"] = "alice";
+    std::ostringstream aliceOut;
+    int aliceCode = -1;
+    std::thread second([&] { aliceCode = submitToDaemon(test_socket(), alice, aliceOut); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::ostringstream usage;
+    REQUIRE(requestTenantUsage(test_socket(), usage));
+    REQUIRE_THAT(usage.str(), ContainsSubstring(test_user() + "/cohort"));
+    REQUIRE_THAT(usage.str(), ContainsSubstring(test_user() + "/alice"));
+    first.join();
+    second.join();
+    REQUIRE(cohortCode == 0);
+    REQUIRE(aliceCode == 0);
+    REQUIRE_THAT(aliceOut.str(), ContainsSubstring("Waiting for Resources: Align"));
+    REQUIRE_THAT(aliceOut.str(), ContainsSubstring("granted to " + test_user() + "/alice"));
+
+    Submission big = make_submission("big.txt");
+    big.flags["big"] = "yes";
+    std::ostringstream bigOut;
+    REQUIRE(submitToDaemon(test_socket(), big, bigOut) == 3);
+    REQUIRE_THAT(bigOut.str(), ContainsSubstring("whole budget"));
+}
+
+TEST_CASE("Daemon: a run's tenant is its submitter's, whatever it asks for", "[daemon][fairshare]") {
+    DaemonProcess daemon([](const Submission& s) {
+        std::cout << "tenant " << s.flags.at("tenant") << " session " << s.flags.at("session") << std::endl;
+        return 0;
+    });
+    Submission s = make_submission("a.txt");
+    s.flags["tenant"] = "root";
+    s.flags["session"] = "forged";
+    if (test_user() == "root") s.flags["tenant"] = "nobody";
+    std::ostringstream out;
+    REQUIRE(submitToDaemon(test_socket(), s, out) == 0);
+    REQUIRE_THAT(out.str(), ContainsSubstring("tenant " + test_user() + "/" + s.flags["tenant"] + " session "));
+    REQUIRE_THAT(out.str(), !ContainsSubstring("session forged"));
+
+    // A lease must quote the session of a run going on.
+    parallel::PluginTask task;
+    task.name = "Align";
+    DaemonLease lease(test_socket(), "forged", task);
+    REQUIRE_THAT(lease.error(), ContainsSubstring("no run"));
+}
@@ -0,0 +1,249 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include "DependencyGraph.h"
+#include "TempDir.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace parallel;
+using Catch::Matchers::ContainsSubstring;
+
+namespace fs = std::filesystem;
+
+static PluginTask make_task(const std::string& name, const std::string& in, const std::string& out) {
+    return {name, in, out, 0, 0};
+}
+
+static bool depends_on(const TaskGraph& g, size_t task, size_t dep) {
+    for (size_t d : g.dependencies[task]) {
+        if (d == dep) return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// paths_overlap
+// ---------------------------------------------------------------------------
+
+TEST_CASE("paths_overlap: identical and normalized paths", "[graph][paths]") {
+    REQUIRE(paths_overlap("a/b.csv", "a/b.csv"));
+    REQUIRE(paths_overlap("a//b.csv", "a/./b.csv"));
+    REQUIRE_FALSE(paths_overlap("a/b.csv", "a/c.csv"));
+}
+
+TEST_CASE("paths_overlap: directory contains file", "[graph][paths]") {
+    REQUIRE(paths_overlap("model/weights.bin", "model/"));
+    REQUIRE(paths_overlap("model/", "model/weights.bin"));
+    REQUIRE_FALSE(paths_overlap("model2/weights.bin", "model/"));
+}
+
+TEST_CASE("paths_overlap: empty paths never overlap", "[graph][paths]") {
+    REQUIRE_FALSE(paths_overlap("", "out.csv"));
+    REQUIRE_FALSE(paths_overlap("in.csv", ""));
+}
+
+// ---------------------------------------------------------------------------
+// build_task_graph
+// ---------------------------------------------------------------------------
+
+TEST_CASE("build_task_graph: chain of producers and consumers", "[graph][build]") {
+    auto g = build_task_graph({
+        make_task("A", "raw.csv", "a.csv"),
+        make_task("B", "a.csv", "b.csv"),
+        make_task("C", "b.csv", "c.csv"),
+    });
+    REQUIRE(g.dependencies[0].empty());
+    REQUIRE(g.dependencies[1] == std::vector<size_t>{0});
+    REQUIRE(g.dependencies[2] == std::vector<size_t>{1});
+}
+
+TEST_CASE("build_task_graph: independent tasks have no edges", "[graph][build]") {
+    auto g = build_task_graph({
+        make_task("A", "raw.csv", "a.csv"),
+        make_task("B", "raw.csv", "b.csv"),
+        make_task("C", "other.csv", "c.csv"),
+    });
+    for (auto& deps : g.dependencies) REQUIRE(deps.empty());
+}
+
+TEST_CASE("build_task_graph: fan-out and fan-in", "[graph][build]") {
+    auto g = build_task_graph({
+        make_task("Split", "raw.csv", "split/"),
+        make_task("L", "split/left.csv", "left.csv"),
+        make_task("R", "split/right.csv", "right.csv"),
+        make_task("Join", "left.csv", "joined.csv"),
+    });
+    REQUIRE(depends_on(g, 1, 0));
+    REQUIRE(depends_on(g, 2, 0));
+    REQUIRE_FALSE(depends_on(g, 2, 1));
+    REQUIRE(depends_on(g, 3, 1));
+}
+
+TEST_CASE("build_task_graph: reads the latest writer only", "[graph][build]") {
+    auto g = build_task_graph({
+        make_task("W1", "in.csv", "x.csv"),
+        make_task("W2", "in.csv", "x.csv"),
+        make_task("R", "x.csv", "out.csv"),
+    });
+    REQUIRE(depends_on(g, 2, 1));
+    REQUIRE_FALSE(depends_on(g, 2, 0));
+    // write-after-write keeps the writers ordered
+    REQUIRE(depends_on(g, 1, 0));
+}
+
+TEST_CASE("build_task_graph: reading a directory waits for every file written under it", "[graph][build]") {
+    auto g = build_task_graph({
+        make_task("A", "in.csv", "dir/a.csv"),
+        make_task("B", "in.csv", "dir/b.csv"),
+        make_task("C", "dir", "out.csv"),
+        make_task("D", "in.csv", "dir"),
+        make_task("E", "dir", "out2.csv"),
+    });
+    REQUIRE(depends_on(g, 2, 0));
+    REQUIRE(depends_on(g, 2, 1));
+    // Writing the whole directory supersedes the files written before it.
+    REQUIRE(depends_on(g, 4, 3));
+    REQUIRE_FALSE(depends_on(g, 4, 0));
+    REQUIRE_FALSE(depends_on(g, 4, 1));
+}
+
+TEST_CASE("build_task_graph: overwriting an input waits for its readers", "[graph][build]") {
+    auto g = build_task_graph({
+        make_task("Reader", "shared.csv", "r.csv"),
+        make_task("Writer", "in.csv", "shared.csv"),
+    });
+    REQUIRE(depends_on(g, 1, 0));
+}
+
+// Whether writing `dir` replaces all of `path`: the same path, or one under it.
+static bool covers(const std::string& dir, const std::string& path) {
+    auto norm = [](const std::string& p) {
+        std::string n = fs::path(p).lexically_normal().generic_string();
+        while (n.size() > 1 && n.back() == '/') n.pop_back();
+        return n;
+    };
+    std::string d = norm(dir), p = norm(path);
+    if (d.empty() || p.empty()) return false;
+    return p == d || p.rfind(d + "/", 0) == 0;
+}
+
+TEST_CASE("build_task_graph: agrees with paths_overlap for nested paths", "[graph][build]") {
+    // Files and directories at several depths, some spelled unnormalized.
+    const std::vector<std::string> paths = {"d", "d/", "d/a.csv", "./d/a.csv", "d/sub", "d/sub/b.csv",
+                                            "e/a.csv", "da.csv", "/abs/d", "/abs/d/x.csv", ""};
+    std::vector<PluginTask> tasks;
+    for (size_t k = 0; k < 200; k++) {
+        tasks.push_back(make_task("P" + std::to_string(k), paths[(k * 7) % paths.size()],
+                                  paths[(k * 3 + 1) % paths.size()]));
+    }
+    auto g = build_task_graph(tasks);
+
+    for (size_t j = 0; j < tasks.size(); j++) {
+        std::vector<size_t> expected;
+        for (size_t i = 0; i < j; i++) {
+            if (!paths_overlap(tasks[j].inputfile, tasks[i].outputfile)) continue;
+            // Skipped if a later writer replaced all of it: the same path or
+            // a directory holding it.
+            bool superseded = false;
+            for (size_t k = i + 1; k < j && !superseded; k++) {
+                superseded = covers(tasks[k].outputfile, tasks[i].outputfile);
+            }
+            if (!superseded) expected.push_back(i);
+        }
+        for (size_t i = 0; i < j; i++) {
+            if (paths_overlap(tasks[i].inputfile, tasks[j].outputfile) ||
+                paths_overlap(tasks[i].outputfile, tasks[j].outputfile)) {
+                expected.push_back(i);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+        REQUIRE(g.dependencies[j] == expected);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// flatten_config
+// ---------------------------------------------------------------------------
+
+TEST_CASE("flatten_config: sequential, parallel and included plugins in order", "[graph][flatten]") {
+    TempDir dir("graph");
+    std::string sub = dir.write("sub.txt",
+        "Plugin S inputfile s_in.csv outputfile s_out.csv\n");
+    std::string main = dir.write("main.txt",
+        "Prefix run\n"
+        "Plugin A inputfile in.csv outputfile a.csv\n"
+        "Parallel workers=2\n"
+        "  Plugin B inputfile a.csv outputfile b.csv\n"
+        "  Plugin C inputfile a.csv outputfile c.csv\n"
+        "EndParallel\n"
+        "Pipeline " + sub + "\n");
+
+    auto flat = flatten_config(main);
+    REQUIRE(flat.errors.empty());
+    REQUIRE(flat.tasks.size() == 4);
+    REQUIRE(flat.tasks[0].name == "A");
+    REQUIRE(flat.tasks[0].inputfile == "run/in.csv");
+    REQUIRE(flat.tasks[0].prefix == "run/");
+    REQUIRE(flat.tasks[1].name == "B");
+    REQUIRE(flat.tasks[2].name == "C");
+    REQUIRE(flat.tasks[3].name == "S");
+    REQUIRE(flat.tasks[3].inputfile == "run/s_in.csv");
+}
+
+TEST_CASE("flatten_config: Kitty prefixes apply to included pipelines", "[graph][flatten]") {
+    TempDir dir("graph");
+    std::string sub = dir.write("sample.txt",
+        "Plugin S inputfile in.csv outputfile out.csv\n");
+    std::string main = dir.write("main.txt",
+        "Prefix run\n"
+        "LitterLaunch\n"
+        "Kitty k1\n"
+        "Pipeline " + sub + "\n"
+        "Kitty k2\n"
+        "Pipeline " + sub + "\n"
+        "LitterGather\n");
+
+    auto flat = flatten_config(main);
+    REQUIRE(flat.errors.empty());
+    REQUIRE(flat.tasks.size() == 2);
+    REQUIRE(flat.tasks[0].outputfile == "run//k1/out.csv");
+    REQUIRE(flat.tasks[1].outputfile == "run//k2/out.csv");
+    REQUIRE(build_task_graph(flat.tasks).dependencies[1].empty());
+}
+
+TEST_CASE("flatten_config: include cycle is an error", "[graph][flatten]") {
+    TempDir dir("graph");
+    std::string a = (dir.path / "a.txt").string();
+    std::string b = (dir.path / "b.txt").string();
+    dir.write("a.txt", "Pipeline " + b + "\n");
+    dir.write("b.txt", "Pipeline " + a + "\n");
+
+    auto flat = flatten_config(a);
+    REQUIRE_FALSE(flat.errors.empty());
+    REQUIRE_THAT(flat.errors[0], ContainsSubstring("cycle"));
+}
+
+TEST_CASE("flatten_config: missing include is an error", "[graph][flatten]") {
+    TempDir dir("graph");
+    std::string main = dir.write("main.txt", "Pipeline does_not_exist.txt\n");
+
+    auto flat = flatten_config(main);
+    REQUIRE(flat.errors.size() == 1);
+    REQUIRE_THAT(flat.errors[0], ContainsSubstring("does_not_exist.txt"));
+}
+
+TEST_CASE("flatten_config: parse errors carry file and line", "[graph][flatten]") {
+    TempDir dir("graph");
+    std::string main = dir.write("main.txt",
+        "Plugin A inputfile a outputfile b\n"
+        "EndParallel\n");
+
+    auto flat = flatten_config(main);
+    REQUIRE(flat.errors.size() == 1);
+    REQUIRE_THAT(flat.errors[0], ContainsSubstring("main.txt:2:"));
+}
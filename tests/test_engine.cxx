@@ -0,0 +1,141 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "Engine.h"
+#include "TempDir.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// The plugins under tests/plugins, built by CMakeLists.txt into
+// PLUMA_TEST_PLUGINS: Copy, Fail (throws in run()) and Sleep (runs a minute).
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// One Engine per process, with its catalog and history kept out of $HOME.
+static Engine& test_engine() {
+    static TempDir state("engine_state");
+    static Engine* engine = [] {
+        setenv("PLUMA_CATALOG", state.file("catalog").c_str(), 1);
+        setenv("PLUMA_HISTORY", state.file("history").c_str(), 1);
+        return new Engine(PLUMA_TEST_PLUGINS);
+    }();
+    return *engine;
+}
+
+static parallel::PluginTask make_task(const std::string& name, const std::string& in, const std::string& out) {
+    parallel::PluginTask task;
+    task.name = name;
+    task.inputfile = in;
+    task.outputfile = out;
+    return task;
+}
+
+// ---------------------------------------------------------------------------
+// Engine::run
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Engine: run returns a graph's results", "[engine]") {
+    TempDir dir("engine_run");
+    parallel::TaskGraph graph;
+    graph.tasks = {make_task("Copy", dir.write("in.txt", "sample\n"), dir.file("a.txt")),
+                   make_task("Copy", dir.file("a.txt"), dir.file("b.txt"))};
+    graph.dependencies = {{}, {0}};
+
+    parallel::SchedulerResult result = test_engine().run(graph);
+    REQUIRE(result.completed.size() == 2);
+    REQUIRE(result.failed.empty());
+    REQUIRE(read_file(dir.file("b.txt")) == "sample\n");
+}
+
+TEST_CASE("Engine: a failing step is returned, not fatal, even with fail=fast", "[engine]") {
+    TempDir dir("engine_run");
+    parallel::TaskGraph graph;
+    graph.tasks = {make_task("Copy", dir.write("in.txt", "sample\n"), dir.file("a.txt")),
+                   make_task("Fail", dir.file("a.txt"), dir.file("b.txt")),
+                   make_task("Copy", dir.file("b.txt"), dir.file("c.txt"))};
+    graph.dependencies = {{}, {0}, {1}};
+
+    parallel::SchedulerResult result = test_engine().run(graph, {{"fail", "fast"}});
+    REQUIRE(result.completed.size() == 1);
+    REQUIRE(result.completed[0].task_index == 0);
+    REQUIRE(result.failed.size() == 1);
+    REQUIRE(result.failed[0].name == "Fail");
+    REQUIRE(result.failed[0].exit_code != 0);
+    REQUIRE_FALSE(fs::exists(dir.file("c.txt")));
+
+    // The process carries on, and so does the engine.
+    graph.tasks.resize(1);
+    graph.dependencies.resize(1);
+    REQUIRE(test_engine().run(graph).completed.size() == 1);
+}
+
+TEST_CASE("Engine: run rejects a cycle", "[engine]") {
+    parallel::TaskGraph graph;
+    graph.tasks = {make_task("Copy", "a.txt", "b.txt"), make_task("Copy", "b.txt", "a.txt")};
+    graph.dependencies = {{1}, {0}};
+    REQUIRE_THROWS_AS(test_engine().run(graph), std::invalid_argument);
+}
+
+// ---------------------------------------------------------------------------
+// Engine::submit
+// ---------------------------------------------------------------------------
+
+TEST_CASE("Engine: a submitted block with a failing task fails", "[engine]") {
+    TempDir dir("engine_run");
+    parallel::ParallelBlock block;
+    block.options.fail_mode = parallel::FailMode::Continue;
+    block.tasks = {make_task("Copy", dir.write("in.txt", "sample\n"), dir.file("a.txt")),
+                   make_task("Fail", dir.file("in.txt"), dir.file("b.txt"))};
+
+    RunHandle run = test_engine().submit(block, dir.path.string());
+    REQUIRE(run.get() != 0);
+    REQUIRE(run.status() == RunStatus::Failed);
+    REQUIRE(run.progress().failed == 1);
+    // The other task still ran.
+    REQUIRE(read_file(dir.file("a.txt")) == "sample\n");
+}
+
+TEST_CASE("Engine: a cancelled run ends as cancelled", "[engine]") {
+    TempDir dir("engine_run");
+    parallel::ParallelBlock block;
+    block.tasks = {make_task("Sleep", dir.write("in.txt", "sample\n"), dir.file("a.txt"))};
+
+    RunHandle run = test_engine().submit(block, dir.path.string());
+    REQUIRE(run.status() == RunStatus::Running);
+    REQUIRE(run.cancel());
+    REQUIRE(run.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    REQUIRE(run.status() == RunStatus::Cancelled);
+    REQUIRE(run.get() == 128 + SIGTERM);
+    REQUIRE_FALSE(run.cancel());
+}
+
+TEST_CASE("Engine: run goes on beside a submitted run", "[engine]") {
+    TempDir dir("engine_run");
+    parallel::ParallelBlock block;
+    block.tasks = {make_task("Sleep", dir.write("in.txt", "sample\n"), dir.file("slow.txt"))};
+    RunHandle slow = test_engine().submit(block, dir.path.string());
+
+    // Neither reaps the other's processes.
+    parallel::TaskGraph graph;
+    graph.tasks = {make_task("Copy", dir.file("in.txt"), dir.file("a.txt"))};
+    graph.dependencies = {{}};
+    parallel::SchedulerResult result = test_engine().run(graph);
+    REQUIRE(result.completed.size() == 1);
+    REQUIRE(result.failed.empty());
+
+    REQUIRE(slow.status() == RunStatus::Running);
+    slow.cancel();
+    REQUIRE(slow.get() == 128 + SIGTERM);
+    REQUIRE(slow.status() == RunStatus::Cancelled);
+}
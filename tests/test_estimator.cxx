@@ -0,0 +1,214 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include "Estimator.h"
+#include "TempDir.h"
+
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace parallel;
+using Catch::Matchers::WithinAbs;
+
+namespace fs = std::filesystem;
+
+static const size_t GB = 1024ULL * 1024 * 1024;
+
+static RunSample sample(const std::string& plugin, size_t bytes, double seconds, size_t rss = 0) {
+    RunSample s;
+    s.plugin = plugin;
+    s.input_bytes = bytes;
+    s.seconds = seconds;
+    s.peak_rss = rss;
+    return s;
+}
+
+static ParallelBlockOptions budget(int workers, size_t memory) {
+    ParallelBlockOptions opts;
+    opts.workers = workers;
+    opts.memory = memory;
+    return opts;
+}
+
+static PluginTask task(const std::string& name, size_t memory_hint = 0) {
+    PluginTask t;
+    t.name = name;
+    t.memory_hint = memory_hint;
+    return t;
+}
+
+static TaskCost cost(double seconds, size_t memory = 0) {
+    TaskCost c;
+    c.seconds = seconds;
+    c.memory = memory;
+    c.known = true;
+    return c;
+}
+
+// ---------------------------------------------------------------------------
+// CostModel
+// ---------------------------------------------------------------------------
+
+TEST_CASE("CostModel: unknown plugins are flagged", "[estimate]") {
+    CostModel model;
+    TaskCost c = model.predict("Nope", 100);
+    REQUIRE_FALSE(c.known);
+    REQUIRE(c.seconds == 0.0);
+}
+
+TEST_CASE("CostModel: runtime scales with input size", "[estimate]") {
+    CostModel model;
+    SECTION("one recorded size scales proportionally") {
+        model.add(sample("A", 1000, 10.0, 100));
+        REQUIRE_THAT(model.predict("A", 3000).seconds, WithinAbs(30.0, 1e-9));
+        REQUIRE(model.predict("A", 3000).memory == 300);
+        REQUIRE(model.predict("A", 500).memory == 100);   // never scaled down
+    }
+    SECTION("several sizes fit a line with start-up time") {
+        model.add(sample("A", 1000, 12.0));
+        model.add(sample("A", 2000, 22.0));
+        model.add(sample("A", 3000, 32.0));
+        REQUIRE_THAT(model.predict("A", 10000).seconds, WithinAbs(102.0, 1e-6));
+    }
+    SECTION("unknown input size uses the mean") {
+        model.add(sample("A", 1000, 10.0));
+        model.add(sample("A", 3000, 20.0));
+        REQUIRE_THAT(model.predict("A", 0).seconds, WithinAbs(15.0, 1e-9));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// simulate_block
+// ---------------------------------------------------------------------------
+
+TEST_CASE("simulate_block: workers bound the makespan", "[estimate]") {
+    std::vector<PluginTask> tasks = {task("A"), task("B"), task("C"), task("D")};
+    std::vector<TaskCost> costs = {cost(10), cost(5), cost(5), cost(1)};
+
+    StageEstimate two = simulate_block(tasks, costs, budget(2, 64 * GB));
+    // A runs 0-10 alongside B 0-5, C 5-10; D starts when A finishes
+    REQUIRE_THAT(two.makespan, WithinAbs(11.0, 1e-9));
+    REQUIRE(two.critical_path == std::vector<std::string>{"A", "D"});
+
+    StageEstimate four = simulate_block(tasks, costs, budget(4, 64 * GB));
+    REQUIRE_THAT(four.makespan, WithinAbs(10.0, 1e-9));
+    REQUIRE(four.critical_path == std::vector<std::string>{"A"});
+}
+
+TEST_CASE("simulate_block: memory admits tasks like ResourceBudget", "[estimate]") {
+    std::vector<PluginTask> tasks = {task("Big", 48 * GB), task("Big", 48 * GB), task("Small", 1 * GB)};
+    std::vector<TaskCost> costs = {cost(10, 40 * GB), cost(10, 40 * GB), cost(1, 1 * GB)};
+
+    StageEstimate stage = simulate_block(tasks, costs, budget(8, 64 * GB));
+    // The second Big waits for the first; Small is backfilled beside it.
+    REQUIRE_THAT(stage.makespan, WithinAbs(20.0, 1e-9));
+    REQUIRE(stage.peak_memory == 41 * GB);
+
+    StageEstimate never = simulate_block({task("Huge", 128 * GB)}, {cost(1)}, budget(8, 64 * GB));
+    REQUIRE(never.never_fit.size() == 1);
+    REQUIRE(never.makespan == 0.0);
+}
+
+TEST_CASE("simulate_block: small tasks are backfilled around a blocked one", "[estimate]") {
+    // A holds half the memory for 10s; Big needs all of it. The two small
+    // tasks fit now and end before A does, so they need not wait for Big.
+    std::vector<PluginTask> tasks = {task("A", 32 * GB), task("Big", 64 * GB), task("S", 16 * GB), task("S", 16 * GB)};
+    std::vector<TaskCost> costs = {cost(10), cost(5), cost(4), cost(4)};
+
+    ParallelBlockOptions options = budget(4, 64 * GB);
+    options.order = DispatchOrder::Config;
+    REQUIRE_THAT(simulate_block(tasks, costs, options).makespan, WithinAbs(15.0, 1e-9));
+
+    options.backfill = false;
+    REQUIRE_THAT(simulate_block(tasks, costs, options).makespan, WithinAbs(19.0, 1e-9));
+}
+
+TEST_CASE("simulate_block: the longest task starts first unless order=config", "[estimate]") {
+    std::vector<PluginTask> tasks = {task("A"), task("B"), task("Long")};
+    std::vector<TaskCost> costs = {cost(1), cost(1), cost(10)};
+
+    ParallelBlockOptions options = budget(2, 64 * GB);
+    StageEstimate longest = simulate_block(tasks, costs, options);
+    REQUIRE_THAT(longest.makespan, WithinAbs(10.0, 1e-9));
+    REQUIRE(longest.critical_path == std::vector<std::string>{"Long"});
+
+    options.order = DispatchOrder::Config;
+    StageEstimate config = simulate_block(tasks, costs, options);
+    REQUIRE_THAT(config.makespan, WithinAbs(11.0, 1e-9));
+    REQUIRE(config.critical_path == std::vector<std::string>{"A", "Long"});
+}
+
+// ---------------------------------------------------------------------------
+// estimate_plan
+// ---------------------------------------------------------------------------
+
+TEST_CASE("estimate_plan: stages add up, peaks take the maximum", "[estimate]") {
+    TempDir dir("estimate");
+    std::string in = dir.write("in.csv", std::string(1000, 'x'));
+    std::string sub = dir.write("sub.txt", "Plugin B inputfile x outputfile y\nPlugin B inputfile y outputfile z\n");
+    std::string config = dir.write("main.txt",
+        "Plugin A inputfile " + in + " outputfile a\n"
+        "Parallel workers=2\n"
+        "Plugin B inputfile " + in + " outputfile b1\n"
+        "Plugin B inputfile " + in + " outputfile b2\n"
+        "Plugin C inputfile " + in + " outputfile c\n"
+        "EndParallel\n"
+        "LitterLaunch workers=2\n"
+        "Kitty s1\nPipeline " + sub + "\n"
+        "Kitty s2\nPipeline " + sub + "\n"
+        "LitterGather\n"
+        "Plugin Unknown inputfile a outputfile u\n");
+
+    CostModel model;
+    model.add(sample("A", 1000, 4.0, 2 * GB));
+    model.add(sample("B", 0, 3.0, 1 * GB));
+    model.add(sample("C", 1000, 5.0, 1 * GB));
+
+    RunEstimate estimate = estimate_plan(build_plan(config), model);
+    REQUIRE(estimate.stages.size() == 4);
+    REQUIRE_THAT(estimate.stages[0].makespan, WithinAbs(4.0, 1e-9));
+    // C (longest) starts alongside one B, the other B follows it: 3 + 3
+    REQUIRE_THAT(estimate.stages[1].makespan, WithinAbs(6.0, 1e-9));
+    REQUIRE(estimate.stages[1].peak_memory == 2 * GB);
+    // Two kitties side by side, each B then B
+    REQUIRE_THAT(estimate.stages[2].makespan, WithinAbs(6.0, 1e-9));
+    REQUIRE(estimate.stages[2].critical_path.size() == 2);
+    REQUIRE(estimate.stages[2].critical_path[0] == "s2:B(x)");
+    REQUIRE(estimate.stages[3].unknown == 1);
+
+    REQUIRE_THAT(estimate.makespan, WithinAbs(16.0, 1e-9));
+    REQUIRE(estimate.peak_memory == 2 * GB);
+    REQUIRE(estimate.unknown == 1);
+    REQUIRE(estimate.critical_path.front() == "A(in.csv)");
+}
+
+TEST_CASE("estimate_plan: a Scatter runs its shards as a block, then the merge", "[estimate][scatter]") {
+    TempDir dir("estimate");
+    std::string in = dir.write("in.csv", std::string(1000, 'x'));
+    std::string config = dir.write("main.txt",
+        "Scatter shards=4 workers=2 gather=Merge\n"
+        "Plugin A inputfile " + in + " outputfile a\n"
+        "EndScatter\n");
+
+    CostModel model;
+    model.add(sample("A", 1000, 4.0, 1 * GB));
+    model.add(sample("Merge", 1000, 1.0, 2 * GB));
+
+    RunEstimate estimate = estimate_plan(build_plan(config), model);
+    REQUIRE(estimate.stages.size() == 1);
+    REQUIRE(estimate.stages[0].label == "Scatter A over 4 shards");
+    REQUIRE(estimate.stages[0].tasks == 5);
+    // Four 1s shards two at a time, then the merge
+    REQUIRE_THAT(estimate.stages[0].makespan, WithinAbs(3.0, 1e-9));
+    REQUIRE(estimate.stages[0].peak_memory == 2 * GB);
+    REQUIRE(estimate.stages[0].critical_path.back() == "Merge");
+}
+
+TEST_CASE("format helpers", "[estimate]") {
+    REQUIRE(format_seconds(12.34) == "12.3s");
+    REQUIRE(format_seconds(125) == "2m 05s");
+    REQUIRE(format_seconds(3 * 3600 + 120) == "3h 02m");
+    REQUIRE(format_bytes(512) == "512B");
+    REQUIRE(format_bytes(3 * GB / 2) == "1.5G");
+}
@@ -0,0 +1,115 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "ExecutionContext.h"
+
+#include <unistd.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static std::vector<std::string> read_lines(const std::string& path) {
+    std::vector<std::string> lines;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+    return lines;
+}
+
+TEST_CASE("ExecutionContext: Scope installs and restores the current context", "[context]") {
+    ExecutionContext outer("outer/");
+    ExecutionContext inner("inner/");
+    std::string before = ExecutionContext::current().prefix();
+    {
+        ExecutionContext::Scope a(outer);
+        REQUIRE(ExecutionContext::current().prefix() == "outer/");
+        {
+            ExecutionContext::Scope b(inner);
+            REQUIRE(ExecutionContext::current().prefix() == "inner/");
+        }
+        REQUIRE(ExecutionContext::current().prefix() == "outer/");
+    }
+    REQUIRE(ExecutionContext::current().prefix() == before);
+}
+
+TEST_CASE("ExecutionContext: concurrent threads each see their own prefix", "[context]") {
+    std::vector<std::thread> threads;
+    std::vector<int> mismatches(8, 0);
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([t, &mismatches] {
+            ExecutionContext context("kitty" + std::to_string(t) + "/");
+            ExecutionContext::Scope scope(context);
+            for (int i = 0; i < 1000; i++) {
+                if (ExecutionContext::current().prefix() != "kitty" + std::to_string(t) + "/") mismatches[t]++;
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    for (int m : mismatches) REQUIRE(m == 0);
+}
+
+TEST_CASE("ExecutionContext: withPrefix keeps the sink, label and allotment", "[context]") {
+    auto sink = std::make_shared<LogSink>();
+    ResourceAllotment allotment;
+    allotment.memory = 1024;
+    allotment.gpu = 1;
+    ExecutionContext parent("a/", sink, allotment);
+    parent.setLabel("s1");
+
+    ExecutionContext child = parent.withPrefix("a/b/");
+    REQUIRE(child.prefix() == "a/b/");
+    REQUIRE(child.label() == "s1");
+    REQUIRE(child.sink() == sink);
+    REQUIRE(child.allotment().memory == 1024);
+    REQUIRE(child.allotment().gpu == 1);
+    REQUIRE(parent.prefix() == "a/");
+}
+
+TEST_CASE("LogSink: lines from concurrent pipelines stay whole", "[context][log]") {
+    fs::path path = fs::temp_directory_path() / ("pluma_context_" + std::to_string(getpid()) + ".log");
+    {
+        auto sink = std::make_shared<LogSink>(path.string());
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([t, sink] {
+                ExecutionContext context("", sink);
+                context.setLabel("k" + std::to_string(t));
+                for (int i = 0; i < 200; i++) context.log("step " + std::to_string(i));
+            });
+        }
+        for (auto& th : threads) th.join();
+    }
+
+    std::vector<std::string> lines = read_lines(path.string());
+    fs::remove(path);
+    REQUIRE(lines.size() == 800);
+    for (const auto& line : lines) {
+        REQUIRE(line.compare(0, 10, "[PluMA] [k") == 0);
+        REQUIRE(line.find("step ") != std::string::npos);
+    }
+}
+
+TEST_CASE("ExecutionContext: a context without a sink drops messages", "[context][log]") {
+    ExecutionContext context("x/");
+    context.log("nowhere");
+    SUCCEED();
+}
+
+TEST_CASE("ExecutionContext: phases accumulate wall time", "[context][phases]") {
+    ExecutionContext context("x/");
+    context.beginPhase(ExecutionContext::Input);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    context.beginPhase(ExecutionContext::Run);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    context.endPhase();
+    context.endPhase();     // no phase open: nothing more is charged
+
+    REQUIRE(context.phaseTimes().input >= 0.04);
+    REQUIRE(context.phaseTimes().run >= 0.09);
+    REQUIRE(context.phaseTimes().run < 1.0);
+    REQUIRE(context.phaseTimes().output == 0.0);
+}
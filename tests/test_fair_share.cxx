@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include "FairShare.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace parallel;
+using Catch::Matchers::ContainsSubstring;
+
+static constexpr size_t GB = 1024ULL * 1024 * 1024;
+
+static ParallelBlockOptions shared_budget(int workers, size_t memory, int gpu = 0) {
+    ParallelBlockOptions opts;
+    opts.workers = workers;
+    opts.memory = memory;
+    opts.gpu = gpu;
+    return opts;
+}
+
+static PluginTask leased(const std::string& name, size_t memory = 0, double seconds = 0.0) {
+    PluginTask task;
+    task.name = name;
+    task.memory_hint = memory;
+    task.expected_seconds = seconds;
+    return task;
+}
+
+TEST_CASE("FairShare: a tenant with nothing running goes before a long queue", "[fairshare]") {
+    FairShare share(shared_budget(2, 2 * GB));
+    for (uint64_t id = 0; id < 4; id++) REQUIRE(share.request(id, "cohort", leased("Align"), 0.0));
+    REQUIRE(share.grant(0.0) == std::vector<uint64_t>{0, 1});
+
+    REQUIRE(share.request(10, "alice", leased("Plot"), 1.0));
+    REQUIRE(share.grant(1.0).empty());
+
+    share.release(0, 2.0);
+    REQUIRE(share.grant(2.0) == std::vector<uint64_t>{10});
+    share.release(1, 3.0);
+    REQUIRE(share.grant(3.0) == std::vector<uint64_t>{2});
+}
+
+TEST_CASE("FairShare: weights divide the budget", "[fairshare]") {
+    FairShare share(shared_budget(3, 3 * GB), {{"interactive", 2.0}});
+    for (uint64_t id = 0; id < 6; id++) {
+        REQUIRE(share.request(id, "cohort", leased("Align"), 0.0));
+        REQUIRE(share.request(100 + id, "interactive", leased("Plot"), 0.0));
+    }
+    std::vector<uint64_t> granted = share.grant(0.0);
+    REQUIRE(granted.size() == 3);
+    size_t interactive = std::count_if(granted.begin(), granted.end(), [](uint64_t id) { return id >= 100; });
+    REQUIRE(interactive == 2);
+
+    std::string error;
+    std::map<std::string, double> weights;
+    REQUIRE(parse_weights("alice:2,bob:0.5", weights, error));
+    REQUIRE(weights == std::map<std::string, double>{{"alice", 2.0}, {"bob", 0.5}});
+    REQUIRE_FALSE(parse_weights("alice", weights, error));
+    REQUIRE_FALSE(parse_weights("alice:0", weights, error));
+    REQUIRE_THAT(error, ContainsSubstring("alice:0"));
+}
+
+TEST_CASE("FairShare: a user's labels split its share rather than add to it", "[fairshare]") {
+    FairShare share(shared_budget(4, 4 * GB), {{"bob", 1.0}});
+    // Bob spreads a cohort over three labels; alice queues under her name.
+    uint64_t id = 0;
+    for (const char* tenant : {"bob/a", "bob/b", "bob/c"}) {
+        for (int i = 0; i < 4; i++) REQUIRE(share.request(id++, tenant, leased("Align"), 0.0));
+    }
+    for (int i = 0; i < 4; i++) REQUIRE(share.request(100 + i, "alice", leased("Plot"), 0.0));
+
+    std::vector<uint64_t> granted = share.grant(0.0);
+    REQUIRE(granted.size() == 4);
+    size_t alice = std::count_if(granted.begin(), granted.end(), [](uint64_t g) { return g >= 100; });
+    REQUIRE(alice == 2);
+
+    // The weight is the user's too, and usage still lists each label.
+    REQUIRE(share.weight("bob/a") == share.weight("bob"));
+    std::vector<TenantUsage> usage = share.usage(0.0);
+    REQUIRE(usage.size() == 4);
+}
+
+TEST_CASE("FairShare: a large task is not starved by a stream of small ones", "[fairshare]") {
+    FairShare share(shared_budget(4, 4 * GB));
+    for (uint64_t id = 0; id < 3; id++) REQUIRE(share.request(id, "alice", leased("Small"), 0.0));
+    REQUIRE(share.grant(0.0).size() == 3);
+
+    REQUIRE(share.request(10, "bob", leased("Big", 4 * GB), 1.0));
+    REQUIRE(share.request(3, "alice", leased("Small"), 1.0));
+    // Bob's task waits for all of memory; Alice's next task would delay it.
+    REQUIRE(share.grant(1.0).empty());
+
+    for (uint64_t id = 0; id < 3; id++) share.release(id, 2.0);
+    share.release(3, 2.0);
+    REQUIRE(share.grant(2.0) == std::vector<uint64_t>{10});
+
+    // No task may ask for more than the whole budget.
+    REQUIRE_FALSE(share.request(20, "bob", leased("Huge", 5 * GB), 3.0));
+}
+
+TEST_CASE("FairShare: reports per-tenant usage", "[fairshare]") {
+    FairShare share(shared_budget(1, 4 * GB), {{"bob", 3.0}});
+    share.add_run("alice");
+    share.add_run("bob");
+    REQUIRE(share.request(0, "alice", leased("A", 2 * GB), 0.0));
+    REQUIRE(share.request(1, "bob", leased("B"), 0.0));
+    REQUIRE(share.grant(0.0) == std::vector<uint64_t>{0});
+    share.release(0, 10.0);
+    REQUIRE(share.grant(10.0) == std::vector<uint64_t>{1});
+
+    std::vector<TenantUsage> usage = share.usage(15.0);
+    REQUIRE(usage.size() == 2);
+    REQUIRE(usage[0].tenant == "alice");
+    REQUIRE(usage[0].runs == 1);
+    REQUIRE(usage[0].tasks == 1);
+    REQUIRE(usage[0].running == 0);
+    REQUIRE(std::fabs(usage[0].worker_seconds - 10.0) < 1e-9);
+    REQUIRE(std::fabs(usage[0].memory_gb_seconds - 20.0) < 1e-9);
+    REQUIRE(usage[1].tenant == "bob");
+    REQUIRE(usage[1].weight == 3.0);
+    REQUIRE(usage[1].running == 1);
+    REQUIRE(std::fabs(usage[1].worker_seconds - 5.0) < 1e-9);
+    REQUIRE(std::fabs(usage[1].wait_seconds - 10.0) < 1e-9);
+    REQUIRE(std::fabs(usage[1].share - 1.0 / 3.0) < 1e-9);
+
+    std::string table = format_usage(usage, share.budget());
+    REQUIRE_THAT(table, ContainsSubstring("Budget: 1 workers"));
+    REQUIRE_THAT(table, ContainsSubstring("alice"));
+    REQUIRE_THAT(table, ContainsSubstring("bob"));
+}
@@ -0,0 +1,103 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include "Inbox.h"
+#include "TempDir.h"
+
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace parallel;
+using Catch::Matchers::ContainsSubstring;
+
+namespace fs = std::filesystem;
+
+static PluginTask make_step(const std::string& name, const std::string& in, const std::string& out,
+                            const std::string& prefix = "") {
+    PluginTask task;
+    task.name = name;
+    task.inputfile = prefix + in;
+    task.outputfile = prefix + out;
+    task.prefix = prefix;
+    return task;
+}
+
+TEST_CASE("sample_tasks: fills in the sample, {path} ignoring the Prefix", "[inbox]") {
+    std::vector<PluginTask> steps = {
+        make_step("Trim", "{path}", "{sample}.trimmed.fq", "out/"),
+        make_step("Align", "{sample}.trimmed.fq", "{sample}.bam", "out/"),
+    };
+    steps[1].journal_id = "Align#0";
+
+    auto tasks = sample_tasks(steps, "inbox/s7.fq");
+    REQUIRE(tasks.size() == 2);
+    REQUIRE(tasks[0].inputfile == "inbox/s7.fq");
+    REQUIRE(tasks[0].outputfile == "out/s7.trimmed.fq");
+    REQUIRE(tasks[1].inputfile == "out/s7.trimmed.fq");
+    REQUIRE(tasks[1].outputfile == "out/s7.bam");
+    REQUIRE(tasks[1].journal_id.empty());
+}
+
+TEST_CASE("inbox_step_errors: every output must name the sample", "[inbox]") {
+    std::vector<PluginTask> steps = {
+        make_step("Trim", "{path}", "{sample}.fq"),
+        make_step("Index", "ref.fa", "ref.idx"),
+    };
+    auto errors = inbox_step_errors(steps);
+    REQUIRE(errors.size() == 1);
+    REQUIRE_THAT(errors[0], ContainsSubstring("ref.idx of plugin Index"));
+}
+
+TEST_CASE("InboxWatcher: samples already there come first, sorted", "[inbox]") {
+    TempDir dir("inbox");
+    dir.write("s2.fq", "x");
+    dir.write("s1.fq", "x");
+    dir.write(".partial", "x");
+
+    InboxWatcher inbox(dir.path.string());
+    REQUIRE(inbox.error().empty());
+    std::string path;
+    REQUIRE(inbox.next(path, 0) == BatchSource::Ready);
+    REQUIRE(path == dir.file("s1.fq"));
+    REQUIRE(inbox.next(path, 0) == BatchSource::Ready);
+    REQUIRE(path == dir.file("s2.fq"));
+    REQUIRE(inbox.next(path, 0) == BatchSource::Waiting);
+    REQUIRE(inbox.produced() == 2);
+}
+
+TEST_CASE("InboxWatcher: picks up files written or renamed into the inbox", "[inbox]") {
+    TempDir dir("inbox");
+    InboxWatcher inbox(dir.path.string());
+    std::string path;
+    REQUIRE(inbox.next(path, 0) == BatchSource::Waiting);
+
+    dir.write("s3.fq", "reads");
+    REQUIRE(inbox.next(path, 1000) == BatchSource::Ready);
+    REQUIRE(path == dir.file("s3.fq"));
+
+    dir.write(".s4.tmp", "reads");
+    REQUIRE(inbox.next(path, 0) == BatchSource::Waiting);
+    fs::rename(dir.file(".s4.tmp"), dir.file("s4.fq"));
+    REQUIRE(inbox.next(path, 1000) == BatchSource::Ready);
+    REQUIRE(path == dir.file("s4.fq"));
+
+    // Rewriting a sample does not hand it out again.
+    dir.write("s3.fq", "more reads");
+    REQUIRE(inbox.next(path, 50) == BatchSource::Waiting);
+}
+
+TEST_CASE("InboxWatcher: done once idle for long enough", "[inbox]") {
+    TempDir dir("inbox");
+    InboxWatcher inbox(dir.path.string(), 0.1);
+    std::string path;
+    REQUIRE(inbox.next(path, -1) == BatchSource::Done);
+}
+
+TEST_CASE("InboxWatcher: a missing directory is an error", "[inbox]") {
+    TempDir dir("inbox");
+    InboxWatcher inbox(dir.file("nope"));
+    REQUIRE_THAT(inbox.error(), ContainsSubstring("nope"));
+    std::string path;
+    REQUIRE(inbox.next(path, 0) == BatchSource::Done);
+}
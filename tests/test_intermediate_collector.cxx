@@ -0,0 +1,190 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "IntermediateCollector.h"
+#include "TempDir.h"
+
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace parallel;
+
+namespace fs = std::filesystem;
+
+static PluginTask step(const std::string& name, const std::string& in, const std::string& out, bool intermediate = false) {
+    PluginTask task;
+    task.name = name;
+    task.inputfile = in;
+    task.outputfile = out;
+    task.intermediate = intermediate;
+    return task;
+}
+
+static bool always(const PluginTask&) { return true; }
+
+TEST_CASE("IntermediateCollector: removes an output once its last reader completes", "[intermediate]") {
+    TempDir dir("gc");
+    std::vector<PluginTask> steps = {
+        step("Trim", dir.file("reads.fq"), dir.file("trimmed.fq"), true),
+        step("Align", dir.file("trimmed.fq"), dir.file("aligned.bam")),
+        step("Stats", dir.file("trimmed.fq"), dir.file("stats.txt")),
+    };
+    IntermediateCollector collector(always);
+    collector.add_steps(steps);
+    REQUIRE(collector.tracked() == 1);
+
+    dir.write("trimmed.fq", "12345");
+    REQUIRE(collector.completed(steps[0]).empty());
+    REQUIRE(collector.completed(steps[1]).empty());
+    REQUIRE(fs::exists(dir.file("trimmed.fq")));
+
+    auto collected = collector.completed(steps[2]);
+    REQUIRE(collected == std::vector<std::string>{dir.file("trimmed.fq")});
+    REQUIRE_FALSE(fs::exists(dir.file("trimmed.fq")));
+    REQUIRE(collector.collected_bytes() == 5);
+    REQUIRE(collector.tracked() == 0);
+}
+
+TEST_CASE("IntermediateCollector: reports a collection, with its readers, before collecting", "[intermediate]") {
+    TempDir dir("gc");
+    std::vector<PluginTask> steps = {
+        step("Trim", dir.file("reads.fq"), dir.file("trimmed.fq"), true),
+        step("Align", dir.file("trimmed.fq"), dir.file("aligned.bam")),
+        step("Stats", dir.file("trimmed.fq"), dir.file("stats.txt")),
+    };
+    steps[1].journal_id = "align#0";
+    steps[2].journal_id = "stats#0";
+    IntermediateCollector collector(always);
+    collector.add_steps(steps);
+
+    std::vector<std::string> reported, readers;
+    bool present = false;
+    collector.on_collect([&](const std::string& path, const std::vector<PluginTask>& completed_readers) {
+        reported.push_back(path);
+        for (const auto& r : completed_readers) readers.push_back(r.journal_id);
+        present = fs::exists(path);
+    });
+    dir.write("trimmed.fq");
+    for (const auto& s : steps) collector.completed(s);
+
+    REQUIRE(reported == std::vector<std::string>{dir.file("trimmed.fq")});
+    REQUIRE(readers == std::vector<std::string>{"align#0", "stats#0"});
+    REQUIRE(present);
+    REQUIRE_FALSE(fs::exists(dir.file("trimmed.fq")));
+}
+
+TEST_CASE("IntermediateCollector: readers of a directory output count", "[intermediate]") {
+    TempDir dir("gc");
+    std::vector<PluginTask> steps = {
+        step("Split", dir.file("in.csv"), dir.file("parts"), true),
+        step("Sum", dir.file("parts/p1.csv"), dir.file("sum.csv")),
+    };
+    IntermediateCollector collector(always);
+    collector.add_steps(steps);
+    dir.write("parts/p1.csv");
+
+    collector.completed(steps[0]);
+    REQUIRE(collector.completed(steps[1]).size() == 1);
+    REQUIRE_FALSE(fs::exists(dir.file("parts")));
+}
+
+TEST_CASE("IntermediateCollector: outputs nothing reads, or that cannot be regenerated, stay", "[intermediate]") {
+    TempDir dir("gc");
+    std::vector<PluginTask> steps = {
+        step("A", dir.file("in"), dir.file("a"), true),
+        step("B", dir.file("a"), dir.file("b"), true),
+    };
+    dir.write("a");
+    dir.write("b");
+
+    IntermediateCollector keep([](const PluginTask&) { return false; });
+    keep.add_steps(steps);
+    keep.completed(steps[0]);
+    REQUIRE(keep.completed(steps[1]).empty());
+    REQUIRE(fs::exists(dir.file("a")));
+
+    IntermediateCollector collector(always);
+    collector.add_steps(steps);
+    collector.completed(steps[0]);
+    REQUIRE(collector.completed(steps[1]).size() == 1);
+    REQUIRE_FALSE(fs::exists(dir.file("a")));
+    REQUIRE(fs::exists(dir.file("b")));
+}
+
+TEST_CASE("IntermediateCollector: a reader that never completes keeps its input", "[intermediate]") {
+    TempDir dir("gc");
+    std::vector<PluginTask> steps = {
+        step("A", dir.file("in"), dir.file("a"), true),
+        step("B", dir.file("a"), dir.file("b")),
+        step("C", dir.file("a"), dir.file("c")),
+    };
+    dir.write("a");
+    IntermediateCollector collector(always);
+    collector.add_steps(steps);
+    collector.completed(steps[0]);
+    REQUIRE(collector.completed(steps[2]).empty());
+    REQUIRE(fs::exists(dir.file("a")));
+}
+
+TEST_CASE("IntermediateCollector: only the producer's later readers count", "[intermediate]") {
+    TempDir dir("gc");
+    std::vector<PluginTask> steps = {
+        step("Peek", dir.file("a"), dir.file("peek")),     // reads a before it is produced
+        step("A", dir.file("in"), dir.file("a"), true),
+        step("Other", dir.file("in"), dir.file("other")),
+        step("B", dir.file("a"), dir.file("b")),
+    };
+    dir.write("a");
+    IntermediateCollector collector(always);
+    collector.add_steps(steps);
+
+    REQUIRE(collector.completed(steps[0]).empty());
+    REQUIRE(collector.completed(steps[1]).empty());
+    REQUIRE(collector.completed(steps[2]).empty());
+    // A step reading the same path that is not among the registered steps
+    REQUIRE(collector.completed(step("Extra", dir.file("a"), dir.file("extra"))).empty());
+    REQUIRE(fs::exists(dir.file("a")));
+
+    REQUIRE(collector.completed(steps[3]).size() == 1);
+    REQUIRE_FALSE(fs::exists(dir.file("a")));
+}
+
+TEST_CASE("IntermediateCollector: forgets the steps of a sample that ended", "[intermediate]") {
+    TempDir dir("gc");
+    std::vector<PluginTask> steps = {
+        step("A", dir.file("in"), dir.file("a"), true),
+        step("B", dir.file("a"), dir.file("b"), true),
+        step("C", dir.file("b"), dir.file("c")),
+    };
+    dir.write("a");
+    IntermediateCollector collector(always);
+    collector.add_steps(steps);
+    REQUIRE(collector.tracked() == 2);
+
+    // A failed, so B and C never run
+    collector.forget(steps);
+    REQUIRE(collector.tracked() == 0);
+    REQUIRE(collector.completed(steps[1]).empty());
+    REQUIRE(fs::exists(dir.file("a")));
+}
+
+TEST_CASE("IntermediateCollector: can move outputs instead of removing them", "[intermediate]") {
+    TempDir dir("gc");
+    std::vector<PluginTask> steps = {
+        step("A", dir.file("in"), dir.file("work/a.txt"), true),
+        step("B", dir.file("work/a.txt"), dir.file("b")),
+    };
+    dir.write("work/a.txt", "kept");
+    IntermediateCollector collector(always, dir.file("cold"));
+    collector.add_steps(steps);
+    collector.completed(steps[0]);
+    REQUIRE(collector.completed(steps[1]).size() == 1);
+
+    std::string moved = collector.moved_path(dir.file("work/a.txt"));
+    REQUIRE(moved == (fs::path(dir.file("cold")) / fs::path(dir.file("work/a.txt")).relative_path()).string());
+    REQUIRE_FALSE(fs::exists(dir.file("work/a.txt")));
+    std::ifstream in(moved);
+    std::string contents;
+    in >> contents;
+    REQUIRE(contents == "kept");
+}
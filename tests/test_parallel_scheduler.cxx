@@ -7,7 +7,11 @@
 #include <thread>
 #include <fstream>
 #include <filesystem>
+#include <cstdio>
 #include <cstdlib>
+#include <algorithm>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace parallel;
 using Catch::Matchers::WithinAbs;
@@ -258,6 +262,39 @@ TEST_CASE("Scheduler: fail=continue collects all failure names", "[scheduler][fa
     REQUIRE(found_bad2);
 }
 
+TEST_CASE("Scheduler: task larger than the whole budget fails instead of hanging", "[scheduler][failure]") {
+    auto block = make_block(
+        {make_task("Huge", 64ULL * 1024 * 1024 * 1024), make_task("Small", 1ULL * 1024 * 1024 * 1024)},
+        /*workers=*/2,
+        /*memory=*/4ULL * 1024 * 1024 * 1024,
+        /*gpu=*/0,
+        FailMode::Continue
+    );
+
+    ParallelScheduler scheduler;
+    auto result = scheduler.run(block, [](const PluginTask&) { return 0; });
+
+    REQUIRE(result.failed.size() == 1);
+    REQUIRE(result.failed[0].name == "Huge");
+    REQUIRE(result.failed[0].task_index == 0);
+    REQUIRE(result.completed.size() == 1);
+    REQUIRE(result.completed[0].name == "Small");
+}
+
+TEST_CASE("Scheduler: fail=fast reports the plugins it killed", "[scheduler][failure]") {
+    auto block = make_block({make_task("Slow"), make_task("Fail")}, /*workers=*/2);
+
+    ParallelScheduler scheduler;
+    auto result = scheduler.run(block, [](const PluginTask& t) {
+        if (t.name == "Fail") return 1;
+        std::this_thread::sleep_for(std::chrono::seconds(5));
+        return 0;
+    });
+
+    REQUIRE(result.completed.empty());
+    REQUIRE(result.failed.size() == 2);
+}
+
 // ---------------------------------------------------------------------------
 // Exit codes
 // ---------------------------------------------------------------------------
@@ -331,6 +368,57 @@ TEST_CASE("Scheduler: worker runs in separate process (parent state untouched)",
     REQUIRE(parent_value == 42);  // parent's value unchanged
 }
 
+TEST_CASE("Scheduler: other children of the process keep their exit status", "[scheduler][isolation]") {
+    // Forked by the program itself, and ending while the graph runs.
+    pid_t other = fork();
+    if (other == 0) {
+        usleep(100000);
+        _exit(7);
+    }
+
+    auto block = make_block({make_task("A"), make_task("B")}, 1);
+    ParallelScheduler scheduler;
+    auto result = scheduler.run(block, [](const PluginTask&) {
+        usleep(200000);
+        return 0;
+    });
+    REQUIRE(result.completed.size() == 2);
+
+    int status = 0;
+    REQUIRE(waitpid(other, &status, 0) == other);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 7);
+}
+
+// Runs a one-task block with the process's stdout on a file; returns what
+// the worker wrote there.
+static std::string worker_stdout(ParallelScheduler::WorkerOutput output) {
+    std::string path = (fs::temp_directory_path() / ("pluma_stdout_" + std::to_string(getpid()))).string();
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    FILE* capture = fopen(path.c_str(), "w");
+    dup2(fileno(capture), STDOUT_FILENO);
+
+    ParallelScheduler scheduler(output);
+    scheduler.run(make_block({make_task("A")}), [](const PluginTask&) {
+        printf("from the worker\n");
+        return 0;
+    });
+
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    fclose(capture);
+    std::ifstream in(path);
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    fs::remove(path);
+    return text;
+}
+
+TEST_CASE("Scheduler: worker output is discarded unless inherited", "[scheduler][isolation]") {
+    REQUIRE(worker_stdout(ParallelScheduler::WorkerOutput::Discard).empty());
+    REQUIRE(worker_stdout(ParallelScheduler::WorkerOutput::Inherit) == "from the worker\n");
+}
+
 // ---------------------------------------------------------------------------
 // Stress: many plugins
 // ---------------------------------------------------------------------------
@@ -351,3 +439,412 @@ TEST_CASE("Scheduler: handles 20 plugins with worker pool", "[scheduler][stress]
     REQUIRE(result.completed.size() == 20);
     REQUIRE(result.failed.empty());
 }
+
+// ---------------------------------------------------------------------------
+// Dependency graphs
+// ---------------------------------------------------------------------------
+
+static TaskGraph make_graph(std::vector<PluginTask> tasks, std::vector<std::vector<size_t>> deps) {
+    TaskGraph graph;
+    graph.tasks = std::move(tasks);
+    graph.dependencies = std::move(deps);
+    return graph;
+}
+
+static ParallelBlockOptions make_options(int workers, FailMode fail = FailMode::Fast) {
+    ParallelBlockOptions opts;
+    opts.workers   = workers;
+    opts.memory    = 32ULL * 1024 * 1024 * 1024;
+    opts.fail_mode = fail;
+    return opts;
+}
+
+// Workers run in forked children, so ordering is observed through a file.
+static void append_line(const fs::path& file, const std::string& line) {
+    std::ofstream(file, std::ios::app) << line << "\n";
+}
+
+static std::vector<std::string> read_lines(const fs::path& file) {
+    std::vector<std::string> lines;
+    std::ifstream in(file);
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+    return lines;
+}
+
+TEST_CASE("Scheduler: graph runs dependents after their producers", "[scheduler][graph]") {
+    fs::path trace = fs::temp_directory_path() / ("pluma_trace_" + std::to_string(getpid()));
+    fs::remove(trace);
+
+    // A -> B -> C, with D independent
+    auto graph = make_graph(
+        {make_task("A"), make_task("B"), make_task("C"), make_task("D")},
+        {{}, {0}, {1}, {}});
+
+    ParallelScheduler scheduler;
+    auto result = scheduler.run_graph(graph, make_options(4), [&trace](const PluginTask& t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        append_line(trace, t.name);
+        return 0;
+    });
+
+    REQUIRE(result.completed.size() == 4);
+    auto lines = read_lines(trace);
+    fs::remove(trace);
+    REQUIRE(lines.size() == 4);
+    auto pos = [&lines](const std::string& n) {
+        return std::find(lines.begin(), lines.end(), n) - lines.begin();
+    };
+    REQUIRE(pos("A") < pos("B"));
+    REQUIRE(pos("B") < pos("C"));
+}
+
+TEST_CASE("Scheduler: independent graph branches overlap", "[scheduler][graph][timing]") {
+    // Root fans out to three 300ms tasks
+    auto graph = make_graph(
+        {make_task("Root"), make_task("X"), make_task("Y"), make_task("Z")},
+        {{}, {0}, {0}, {0}});
+
+    ParallelScheduler scheduler;
+    auto result = scheduler.run_graph(graph, make_options(4), [](const PluginTask&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        return 0;
+    });
+
+    REQUIRE(result.completed.size() == 4);
+    // Root then one round of X/Y/Z ≈ 0.6s; fully sequential would be 1.2s
+    REQUIRE(result.total_elapsed_seconds < 1.1);
+}
+
+TEST_CASE("Scheduler: longest expected task starts first", "[scheduler][order]") {
+    fs::path trace = fs::temp_directory_path() / ("pluma_trace_" + std::to_string(getpid()));
+    fs::remove(trace);
+
+    std::vector<PluginTask> tasks = {make_task("Short"), make_task("Unknown"), make_task("Long"), make_task("Medium")};
+    tasks[0].expected_seconds = 10;
+    tasks[2].expected_seconds = 3600;
+    tasks[3].expected_seconds = 60;
+    auto block = make_block(tasks, 1);
+
+    ParallelScheduler scheduler;
+    auto result = scheduler.run(block, [&trace](const PluginTask& t) {
+        append_line(trace, t.name);
+        return 0;
+    });
+    REQUIRE(result.completed.size() == 4);
+    REQUIRE(read_lines(trace) == std::vector<std::string>{"Long", "Medium", "Short", "Unknown"});
+
+    fs::remove(trace);
+    block.options.order = DispatchOrder::Config;
+    scheduler.run(block, [&trace](const PluginTask& t) {
+        append_line(trace, t.name);
+        return 0;
+    });
+    REQUIRE(read_lines(trace) == std::vector<std::string>{"Short", "Unknown", "Long", "Medium"});
+    fs::remove(trace);
+}
+
+TEST_CASE("Scheduler: graph starts the longest critical path first", "[scheduler][order][graph]") {
+    fs::path trace = fs::temp_directory_path() / ("pluma_trace_" + std::to_string(getpid()));
+    fs::remove(trace);
+
+    // A (1s) -> B (100s); C (50s) alone. A is shorter than C but heads the
+    // longer chain, so it goes first.
+    std::vector<PluginTask> tasks = {make_task("C"), make_task("A"), make_task("B")};
+    tasks[0].expected_seconds = 50;
+    tasks[1].expected_seconds = 1;
+    tasks[2].expected_seconds = 100;
+    auto graph = make_graph(tasks, {{}, {}, {1}});
+
+    std::vector<double> lengths = critical_path_lengths(graph);
+    REQUIRE(lengths == std::vector<double>{50, 101, 100});
+
+    ParallelScheduler scheduler;
+    scheduler.run_graph(graph, make_options(1), [&trace](const PluginTask& t) {
+        append_line(trace, t.name);
+        return 0;
+    });
+    REQUIRE(read_lines(trace) == std::vector<std::string>{"A", "B", "C"});
+    fs::remove(trace);
+}
+
+TEST_CASE("Scheduler: small tasks are backfilled while a large one waits", "[scheduler][backfill]") {
+    fs::path trace = fs::temp_directory_path() / ("pluma_trace_" + std::to_string(getpid()));
+    constexpr size_t GB = 1024ULL * 1024 * 1024;
+
+    // A holds half the memory; Big needs all of it, so it waits for A. The
+    // small tasks fit now and are expected to end before A does.
+    std::vector<PluginTask> tasks = {make_task("A", 2 * GB), make_task("Big", 4 * GB),
+                                     make_task("S1", 1 * GB), make_task("S2", 1 * GB)};
+    tasks[0].expected_seconds = 5;
+    tasks[2].expected_seconds = 0.1;
+    tasks[3].expected_seconds = 0.1;
+    auto block = make_block(tasks, 4, 4 * GB);
+    block.options.order = DispatchOrder::Config;
+    auto worker = [&trace](const PluginTask& t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(t.name == "A" ? 300 : 20));
+        append_line(trace, t.name);
+        return 0;
+    };
+
+    fs::remove(trace);
+    ParallelScheduler scheduler;
+    REQUIRE(scheduler.run(block, worker).completed.size() == 4);
+    auto lines = read_lines(trace);
+    REQUIRE(lines.size() == 4);
+    REQUIRE(std::vector<std::string>(lines.begin() + 2, lines.end()) == std::vector<std::string>{"A", "Big"});
+
+    // Without backfill everything queues behind Big.
+    fs::remove(trace);
+    block.options.backfill = false;
+    REQUIRE(scheduler.run(block, worker).completed.size() == 4);
+    lines = read_lines(trace);
+    REQUIRE(lines.size() == 4);
+    REQUIRE(std::vector<std::string>(lines.begin(), lines.begin() + 2) == std::vector<std::string>{"A", "Big"});
+    fs::remove(trace);
+}
+
+TEST_CASE("Scheduler: failed task skips its dependents only", "[scheduler][graph][failure]") {
+    // Bad -> After -> Last, Other independent
+    auto graph = make_graph(
+        {make_task("Bad"), make_task("After"), make_task("Last"), make_task("Other")},
+        {{}, {0}, {1}, {}});
+
+    ParallelScheduler scheduler;
+    auto result = scheduler.run_graph(graph, make_options(2, FailMode::Continue), [](const PluginTask& t) {
+        return t.name == "Bad" ? 1 : 0;
+    });
+
+    REQUIRE(result.failed.size() == 1);
+    REQUIRE(result.skipped.size() == 2);
+    REQUIRE(result.completed.size() == 1);
+    REQUIRE(result.completed[0].name == "Other");
+}
+
+TEST_CASE("Scheduler: a task below two failed tasks is skipped once", "[scheduler][graph][failure]") {
+    // Bad1 and Bad2 -> Join -> Last
+    auto graph = make_graph(
+        {make_task("Bad1"), make_task("Bad2"), make_task("Join"), make_task("Last")},
+        {{}, {}, {0, 1}, {2}});
+
+    ParallelScheduler scheduler;
+    auto result = scheduler.run_graph(graph, make_options(2, FailMode::Continue), [](const PluginTask& t) {
+        return t.name.rfind("Bad", 0) == 0 ? 1 : 0;
+    });
+
+    REQUIRE(result.failed.size() == 2);
+    REQUIRE(result.skipped.size() == 2);
+    REQUIRE(result.completed.empty());
+}
+
+TEST_CASE("Scheduler: graph without edges behaves like a block", "[scheduler][graph]") {
+    auto graph = make_graph({make_task("A"), make_task("B")}, {{}, {}});
+
+    ParallelScheduler scheduler;
+    auto result = scheduler.run_graph(graph, make_options(2), [](const PluginTask&) { return 0; });
+
+    REQUIRE(result.completed.size() == 2);
+    REQUIRE(result.skipped.empty());
+}
+
+// ---------------------------------------------------------------------------
+// Streamed tasks
+// ---------------------------------------------------------------------------
+
+// Counts how far the source runs ahead of the results handed back.
+struct CountingSource : TaskSource {
+    size_t total, produced = 0, finished = 0, max_ahead = 0;
+    explicit CountingSource(size_t n) : total(n) {}
+    bool next(PluginTask& task) override {
+        if (produced == total) return false;
+        task = make_task("T" + std::to_string(produced++));
+        max_ahead = std::max(max_ahead, produced - finished);
+        return true;
+    }
+};
+
+TEST_CASE("Scheduler: stream pulls tasks only as workers free up", "[scheduler][stream]") {
+    CountingSource source(200);
+    size_t ok = 0;
+
+    ParallelScheduler scheduler;
+    auto result = scheduler.run_stream(source, make_options(4), [](const PluginTask&) { return 0; },
+        [&](const PluginTask&, const PluginResult& pr) {
+            source.finished++;
+            if (pr.exit_code == 0) ok++;
+        });
+
+    REQUIRE(ok == 200);
+    REQUIRE(result.failed.empty());
+    REQUIRE(result.completed.empty());
+    // Four running plus the one waiting for a free worker.
+    REQUIRE(source.max_ahead <= 5);
+}
+
+TEST_CASE("Scheduler: stream failures follow the fail mode", "[scheduler][stream][failure]") {
+    auto fail_t3 = [](const PluginTask& t) { return t.name == "T3" ? 1 : 0; };
+
+    SECTION("continue runs every task") {
+        CountingSource source(10);
+        ParallelScheduler scheduler;
+        auto result = scheduler.run_stream(source, make_options(2, FailMode::Continue), fail_t3);
+        REQUIRE(source.produced == 10);
+        REQUIRE(result.failed.size() == 1);
+        REQUIRE(result.failed[0].name == "T3");
+        REQUIRE(result.failed[0].task_index == 3);
+    }
+
+    SECTION("fast stops pulling tasks") {
+        CountingSource source(1000);
+        ParallelScheduler scheduler;
+        auto result = scheduler.run_stream(source, make_options(1), fail_t3);
+        REQUIRE(result.failed.size() == 1);
+        REQUIRE(source.produced < 1000);
+    }
+}
+
+TEST_CASE("Scheduler: stream fails a task that can never fit", "[scheduler][stream][failure]") {
+    struct TwoTasks : TaskSource {
+        int n = 0;
+        bool next(PluginTask& task) override {
+            if (n == 2) return false;
+            task = n == 0 ? make_task("Huge", 64ULL * 1024 * 1024 * 1024) : make_task("Small");
+            n++;
+            return true;
+        }
+    } source;
+
+    std::vector<std::string> seen;
+    ParallelScheduler scheduler;
+    auto result = scheduler.run_stream(source, make_options(2, FailMode::Continue),
+        [](const PluginTask&) { return 0; },
+        [&](const PluginTask& t, const PluginResult&) { seen.push_back(t.name); });
+
+    REQUIRE(result.failed.size() == 1);
+    REQUIRE(result.failed[0].name == "Huge");
+    REQUIRE(seen.size() == 2);
+}
+
+TEST_CASE("Scheduler: reports the peak RSS of each worker", "[scheduler][resources]") {
+    auto block = make_block({make_task("Big"), make_task("Small")});
+
+    ParallelScheduler scheduler;
+    auto result = scheduler.run(block, [](const PluginTask& task) {
+        if (task.name == "Big") {
+            std::vector<char> buffer(64 * 1024 * 1024, 1);
+            return buffer[12345] == 1 ? 0 : 1;
+        }
+        return 0;
+    });
+
+    REQUIRE(result.completed.size() == 2);
+    size_t big = 0, small = 0;
+    for (const auto& r : result.completed) (r.name == "Big" ? big : small) = r.peak_rss;
+    REQUIRE(small > 0);
+    REQUIRE(big >= small + 32 * 1024 * 1024);
+}
+
+// ---------------------------------------------------------------------------
+// Batches arriving during the run
+// ---------------------------------------------------------------------------
+
+// Hands out each batch once its arrival time, in seconds after the first
+// call, has passed.
+struct TimedBatches : BatchSource {
+    std::vector<std::pair<double, TaskGraph>> batches;
+    size_t handed = 0;
+    bool started = false;
+    std::chrono::steady_clock::time_point start;
+
+    void add(double at, TaskGraph graph) { batches.push_back({at, std::move(graph)}); }
+
+    Status next(TaskGraph& batch, int timeout_ms) override {
+        if (!started) start = std::chrono::steady_clock::now();
+        started = true;
+        if (handed == batches.size()) return Done;
+        auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(batches[handed].first));
+        auto now = std::chrono::steady_clock::now();
+        if (timeout_ms >= 0 && now + std::chrono::milliseconds(timeout_ms) < due) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            return Waiting;
+        }
+        std::this_thread::sleep_until(due);
+        batch = batches[handed++].second;
+        return Ready;
+    }
+};
+
+static TaskGraph make_chain(const std::string& prefix, size_t steps) {
+    std::vector<PluginTask> tasks;
+    std::vector<std::vector<size_t>> deps;
+    for (size_t i = 0; i < steps; i++) {
+        tasks.push_back(make_task(prefix + std::to_string(i + 1)));
+        deps.push_back(i == 0 ? std::vector<size_t>{} : std::vector<size_t>{i - 1});
+    }
+    return make_graph(tasks, deps);
+}
+
+TEST_CASE("Scheduler: batches run their own steps in order, the earliest batch first", "[scheduler][batches]") {
+    fs::path trace = fs::temp_directory_path() / ("pluma_trace_" + std::to_string(getpid()));
+    fs::remove(trace);
+
+    TimedBatches source;
+    source.add(0, make_chain("a", 3));
+    source.add(0, make_chain("b", 3));
+
+    std::vector<size_t> indices;
+    ParallelScheduler scheduler;
+    auto result = scheduler.run_batches(source, make_options(1), [&trace](const PluginTask& t) {
+        append_line(trace, t.name);
+        return 0;
+    }, [&](const PluginTask&, const PluginResult& pr) { indices.push_back(pr.task_index); });
+
+    REQUIRE(result.failed.empty());
+    REQUIRE(read_lines(trace) == std::vector<std::string>{"a1", "a2", "a3", "b1", "b2", "b3"});
+    REQUIRE(indices == std::vector<size_t>{0, 1, 2, 3, 4, 5});
+    fs::remove(trace);
+}
+
+TEST_CASE("Scheduler: a batch that arrives mid-run overlaps the one running", "[scheduler][batches][timing]") {
+    TimedBatches source;
+    source.add(0, make_chain("a", 2));
+    source.add(0.2, make_chain("b", 2));
+
+    size_t done = 0;
+    ParallelScheduler scheduler;
+    auto result = scheduler.run_batches(source, make_options(2), [](const PluginTask&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        return 0;
+    }, [&](const PluginTask&, const PluginResult& pr) { if (pr.exit_code == 0) done++; });
+
+    REQUIRE(done == 4);
+    // b1 starts beside a2 rather than after it: about 0.8s, one batch after
+    // the other would be 1.2s.
+    REQUIRE(result.total_elapsed_seconds < 1.1);
+}
+
+TEST_CASE("Scheduler: a failed step skips the rest of its batch only", "[scheduler][batches][failure]") {
+    TimedBatches source;
+    source.add(0, make_chain("bad", 3));
+    source.add(0, make_chain("ok", 2));
+
+    size_t ok = 0, skipped = 0, reported = 0;
+    ParallelScheduler scheduler;
+    auto result = scheduler.run_batches(source, make_options(2, FailMode::Continue),
+        [](const PluginTask& t) { return t.name == "bad1" ? 1 : 0; },
+        [&](const PluginTask&, const PluginResult& pr) {
+            reported++;
+            if (pr.exit_code == 0) ok++;
+            if (pr.skipped) skipped++;
+        });
+
+    REQUIRE(result.failed.size() == 1);
+    REQUIRE(result.failed[0].name == "bad1");
+    REQUIRE_FALSE(result.failed[0].skipped);
+    REQUIRE(result.skipped.size() == 2);
+    REQUIRE(ok == 2);
+    // Every task is reported once, the skipped ones included.
+    REQUIRE(skipped == 2);
+    REQUIRE(reported == 5);
+}
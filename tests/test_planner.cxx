@@ -0,0 +1,192 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include "Planner.h"
+#include "TempDir.h"
+
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace parallel;
+using Catch::Matchers::ContainsSubstring;
+
+namespace fs = std::filesystem;
+
+static std::map<std::string, std::string> installed(std::initializer_list<std::string> names) {
+    std::map<std::string, std::string> langs;
+    for (const auto& n : names) langs[n + "Plugin"] = "C";
+    return langs;
+}
+
+// ---------------------------------------------------------------------------
+// build_plan
+// ---------------------------------------------------------------------------
+
+TEST_CASE("build_plan: records origins and Parallel membership", "[plan]") {
+    TempDir dir("plan");
+    std::string config = dir.write("main.txt",
+        "Plugin A inputfile in.csv outputfile a.csv\n"
+        "# comment\n"
+        "Parallel workers=2\n"
+        "  Plugin B inputfile a.csv outputfile b.csv\n"
+        "EndParallel\n");
+
+    Plan plan = build_plan(config);
+    REQUIRE(plan.errors.empty());
+    REQUIRE(plan.steps.size() == 2);
+    REQUIRE(plan.steps[0].origin == config + ":1");
+    REQUIRE_FALSE(plan.steps[0].parallel);
+    REQUIRE(plan.steps[1].origin == config + ":4");
+    REQUIRE(plan.steps[1].parallel);
+}
+
+TEST_CASE("build_plan: an include used by every Kitty is read once", "[plan]") {
+    TempDir dir("plan");
+    std::string sub = dir.write("sub.txt", "Plugin Norm inputfile in.csv outputfile out.csv\n");
+    std::string config = dir.write("main.txt",
+        "Prefix run\n"
+        "LitterLaunch workers=2\n"
+        "Kitty s1\nPipeline " + sub + "\n"
+        "Kitty s2\nPipeline " + sub + "\n"
+        "Kitty s3\nPipeline " + sub + "\n"
+        "LitterGather\n"
+        "Plugin Merge inputfile run/ outputfile merged.csv\n");
+
+    Plan plan = build_plan(config);
+    REQUIRE(plan.errors.empty());
+    REQUIRE(plan.files.size() == 2);
+    REQUIRE(plan.steps.size() == 4);
+    REQUIRE(plan.steps[0].kitty == "s1");
+    REQUIRE(plan.steps[2].kitty == "s3");
+    REQUIRE(plan.steps[2].task.inputfile == "run//s3/in.csv");
+    REQUIRE(plan.steps[3].kitty.empty());
+}
+
+TEST_CASE("build_plan: include cycles and unreadable includes are errors", "[plan]") {
+    TempDir dir("plan");
+    dir.write("a.txt", "Pipeline " + dir.file("b.txt") + "\n");
+    dir.write("b.txt", "Pipeline " + dir.file("a.txt") + "\nPipeline " + dir.file("missing.txt") + "\n");
+
+    Plan plan = build_plan(dir.file("a.txt"));
+    REQUIRE(plan.errors.size() == 2);
+    REQUIRE_THAT(plan.errors[0], ContainsSubstring("include cycle"));
+    REQUIRE_THAT(plan.errors[1], ContainsSubstring("cannot open"));
+}
+
+// ---------------------------------------------------------------------------
+// check_plan
+// ---------------------------------------------------------------------------
+
+TEST_CASE("check_plan: a valid plan has no problems", "[plan][check]") {
+    TempDir dir("plan");
+    dir.write("in.csv", "1");
+    std::string config = dir.write("main.txt",
+        "Plugin A inputfile " + dir.file("in.csv") + " outputfile " + dir.file("a") + "\n"
+        "Plugin B inputfile " + dir.file("a.csv") + " outputfile " + dir.file("b.csv") + "\n");
+
+    REQUIRE(check_plan(build_plan(config), installed({"A", "B"})).empty());
+}
+
+TEST_CASE("check_plan: unknown plugins are reported with their line", "[plan][check]") {
+    TempDir dir("plan");
+    dir.write("in.csv", "1");
+    std::string config = dir.write("main.txt",
+        "Plugin A inputfile " + dir.file("in.csv") + " outputfile " + dir.file("a.csv") + "\n"
+        "Plugin Typo inputfile " + dir.file("a.csv") + " outputfile " + dir.file("b.csv") + "\n");
+
+    auto langs = installed({"A"});
+    langs["TypoPlugin"] = "";   // left behind by a failed lookup
+    auto problems = check_plan(build_plan(config), langs);
+    REQUIRE(problems.size() == 1);
+    REQUIRE_THAT(problems[0], ContainsSubstring("main.txt:2: plugin Typo is not installed"));
+}
+
+TEST_CASE("check_plan: missing external inputs are reported once", "[plan][check]") {
+    TempDir dir("plan");
+    std::string sub = dir.write("sub.txt", "Plugin A inputfile nope.csv outputfile out.csv\n");
+    std::string config = dir.write("main.txt",
+        "Kitty s1\nPipeline " + sub + "\n"
+        "Kitty s1\nPipeline " + sub + "\n"
+        "Plugin A inputfile " + dir.file("later.csv") + " outputfile x.csv\n"
+        "Plugin A inputfile x.csv outputfile " + dir.file("later.csv") + "\n");
+
+    auto problems = check_plan(build_plan(config), installed({"A"}));
+    REQUIRE(problems.size() == 2);
+    REQUIRE_THAT(problems[0], ContainsSubstring("input /s1/nope.csv of plugin A does not exist"));
+    REQUIRE_THAT(problems[1], ContainsSubstring("later.csv"));
+}
+
+TEST_CASE("check_plan: a Sweep is one step checked for its sample list", "[plan][check][sweep]") {
+    TempDir dir("plan");
+    std::string config = dir.write("main.txt",
+        "Prefix " + dir.path.string() + "\n"
+        "Sweep samples=samples.txt\n"
+        "Plugin A inputfile {sample}.fq outputfile {sample}.out\n"
+        "EndSweep\n");
+
+    Plan plan = build_plan(config);
+    REQUIRE(plan.steps.size() == 1);
+    REQUIRE(plan.steps[0].sweep);
+    REQUIRE(plan.steps[0].origin == config + ":3");
+
+    auto problems = check_plan(plan, installed({"A"}));
+    REQUIRE(problems.size() == 1);
+    REQUIRE_THAT(problems[0], ContainsSubstring("sample list " + dir.file("samples.txt")));
+
+    dir.write("samples.txt", "s1\n");
+    REQUIRE(check_plan(plan, installed({"A"})).empty());
+}
+
+TEST_CASE("check_plan: a Scatter's gather plugin must be installed", "[plan][check][scatter]") {
+    TempDir dir("plan");
+    dir.write("reads.fq", "@r\nACGT\n+\nIIII\n");
+    std::string config = dir.write("main.txt",
+        "Prefix " + dir.path.string() + "\n"
+        "Scatter shards=4 gather=Merge\n"
+        "Plugin A inputfile reads.fq outputfile out.fq\n"
+        "EndScatter\n");
+
+    Plan plan = build_plan(config);
+    REQUIRE(plan.steps.size() == 1);
+    REQUIRE(plan.steps[0].scatter);
+    REQUIRE(plan.steps[0].scatter_block.shards == 4);
+
+    auto problems = check_plan(plan, installed({"A"}));
+    REQUIRE(problems.size() == 1);
+    REQUIRE_THAT(problems[0], ContainsSubstring("gather plugin Merge"));
+    REQUIRE(check_plan(plan, installed({"A", "Merge"})).empty());
+}
+
+TEST_CASE("check_plan: --inbox template inputs are not checked", "[plan][check][inbox]") {
+    TempDir dir("plan");
+    std::string config = dir.write("main.txt",
+        "Plugin A inputfile {path} outputfile {sample}.a\n"
+        "Plugin B inputfile {sample}.missing outputfile {sample}.b\n");
+
+    REQUIRE(check_plan(build_plan(config), installed({"A", "B"})).empty());
+}
+
+// ---------------------------------------------------------------------------
+// plan_languages
+// ---------------------------------------------------------------------------
+
+TEST_CASE("plan_languages: the languages a config needs, in order of first use", "[plan][languages]") {
+    TempDir dir("plan");
+    dir.write("stage.txt", "Plugin Fit inputfile b.txt outputfile c.txt\n");
+    std::string config = dir.write("main.txt",
+        "Plugin Trim inputfile in.txt outputfile a.txt\n"
+        "Scatter shards=2 gather=Merge\n"
+        "Plugin Align inputfile a.txt outputfile b.txt\n"
+        "EndScatter\n"
+        "Pipeline " + dir.file("stage.txt") + "\n"
+        "Plugin Missing inputfile c.txt outputfile d.txt\n");
+
+    std::map<std::string, std::string> langs = {
+        {"TrimPlugin", "C"}, {"AlignPlugin", "C"}, {"MergePlugin", "Perl"},
+        {"FitPlugin", "R"}, {"PlotPlugin", "Python"}};
+    Plan plan = build_plan(config);
+    REQUIRE(plan.errors.empty());
+    REQUIRE(plan_languages(plan, langs) == std::vector<std::string>{"C", "Perl", "R"});
+    REQUIRE(plan_languages(build_plan(dir.write("none.txt", "")), langs).empty());
+}
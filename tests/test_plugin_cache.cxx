@@ -0,0 +1,106 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "Fingerprint.h"
+#include "PluginCache.h"
+#include "TempDir.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+using namespace parallel;
+
+namespace fs = std::filesystem;
+
+static PluginTask make_task(const std::string& name, const std::string& in, const std::string& out) {
+    PluginTask task;
+    task.name = name;
+    task.inputfile = in;
+    task.outputfile = out;
+    return task;
+}
+
+// ---------------------------------------------------------------------------
+// Fingerprints
+// ---------------------------------------------------------------------------
+
+TEST_CASE("fingerprint_string: SHA-256 test vectors", "[cache][fingerprint]") {
+    REQUIRE(fingerprint_string("") ==
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    REQUIRE(fingerprint_string("abc") ==
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    REQUIRE(fingerprint_string(std::string(1000, 'a')) ==
+            "41edece42d63e8d9bf515a9ba6932e1c20cbc9f5a5d134645adb5db1b9737ea3");
+}
+
+TEST_CASE("fingerprint_path: files, directories and missing paths", "[cache][fingerprint]") {
+    TempDir tmp("cache");
+    std::string file = tmp.write("in.csv", "abc");
+    REQUIRE(fingerprint_path(file) == fingerprint_string("abc"));
+    REQUIRE(fingerprint_path((tmp.path / "missing").string()).empty());
+
+    tmp.write("dir/a.txt", "1");
+    std::string before = fingerprint_path((tmp.path / "dir").string());
+    tmp.write("dir/a.txt", "2");
+    REQUIRE(fingerprint_path((tmp.path / "dir").string()) != before);
+}
+
+// ---------------------------------------------------------------------------
+// PluginCache
+// ---------------------------------------------------------------------------
+
+TEST_CASE("PluginCache::key: depends on artifact, input contents and output path", "[cache]") {
+    TempDir tmp("cache");
+    PluginCache cache((tmp.path / "cache").string());
+    std::string plugin = tmp.write("Norm/libNormPlugin.so", "v1");
+    std::string input = tmp.write("in.csv", "1,2,3");
+    PluginTask task = make_task("Norm", input, (tmp.path / "out.csv").string());
+
+    std::string k = cache.key(plugin, task);
+    REQUIRE(k.size() == 64);
+    REQUIRE(cache.key(plugin, task) == k);
+
+    tmp.write("in.csv", "1,2,4");
+    REQUIRE(cache.key(plugin, task) != k);
+    tmp.write("in.csv", "1,2,3");
+    REQUIRE(cache.key(plugin, task) == k);
+
+    tmp.write("Norm/libNormPlugin.so", "v2");
+    REQUIRE(cache.key(plugin, task) != k);
+    tmp.write("Norm/libNormPlugin.so", "v1");
+
+    PluginTask moved = task;
+    moved.outputfile = (tmp.path / "other.csv").string();
+    REQUIRE(cache.key(plugin, moved) != k);
+}
+
+TEST_CASE("PluginCache: store then restore outputs", "[cache]") {
+    TempDir tmp("cache");
+    PluginCache cache((tmp.path / "cache").string());
+    std::string out = (tmp.path / "run" / "out").string();
+    std::string key = fingerprint_string("entry");
+
+    REQUIRE_FALSE(cache.restore(key, out));
+
+    auto start = PluginCache::Clock::now();
+    tmp.write("run/out", "result");
+    tmp.write("run/out.log", "log");
+    tmp.write("run/unrelated.txt", "keep");
+    REQUIRE(cache.store(key, out, start));
+    REQUIRE(cache.contains(key));
+
+    fs::remove_all(tmp.path / "run");
+    REQUIRE(cache.restore(key, out));
+    REQUIRE(tmp.read("run/out") == "result");
+    REQUIRE(tmp.read("run/out.log") == "log");
+    REQUIRE_FALSE(fs::exists(tmp.path / "run" / "unrelated.txt"));
+}
+
+TEST_CASE("PluginCache::store: nothing to store when the plugin wrote nothing", "[cache]") {
+    TempDir tmp("cache");
+    PluginCache cache((tmp.path / "cache").string());
+    std::string key = fingerprint_string("empty");
+    REQUIRE_FALSE(cache.store(key, (tmp.path / "out.csv").string(), PluginCache::Clock::now()));
+    REQUIRE_FALSE(cache.contains(key));
+}
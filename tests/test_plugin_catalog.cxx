@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "PluginCatalog.h"
+#include "TempDir.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace parallel;
+
+namespace fs = std::filesystem;
+
+// A plugin root with a catalog file beside it, removed at scope exit.
+struct CatalogDir : TempDir {
+    CatalogDir() : TempDir("catalog") { fs::create_directories(path / "plugins"); }
+    std::string root() const { return (path / "plugins").string(); }
+    std::string catalog() const { return (path / "catalog").string(); }
+    // Writes plugins/dir/file, then dates the directories as if it had been
+    // there `age` ago, past the window in which a change may go unseen.
+    void add(const std::string& dir, const std::string& file, std::chrono::minutes age = std::chrono::minutes(60)) const {
+        fs::create_directories(path / "plugins" / dir);
+        std::ofstream(path / "plugins" / dir / file) << "x";
+        fs::file_time_type then = fs::file_time_type::clock::now() - age;
+        fs::last_write_time(path / "plugins" / dir, then);
+        fs::last_write_time(path / "plugins", then);
+    }
+};
+
+// Every *Plugin.so in the directory, counting the directories it is asked about.
+struct CountingScanner {
+    std::atomic<int> calls{0};
+    PluginCatalog::Scanner scanner() {
+        return [this](const std::string& dir) {
+            calls++;
+            std::vector<CatalogEntry> found;
+            for (const auto& file : fs::directory_iterator(dir)) {
+                std::string name = file.path().filename().string();
+                if (name.size() > 9 && name.compare(name.size() - 9, 9, "Plugin.so") == 0)
+                    found.push_back({name.substr(3, name.size() - 6), "C", file.path().string()});
+            }
+            std::sort(found.begin(), found.end(),
+                      [](const CatalogEntry& a, const CatalogEntry& b) { return a.path < b.path; });
+            return found;
+        };
+    }
+};
+
+TEST_CASE("PluginCatalog: a saved catalog is used instead of scanning", "[catalog]") {
+    CatalogDir dir;
+    dir.add("Trim", "libTrimPlugin.so");
+    dir.add("Align", "libAlignPlugin.so");
+    dir.add("Align", "README");
+    CountingScanner counting;
+
+    PluginCatalog first(dir.catalog(), "C:lib*Plugin.so");
+    std::vector<CatalogEntry> entries = first.scan(dir.root(), counting.scanner(), 4);
+    REQUIRE(entries.size() == 2);
+    REQUIRE(entries[0].name == "AlignPlugin");
+    REQUIRE(entries[0].language == "C");
+    REQUIRE(entries[1].path == dir.root() + "/Trim/libTrimPlugin.so");
+    REQUIRE(first.rescanned() == 2);
+    REQUIRE(first.save());
+
+    counting.calls = 0;
+    PluginCatalog second(dir.catalog(), "C:lib*Plugin.so");
+    std::vector<CatalogEntry> cached = second.scan(dir.root(), counting.scanner(), 4);
+    REQUIRE(counting.calls == 0);
+    REQUIRE(cached.size() == 2);
+    REQUIRE(cached[1].name == "TrimPlugin");
+    REQUIRE(cached[1].path == entries[1].path);
+
+    // Other rules, such as another set of languages, mean a full scan.
+    PluginCatalog other(dir.catalog(), "C:lib*Plugin.so Python:*Plugin.py");
+    other.scan(dir.root(), counting.scanner());
+    REQUIRE(counting.calls == 2);
+}
+
+TEST_CASE("PluginCatalog: only changed directories are scanned again", "[catalog]") {
+    CatalogDir dir;
+    for (const char* name : {"A", "B", "C", "D"}) dir.add(name, std::string("lib") + name + "Plugin.so");
+    CountingScanner counting;
+    {
+        PluginCatalog catalog(dir.catalog(), "rules");
+        REQUIRE(catalog.scan(dir.root(), counting.scanner()).size() == 4);
+        REQUIRE(catalog.save());
+    }
+
+    dir.add("B", "libB2Plugin.so", std::chrono::minutes(30));
+    fs::remove_all(fs::path(dir.root()) / "D");
+    dir.add("E", "libEPlugin.so", std::chrono::minutes(30));
+    counting.calls = 0;
+    PluginCatalog catalog(dir.catalog(), "rules");
+    std::vector<CatalogEntry> entries = catalog.scan(dir.root(), counting.scanner());
+    REQUIRE(counting.calls == 2);
+    REQUIRE(catalog.rescanned() == 2);
+    std::vector<std::string> names;
+    for (const auto& entry : entries) names.push_back(entry.name);
+    REQUIRE(names == std::vector<std::string>{"APlugin", "B2Plugin", "BPlugin", "CPlugin", "EPlugin"});
+    REQUIRE(catalog.save());
+
+    // A change too recent for its mtime to be trusted is looked at again.
+    dir.add("C", "libC2Plugin.so", std::chrono::minutes(0));
+    counting.calls = 0;
+    PluginCatalog recent(dir.catalog(), "rules");
+    REQUIRE(recent.scan(dir.root(), counting.scanner()).size() == 6);
+    REQUIRE(recent.save());
+    PluginCatalog again(dir.catalog(), "rules");
+    again.scan(dir.root(), counting.scanner());
+    REQUIRE(counting.calls == 2);
+}
@@ -2,6 +2,9 @@
 
 #include "ResourceBudget.h"
 
+#include <algorithm>
+#include <limits>
+
 using namespace parallel;
 
 static ParallelBlockOptions make_opts(int workers, size_t memory, int gpu) {
@@ -180,3 +183,86 @@ TEST_CASE("ResourceBudget: can dispatch when exactly fitting remaining budget",
     budget.acquire(t1);
     REQUIRE(budget.can_dispatch(t2));
 }
+
+// ---------------------------------------------------------------------------
+// resolve_defaults
+// ---------------------------------------------------------------------------
+
+TEST_CASE("ResourceBudget: zero options resolve to system defaults", "[budget][defaults]") {
+    auto resolved = resolve_defaults(make_opts(0, 0, 0));
+    REQUIRE(resolved.workers >= 1);
+    REQUIRE(resolved.workers == std::max(1, detect_cpu_count() / 2));
+    REQUIRE(resolved.memory == detect_total_memory() / 10 * 8);
+    REQUIRE(resolved.gpu == detect_gpu_count());
+}
+
+TEST_CASE("ResourceBudget: explicit options survive resolve_defaults", "[budget][defaults]") {
+    constexpr size_t MEM = 8ULL * 1024 * 1024 * 1024;
+    auto resolved = resolve_defaults(make_opts(3, MEM, 2));
+    REQUIRE(resolved.workers == 3);
+    REQUIRE(resolved.memory  == MEM);
+    REQUIRE(resolved.gpu     == 2);
+}
+
+// ---------------------------------------------------------------------------
+// Reservations and backfill
+// ---------------------------------------------------------------------------
+
+TEST_CASE("reserve: the blocked task starts when enough running tasks end", "[budget][backfill]") {
+    constexpr size_t GB = 1024ULL * 1024 * 1024;
+    ResourceBudget budget(make_opts(8, 8 * GB, 0));
+    auto a = make_task("A", 3 * GB), b = make_task("B", 3 * GB), big = make_task("Big", 6 * GB);
+    budget.acquire(a);
+    budget.acquire(b);
+
+    // Big needs both A (ends at 20) and B (ends at 10) to end.
+    Reservation reservation = reserve(budget, {{&a, 20.0}, {&b, 10.0}}, big);
+    REQUIRE(reservation.start == 20.0);
+    REQUIRE(reservation.after.used_memory() == 6 * GB);
+
+    auto shortTask = make_task("Short", 1 * GB);
+    shortTask.expected_seconds = 5;
+    REQUIRE(may_backfill(reservation, shortTask, 0.0));     // done before Big starts
+    REQUIRE(reservation.after.used_memory() == 6 * GB);
+
+    auto longTask = make_task("Long", 1 * GB);
+    longTask.expected_seconds = 50;
+    REQUIRE(may_backfill(reservation, longTask, 0.0));      // still fits beside Big
+    REQUIRE(reservation.after.used_memory() == 7 * GB);
+
+    auto unknown = make_task("Unknown", 2 * GB);
+    REQUIRE_FALSE(may_backfill(reservation, unknown, 0.0)); // would delay Big
+}
+
+TEST_CASE("reserve: an unknown end leaves only room beside the blocked task", "[budget][backfill]") {
+    constexpr size_t GB = 1024ULL * 1024 * 1024;
+    ResourceBudget budget(make_opts(8, 8 * GB, 0));
+    auto a = make_task("A", 4 * GB), big = make_task("Big", 8 * GB);
+    budget.acquire(a);
+
+    Reservation reservation = reserve(budget, {{&a, std::numeric_limits<double>::infinity()}}, big);
+    REQUIRE(reservation.start == std::numeric_limits<double>::infinity());
+    // However quick, it might outlast A and hold Big back.
+    auto quick = make_task("Quick", 1 * GB);
+    quick.expected_seconds = 1;
+    REQUIRE_FALSE(may_backfill(reservation, quick, 0.0));
+}
+
+TEST_CASE("reserve: timed tasks are charged while an unestimated task runs", "[budget][backfill]") {
+    constexpr size_t GB = 1024ULL * 1024 * 1024;
+    ResourceBudget budget(make_opts(8, 8 * GB, 0));
+    auto a = make_task("A", 2 * GB), b = make_task("B", 2 * GB), big = make_task("Big", 7 * GB);
+    budget.acquire(a);
+    budget.acquire(b);
+
+    // Big needs A (ends at 10) and B (no estimate) to end.
+    Reservation reservation = reserve(budget, {{&a, 10.0}, {&b, std::numeric_limits<double>::infinity()}}, big);
+    REQUIRE(reservation.start == std::numeric_limits<double>::infinity());
+    REQUIRE(reservation.after.used_memory() == 7 * GB);
+
+    auto first = make_task("First", 1 * GB), second = make_task("Second", 1 * GB);
+    first.expected_seconds = second.expected_seconds = 1;
+    REQUIRE(may_backfill(reservation, first, 0.0));
+    REQUIRE(reservation.after.used_memory() == 8 * GB);
+    REQUIRE_FALSE(may_backfill(reservation, second, 0.0));
+}
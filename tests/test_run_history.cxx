@@ -0,0 +1,114 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "RunHistory.h"
+#include "TempDir.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace parallel;
+
+namespace fs = std::filesystem;
+
+static HistoryRecord make_record(const std::string& plugin, double seconds, int exit_code = 0) {
+    HistoryRecord record;
+    record.timestamp = 1700000000;
+    record.plugin = plugin;
+    record.language = "C++";
+    record.input_bytes = 4096;
+    record.input_seconds = seconds / 4;
+    record.run_seconds = seconds / 2;
+    record.output_seconds = seconds / 4;
+    record.total_seconds = seconds;
+    record.exit_code = exit_code;
+    record.peak_rss = 8 * 1024 * 1024;
+    record.host = "node1";
+    return record;
+}
+
+TEST_CASE("RunHistory: records round-trip through the file", "[history]") {
+    TempDir dir("history");
+    {
+        RunHistory history(dir.file("history"));
+        REQUIRE(history.is_open());
+        REQUIRE(history.append(make_record("Norm", 2.0)));
+        REQUIRE(history.append(make_record("Filter", 1.0, 1)));
+    }
+
+    std::vector<HistoryRecord> records = RunHistory::load(dir.file("history"));
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].plugin == "Norm");
+    REQUIRE(records[0].language == "C++");
+    REQUIRE(records[0].input_bytes == 4096);
+    REQUIRE(records[0].run_seconds == 1.0);
+    REQUIRE(records[0].total_seconds == 2.0);
+    REQUIRE(records[0].peak_rss == 8 * 1024 * 1024);
+    REQUIRE(records[0].host == "node1");
+    REQUIRE(records[1].plugin == "Filter");
+    REQUIRE(records[1].exit_code == 1);
+}
+
+TEST_CASE("RunHistory: appends to an existing history and creates its directory", "[history]") {
+    TempDir dir("history");
+    std::string path = dir.file("nested/dir/history");
+    { RunHistory(path).append(make_record("A", 1.0)); }
+    { RunHistory(path).append(make_record("B", 1.0)); }
+    REQUIRE(RunHistory::load(path).size() == 2);
+}
+
+TEST_CASE("RunHistory: separators in names do not break records", "[history]") {
+    HistoryRecord record = make_record("Odd\tName", 1.0);
+    record.host = "";
+    HistoryRecord parsed;
+    std::string line = format_history_record(record);
+    REQUIRE(parse_history_record(line.substr(0, line.size() - 1), parsed));
+    REQUIRE(parsed.plugin == "Odd Name");
+    REQUIRE(parsed.host == "");
+}
+
+TEST_CASE("RunHistory: torn and foreign lines are ignored", "[history]") {
+    TempDir dir("history");
+    std::string path = dir.file("history");
+    std::string good = format_history_record(make_record("Norm", 1.0));
+    std::ofstream(path) << "not a record\n" << good << good.substr(0, 20);
+
+    std::vector<HistoryRecord> records = RunHistory::load(path);
+    REQUIRE(records.size() == 1);
+    REQUIRE(records[0].plugin == "Norm");
+}
+
+TEST_CASE("RunHistory: forked processes append whole records", "[history]") {
+    TempDir dir("history");
+    std::string path = dir.file("history");
+    RunHistory history(path);
+    std::vector<pid_t> children;
+    for (int c = 0; c < 4; c++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            for (int i = 0; i < 100; i++) history.append(make_record("P" + std::to_string(c), i));
+            _exit(0);
+        }
+        children.push_back(pid);
+    }
+    for (pid_t pid : children) waitpid(pid, nullptr, 0);
+    REQUIRE(RunHistory::load(path).size() == 400);
+}
+
+TEST_CASE("RunHistory: default path honours PLUMA_HISTORY", "[history]") {
+    setenv("PLUMA_HISTORY", "/tmp/somewhere/history", 1);
+    REQUIRE(RunHistory::default_path() == "/tmp/somewhere/history");
+    unsetenv("PLUMA_HISTORY");
+    REQUIRE(RunHistory::default_path().find("/.pluma/history") != std::string::npos);
+}
+
+TEST_CASE("peak_rss: reports this process", "[history][rss]") {
+    reset_peak_rss();
+    size_t before = peak_rss();
+    REQUIRE(before > 0);
+    std::vector<char> buffer(32 * 1024 * 1024, 1);
+    REQUIRE(buffer[1000] == 1);
+    REQUIRE(peak_rss() >= before);
+}
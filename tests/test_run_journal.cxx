@@ -0,0 +1,173 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "RunJournal.h"
+#include "TempDir.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+
+using namespace parallel;
+
+namespace fs = std::filesystem;
+
+static PluginTask make_task(const std::string& name, const std::string& in, const std::string& out) {
+    PluginTask task;
+    task.name = name;
+    task.inputfile = in;
+    task.outputfile = out;
+    return task;
+}
+
+static PluginResult make_result(const std::string& name, double elapsed) {
+    PluginResult result;
+    result.name = name;
+    result.elapsed_seconds = elapsed;
+    return result;
+}
+
+TEST_CASE("RunJournal::assign_id: repeated steps get distinct ids", "[journal]") {
+    TempDir dir("journal");
+    RunJournal journal(dir.file("run.journal"), false);
+    PluginTask a = make_task("Norm", "in.csv", "out.csv");
+    PluginTask b = make_task("Norm", "in2.csv", "out2.csv");
+
+    std::string first = journal.assign_id(a);
+    std::string second = journal.assign_id(a);
+    REQUIRE(first != second);
+    REQUIRE(journal.assign_id(b) != first);
+
+    // A new run assigns the same ids in the same order.
+    RunJournal again(dir.file("other.journal"), false);
+    REQUIRE(again.assign_id(a) == first);
+    REQUIRE(again.assign_id(a) == second);
+
+    // So does a config read again.
+    journal.restart_ids();
+    REQUIRE(journal.assign_id(a) == first);
+}
+
+TEST_CASE("RunJournal: resume skips recorded steps whose files are unchanged", "[journal]") {
+    TempDir dir("journal");
+    PluginTask task = make_task("Norm", dir.write("in.csv", "1,2"), dir.write("out.csv", "3"));
+    PluginTask pending = make_task("Norm", dir.file("in.csv"), dir.file("later.csv"));
+    {
+        RunJournal journal(dir.file("run.journal"), false);
+        task.journal_id = journal.assign_id(task);
+        pending.journal_id = journal.assign_id(pending);
+        REQUIRE(journal.record(task, make_result("Norm", 1.5)));
+    }
+
+    RunJournal resumed(dir.file("run.journal"), true);
+    REQUIRE(resumed.loaded_count() == 1);
+    REQUIRE(resumed.completed(task));
+    REQUIRE_FALSE(resumed.completed(pending));
+
+    dir.write("out.csv", "tampered");
+    REQUIRE_FALSE(resumed.completed(task));
+    dir.write("out.csv", "3");
+    dir.write("in.csv", "1,2,3");
+    REQUIRE_FALSE(resumed.completed(task));
+}
+
+TEST_CASE("RunJournal: a collected intermediate keeps its producer and readers completed", "[journal]") {
+    TempDir dir("journal");
+    PluginTask trim = make_task("Trim", dir.write("reads.fq", "ACGT"), dir.write("trimmed.fq", "ACG"));
+    PluginTask align = make_task("Align", dir.file("trimmed.fq"), dir.write("aligned.bam", "bam"));
+    PluginTask stats = make_task("Stats", dir.file("trimmed.fq"), dir.file("stats.txt"));
+    {
+        RunJournal journal(dir.file("run.journal"), false);
+        trim.journal_id = journal.assign_id(trim);
+        align.journal_id = journal.assign_id(align);
+        stats.journal_id = journal.assign_id(stats);
+        REQUIRE(journal.record(trim, make_result("Trim", 1.0)));
+        REQUIRE(journal.record(align, make_result("Align", 1.0)));
+        REQUIRE(journal.record_collected(dir.file("trimmed.fq"), {align}));
+    }
+    fs::remove(dir.file("trimmed.fq"));
+
+    RunJournal resumed(dir.file("run.journal"), true);
+    REQUIRE(resumed.completed(trim));
+    REQUIRE(resumed.completed(align));
+
+    // A reader that has to run again needs the file back.
+    dir.write("aligned.bam", "changed");
+    REQUIRE_FALSE(resumed.completed(trim));
+    REQUIRE_FALSE(resumed.completed(align));
+    dir.write("aligned.bam", "bam");
+
+    // So does one the journal has no record of.
+    {
+        RunJournal journal(dir.file("other.journal"), false);
+        dir.write("trimmed.fq", "ACG");
+        REQUIRE(journal.record(trim, make_result("Trim", 1.0)));
+        REQUIRE(journal.record_collected(dir.file("trimmed.fq"), {stats}));
+    }
+    fs::remove(dir.file("trimmed.fq"));
+    RunJournal partial(dir.file("other.journal"), true);
+    REQUIRE_FALSE(partial.completed(trim));
+
+    // Nor does a different file count as the one collected.
+    dir.write("trimmed.fq", "TTT");
+    REQUIRE_FALSE(resumed.completed(trim));
+    REQUIRE_FALSE(resumed.completed(align));
+}
+
+TEST_CASE("RunJournal: a fresh run discards old records", "[journal]") {
+    TempDir dir("journal");
+    PluginTask task = make_task("Norm", dir.write("in.csv", "1"), dir.write("out.csv", "2"));
+    {
+        RunJournal journal(dir.file("run.journal"), false);
+        task.journal_id = journal.assign_id(task);
+        journal.record(task, make_result("Norm", 0.1));
+    }
+    RunJournal fresh(dir.file("run.journal"), false);
+    REQUIRE(RunJournal::load(dir.file("run.journal")).empty());
+}
+
+TEST_CASE("RunJournal: a torn final record is ignored and terminated", "[journal]") {
+    TempDir dir("journal");
+    PluginTask task = make_task("Norm", dir.write("in.csv", "1"), dir.write("out.csv", "2"));
+    PluginTask next = make_task("Norm", dir.file("in.csv"), dir.file("out.csv"));
+    {
+        RunJournal journal(dir.file("run.journal"), false);
+        task.journal_id = journal.assign_id(task);
+        next.journal_id = journal.assign_id(next);
+        journal.record(task, make_result("Norm", 0.1));
+    }
+    std::ofstream(dir.file("run.journal"), std::ios::app) << "step\tNorm|x|y#0\tab";
+
+    RunJournal resumed(dir.file("run.journal"), true);
+    REQUIRE(resumed.loaded_count() == 1);
+    REQUIRE(resumed.record(next, make_result("Norm", 0.2)));
+    REQUIRE(RunJournal::load(dir.file("run.journal")).size() == 2);
+}
+
+TEST_CASE("RunJournal: forked workers append to the inherited journal", "[journal]") {
+    TempDir dir("journal");
+    RunJournal journal(dir.file("run.journal"), false);
+    std::vector<PluginTask> tasks;
+    for (int i = 0; i < 4; i++) {
+        PluginTask t = make_task("Work", "", dir.file("out" + std::to_string(i)));
+        t.journal_id = journal.assign_id(t);
+        tasks.push_back(t);
+    }
+
+    std::vector<pid_t> pids;
+    for (const auto& t : tasks) {
+        pid_t pid = fork();
+        if (pid == 0) _exit(journal.record(t, make_result(t.name, 0.0)) ? 0 : 1);
+        pids.push_back(pid);
+    }
+    for (pid_t pid : pids) {
+        int status;
+        waitpid(pid, &status, 0);
+        REQUIRE(WIFEXITED(status));
+        REQUIRE(WEXITSTATUS(status) == 0);
+    }
+
+    RunJournal resumed(dir.file("run.journal"), true);
+    REQUIRE(resumed.loaded_count() == 4);
+    for (const auto& t : tasks) REQUIRE(resumed.completed(t));
+}
@@ -0,0 +1,107 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include "SampleSweep.h"
+#include "DependencyGraph.h"
+#include "TempDir.h"
+
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace parallel;
+using Catch::Matchers::ContainsSubstring;
+
+namespace fs = std::filesystem;
+
+// Paths under dir, as a Prefix line would give them.
+static std::string prefix_of(const TempDir& dir) { return dir.path.string() + "/"; }
+
+static std::vector<PluginTask> drain(SweepSource& source) {
+    std::vector<PluginTask> tasks;
+    PluginTask task;
+    while (source.next(task)) tasks.push_back(task);
+    return tasks;
+}
+
+TEST_CASE("expand_sweep_line: replaces every placeholder", "[sweep]") {
+    REQUIRE(expand_sweep_line("Plugin A inputfile {sample}/{sample}.fq outputfile {path}.out", "s1", "d/s1.fq") ==
+            "Plugin A inputfile s1/s1.fq outputfile d/s1.fq.out");
+    REQUIRE(sample_name("data/s1.fastq") == "s1");
+    REQUIRE(sample_name("s2") == "s2");
+}
+
+TEST_CASE("SweepSource: one task per listed sample, under the prefix", "[sweep]") {
+    TempDir dir("sweep");
+    SweepBlock sweep;
+    sweep.prefix = prefix_of(dir);
+    sweep.samples = dir.write("samples.txt", "s1\n\n# not a sample\n  s2  \ns3\n");
+    sweep.plugin_line = "Plugin Align inputfile {sample}/reads.fq outputfile {sample}/out.bam memory=1G";
+    sweep.plugin_source_line = 7;
+
+    SweepSource source(sweep);
+    REQUIRE(source.error().empty());
+    auto tasks = drain(source);
+    REQUIRE(tasks.size() == 3);
+    REQUIRE(source.produced() == 3);
+    REQUIRE(tasks[1].name == "Align");
+    REQUIRE(tasks[1].inputfile == prefix_of(dir) + "s2/reads.fq");
+    REQUIRE(tasks[1].outputfile == prefix_of(dir) + "s2/out.bam");
+    REQUIRE(tasks[1].memory_hint == 1024ULL * 1024 * 1024);
+    REQUIRE(tasks[1].prefix == prefix_of(dir));
+    REQUIRE(tasks[1].source_line == 7);
+}
+
+TEST_CASE("SweepSource: glob matches are samples in sorted order", "[sweep]") {
+    TempDir dir("sweep");
+    dir.write("data/b.fq", "b");
+    dir.write("data/a.fq", "a");
+    dir.write("data/c.txt", "c");
+    SweepBlock sweep;
+    sweep.prefix = prefix_of(dir);
+    sweep.pattern = prefix_of(dir) + "data/*.fq";
+    sweep.plugin_line = "Plugin Count inputfile {path} outputfile out/{sample}.csv";
+
+    SweepSource source(sweep);
+    auto tasks = drain(source);
+    REQUIRE(tasks.size() == 2);
+    REQUIRE(tasks[0].inputfile == prefix_of(dir) + "data/a.fq");
+    REQUIRE(tasks[0].outputfile == prefix_of(dir) + "out/a.csv");
+    REQUIRE(tasks[1].outputfile == prefix_of(dir) + "out/b.csv");
+}
+
+TEST_CASE("SweepSource: an empty glob has no samples, a missing list is an error", "[sweep]") {
+    TempDir dir("sweep");
+    SweepBlock sweep;
+    sweep.plugin_line = "Plugin A inputfile {path} outputfile {sample}.out";
+
+    sweep.pattern = prefix_of(dir) + "*.none";
+    SweepSource empty(sweep);
+    REQUIRE(empty.error().empty());
+    REQUIRE(drain(empty).empty());
+
+    sweep.pattern.clear();
+    sweep.samples = prefix_of(dir) + "missing.txt";
+    SweepSource missing(sweep);
+    REQUIRE_THAT(missing.error(), ContainsSubstring("missing.txt"));
+    REQUIRE(drain(missing).empty());
+}
+
+TEST_CASE("flatten_config: a Sweep is expanded into one task per sample", "[sweep][graph]") {
+    TempDir dir("sweep");
+    dir.write("samples.txt", "s1\ns2\n");
+    std::string config = dir.write("main.txt",
+        "Prefix " + dir.path.string() + "\n"
+        "Sweep samples=samples.txt workers=2\n"
+        "Plugin A inputfile {sample}.in outputfile {sample}.mid\n"
+        "EndSweep\n"
+        "Plugin B inputfile s2.mid outputfile final\n");
+
+    FlattenResult flat = flatten_config(config);
+    REQUIRE(flat.errors.empty());
+    REQUIRE(flat.tasks.size() == 3);
+    REQUIRE(flat.tasks[1].outputfile == prefix_of(dir) + "s2.mid");
+
+    TaskGraph graph = build_task_graph(flat.tasks);
+    REQUIRE(graph.dependencies[2] == std::vector<size_t>{1});
+}
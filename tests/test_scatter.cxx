@@ -0,0 +1,174 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include "Scatter.h"
+#include "TempDir.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+using namespace parallel;
+using Catch::Matchers::ContainsSubstring;
+
+namespace fs = std::filesystem;
+
+static std::string slurp(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+static std::string numbered_lines(int n) {
+    std::string text;
+    for (int i = 1; i <= n; i++) text += "row" + std::to_string(i) + "\n";
+    return text;
+}
+
+static ScatterBlock scatter_into(int shards) {
+    ScatterBlock scatter;
+    scatter.shards = shards;
+    return scatter;
+}
+
+TEST_CASE("split_input: by lines, shards of about equal size that rejoin to the input", "[scatter]") {
+    TempDir dir("scatter");
+    std::string text = numbered_lines(100);
+    std::string input = dir.write("rows.txt", text);
+    std::string error;
+
+    auto shards = split_input(input, dir.file("shards"), scatter_into(4), error);
+    REQUIRE(error.empty());
+    REQUIRE(shards.size() == 4);
+    REQUIRE(shards[0] == dir.file("shards/in-00000.txt"));
+
+    std::string joined;
+    for (const auto& shard : shards) {
+        std::string part = slurp(shard);
+        REQUIRE(part.back() == '\n');
+        REQUIRE(part.size() > text.size() / 8);
+        joined += part;
+    }
+    REQUIRE(joined == text);
+}
+
+TEST_CASE("split_input: by records, cuts only between whole records", "[scatter]") {
+    TempDir dir("scatter");
+    std::string text;
+    for (int r = 0; r < 10; r++) text += "@r" + std::to_string(r) + "\nACGT\n+\nIIII\n";
+    std::string input = dir.write("reads.fq", text);
+    ScatterBlock scatter = scatter_into(3);
+    scatter.unit = ShardUnit::Records;
+    std::string error;
+
+    auto shards = split_input(input, dir.file("shards"), scatter, error);
+    REQUIRE(error.empty());
+    REQUIRE(shards.size() == 3);
+    std::string joined;
+    for (const auto& shard : shards) {
+        std::string part = slurp(shard);
+        REQUIRE(part[0] == '@');
+        REQUIRE(std::count(part.begin(), part.end(), '\n') % 4 == 0);
+        joined += part;
+    }
+    REQUIRE(joined == text);
+}
+
+TEST_CASE("split_input: by bytes, cuts anywhere", "[scatter]") {
+    TempDir dir("scatter");
+    std::string text(1000, 'x');
+    std::string input = dir.write("blob.bin", text);
+    ScatterBlock scatter = scatter_into(4);
+    scatter.unit = ShardUnit::Bytes;
+    std::string error;
+
+    auto shards = split_input(input, dir.file("shards"), scatter, error);
+    REQUIRE(error.empty());
+    REQUIRE(shards.size() == 4);
+    for (const auto& shard : shards) REQUIRE(fs::file_size(shard) == 250);
+}
+
+TEST_CASE("split_input: header lines are repeated in every shard", "[scatter]") {
+    TempDir dir("scatter");
+    std::string input = dir.write("table.csv", "id,value\n" + numbered_lines(20));
+    ScatterBlock scatter = scatter_into(2);
+    scatter.header_lines = 1;
+    std::string error;
+
+    auto shards = split_input(input, dir.file("shards"), scatter, error);
+    REQUIRE(shards.size() == 2);
+    REQUIRE(slurp(shards[0]).rfind("id,value\nrow1\n", 0) == 0);
+    REQUIRE(slurp(shards[1]).rfind("id,value\nrow", 0) == 0);
+}
+
+TEST_CASE("split_input: a small input yields fewer shards, and stale shards go", "[scatter]") {
+    TempDir dir("scatter");
+    std::string shard_dir = dir.file("shards");
+    std::string error;
+
+    auto shards = split_input(dir.write("rows.txt", numbered_lines(20)), shard_dir, scatter_into(8), error);
+    REQUIRE(shards.size() == 8);
+
+    shards = split_input(dir.write("rows.txt", "a\nb\n"), shard_dir, scatter_into(8), error);
+    REQUIRE(error.empty());
+    REQUIRE(shards.size() == 2);
+    REQUIRE_FALSE(fs::exists(dir.file("shards/in-00002.txt")));
+}
+
+TEST_CASE("split_input: a missing input is an error", "[scatter]") {
+    TempDir dir("scatter");
+    std::string error;
+    auto shards = split_input(dir.file("nope.txt"), dir.file("shards"), scatter_into(2), error);
+    REQUIRE(shards.empty());
+    REQUIRE_THAT(error, ContainsSubstring("nope.txt"));
+}
+
+TEST_CASE("shard_tasks: one task per shard writing a part file", "[scatter]") {
+    PluginTask task;
+    task.name = "Filter";
+    task.inputfile = "data/reads.fq";
+    task.outputfile = "data/filtered.fq";
+    task.memory_hint = 1024;
+    task.expected_seconds = 60;
+    task.journal_id = "Filter#0";
+
+    auto tasks = shard_tasks(task, {"data/filtered.fq.shards/in-00000.fq", "data/filtered.fq.shards/in-00001.fq"});
+    REQUIRE(tasks.size() == 2);
+    REQUIRE(tasks[1].name == "Filter");
+    REQUIRE(tasks[1].inputfile == "data/filtered.fq.shards/in-00001.fq");
+    REQUIRE(tasks[1].outputfile == "data/filtered.fq.shards/part-00001.fq");
+    REQUIRE(tasks[1].memory_hint == 1024);
+    REQUIRE(tasks[1].expected_seconds == 30);
+    REQUIRE(tasks[1].journal_id.empty());
+}
+
+TEST_CASE("concat_shards: keeps only the first part's header", "[scatter]") {
+    TempDir dir("scatter");
+    std::vector<std::string> parts = {
+        dir.write("part-0.csv", "id,value\n1,a\n"),
+        dir.write("part-1.csv", "id,value\n2,b\n"),
+    };
+    std::string error;
+    REQUIRE(concat_shards(parts, dir.file("out.csv"), 1, error));
+    REQUIRE(slurp(dir.file("out.csv")) == "id,value\n1,a\n2,b\n");
+
+    REQUIRE(concat_shards(parts, dir.file("all.csv"), 0, error));
+    REQUIRE(slurp(dir.file("all.csv")) == "id,value\n1,a\nid,value\n2,b\n");
+}
+
+TEST_CASE("concat_shards: a missing part is an error", "[scatter]") {
+    TempDir dir("scatter");
+    std::string error;
+    REQUIRE_FALSE(concat_shards({dir.write("part-0.txt", "x\n"), dir.file("part-1.txt")}, dir.file("out.txt"), 0, error));
+    REQUIRE_THAT(error, ContainsSubstring("part-1.txt"));
+}
+
+TEST_CASE("write_shard_list: one part per line", "[scatter]") {
+    TempDir dir("scatter");
+    std::string error;
+    REQUIRE(write_shard_list({"a/part-00000.txt", "a/part-00001.txt"}, dir.file("shards.txt"), error));
+    REQUIRE(slurp(dir.file("shards.txt")) == "a/part-00000.txt\na/part-00001.txt\n");
+}
@@ -0,0 +1,87 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "Watch.h"
+#include "TempDir.h"
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+using namespace parallel;
+
+namespace fs = std::filesystem;
+
+static PluginTask watched_step(const std::string& name, const std::string& in, const std::string& out) {
+    PluginTask task;
+    task.name = name;
+    task.inputfile = in;
+    task.outputfile = out;
+    return task;
+}
+
+// reads.fq -> Trim -> trimmed.fq -> Align (align.params) -> aligned.bam -> Stats -> stats.txt
+//                                  Plot (plot.params) -> plot.png
+static std::vector<PluginTask> pipeline() {
+    return {
+        watched_step("Trim", "reads.fq", "trimmed.fq"),
+        watched_step("Align", "align.params", "aligned.bam"),
+        watched_step("Stats", "aligned.bam", "stats.txt"),
+        watched_step("Plot", "plot.params", "plot.png"),
+    };
+}
+
+TEST_CASE("Watch: sources are the files no step writes", "[watch]") {
+    std::vector<PluginTask> steps = pipeline();
+    REQUIRE(source_inputs(steps) == std::vector<std::string>{"reads.fq", "align.params", "plot.params"});
+
+    // A file a later step overwrites would make every run cause another.
+    steps.push_back(watched_step("Refresh", "stats.txt", "plot.params"));
+    REQUIRE(source_inputs(steps) == std::vector<std::string>{"reads.fq", "align.params"});
+}
+
+TEST_CASE("Watch: a change re-runs its readers and everything downstream", "[watch]") {
+    std::vector<PluginTask> steps = pipeline();
+    REQUIRE(affected_steps(steps, {"align.params"}) == std::vector<size_t>{1, 2});
+    REQUIRE(affected_steps(steps, {"./plot.params"}) == std::vector<size_t>{3});
+    REQUIRE(affected_steps(steps, {"unrelated.txt"}).empty());
+    REQUIRE(affected_steps(steps, {}, {0}) == std::vector<size_t>{0});
+
+    // A later writer of a re-run step's output has to run after it again.
+    steps.push_back(watched_step("Annotate", "notes.txt", "stats.txt"));
+    REQUIRE(affected_steps(steps, {"align.params"}) == std::vector<size_t>{1, 2, 4});
+}
+
+TEST_CASE("Watch: an edited config line counts as changed", "[watch]") {
+    std::vector<PluginTask> before = pipeline();
+    std::vector<PluginTask> now = pipeline();
+    REQUIRE(changed_steps(before, now).empty());
+
+    now[1].memory_hint = 1 << 30;
+    now.push_back(watched_step("Report", "stats.txt", "report.html"));
+    REQUIRE(changed_steps(before, now) == std::set<size_t>{1, 4});
+}
+
+TEST_CASE("FileWatcher: reports changed contents, not saves", "[watch]") {
+    TempDir dir("watch");
+    std::string params = dir.write("align.params", "k=21\n");
+    dir.write("other.txt", "x\n");
+    FileWatcher watcher(50);
+    REQUIRE(watcher.watch(params));
+    REQUIRE(watcher.error().empty());
+
+    dir.write("other.txt", "y\n");
+    dir.write("align.params", "k=21\n");
+    REQUIRE(watcher.wait(300).empty());
+
+    std::thread writer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        // Saved the way editors do: a new file renamed over the old.
+        dir.write(".align.params.swp", "k=31\n");
+        fs::rename(dir.file(".align.params.swp"), params);
+    });
+    std::set<std::string> changed = watcher.wait(2000);
+    writer.join();
+    REQUIRE(changed == std::set<std::string>{params});
+    REQUIRE(watcher.wait(100).empty());
+}